@@ -0,0 +1,85 @@
+#include "BillboardBatcher.h"
+#include "RenderState.h"
+#include "Profiler.h"
+#include <string.h>
+
+
+
+// Hörnens riktning längs höger- och uppåtvektorerna, och deras texturkoordinater
+static const float cornerRight[4] = { -1, 1, 1, -1 };
+static const float cornerUp[4] = { -1, -1, 1, 1 };
+static const float cornerU[4] = { 0.01f, 0.99f, 0.99f, 0.01f };	// Som drawSun, en bit in från kanten
+static const float cornerV[4] = { 0.01f, 0.01f, 0.99f, 0.99f };
+
+
+
+BillboardBatcher::BillboardBatcher()
+{
+	count = 0;
+}
+
+
+
+void BillboardBatcher::build(const float *modelview, const Billboard *billboards, unsigned newCount)
+{
+	PROFILE_SCOPE("BillboardBatcher::build");
+
+	count = newCount;
+	if (vertices.size() < count * 4)
+		vertices.resize(count * 4);
+
+	// Raderna i modelview-matrisens rotationsdel är kamerans axlar i världskoordinater.
+	// Hörnens riktningar räknas en gång, så att varje hörn bara blir mittpunkt plus riktning gånger storlek.
+	float corners[4][3];
+	for (int corner = 0; corner < 4; corner++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+			corners[corner][axis] = cornerRight[corner] * modelview[axis * 4] + cornerUp[corner] * modelview[axis * 4 + 1];
+	}
+
+	Vertex *out = vertices.data();
+	for (unsigned i = 0; i < count; i++)
+	{
+		const Billboard &billboard = billboards[i];
+		for (int corner = 0; corner < 4; corner++)
+		{
+			Vertex &vertex = out[i * 4 + corner];
+			vertex.x = billboard.x + corners[corner][0] * billboard.size;
+			vertex.y = billboard.y + corners[corner][1] * billboard.size;
+			vertex.z = billboard.z + corners[corner][2] * billboard.size;
+			vertex.u = cornerU[corner];
+			vertex.v = cornerV[corner];
+			memcpy(vertex.color, billboard.color, 4);
+		}
+	}
+}
+
+
+
+void BillboardBatcher::draw() const
+{
+	if (count == 0)
+		return;
+
+	const Vertex *data = vertices.data();
+	enableClientArray(GL_VERTEX_ARRAY);
+	enableClientArray(GL_TEXTURE_COORD_ARRAY);
+	enableClientArray(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), &data->x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &data->u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), data->color);
+	glDrawArrays(GL_QUADS, 0, count * 4);
+	disableClientArray(GL_COLOR_ARRAY);
+	disableClientArray(GL_TEXTURE_COORD_ARRAY);
+	disableClientArray(GL_VERTEX_ARRAY);
+
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", count * 4);
+}
+
+
+
+unsigned BillboardBatcher::size() const
+{
+	return count;
+}
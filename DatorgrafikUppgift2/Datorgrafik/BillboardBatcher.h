@@ -0,0 +1,50 @@
+#ifndef BILLBOARDBATCHER_H
+#define BILLBOARDBATCHER_H
+
+
+
+#include "Support.h"
+#include <vector>
+
+
+
+// En texturerad kvadrat som alltid vänds mot kameran, som solen i drawSun
+struct Billboard
+{
+	float x, y, z;
+	float size;				// Halva kantlängden
+	GLubyte color[4];
+};
+
+
+
+// Spänner upp många billboards mot kameran på en gång och ritar dem med ett enda
+// glDrawArrays, i stället för en glBegin/glEnd per kvadrat. Textur, blandning och
+// djupbuffert sätts av den som ritar. Kvadraterna sorteras inte, så genomskinliga
+// billboards ser bara rätt ut med additiv blandning eller utan djupskrivning.
+class BillboardBatcher
+{
+public:
+	BillboardBatcher();
+
+	// Kamerans höger- och uppåtriktning tas ur modelview-matrisen, som i drawSun
+	void build(const float *modelview, const Billboard *billboards, unsigned count);
+	void draw() const;
+
+	unsigned size() const;					// Antal billboards i senaste build
+
+private:
+	struct Vertex
+	{
+		float x, y, z;
+		float u, v;
+		GLubyte color[4];
+	};
+
+	std::vector<Vertex> vertices;			// Fyra per billboard
+	unsigned count;
+};
+
+
+
+#endif
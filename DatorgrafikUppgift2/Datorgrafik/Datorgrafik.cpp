@@ -1,6 +1,19 @@
 #include "Support.h"
+#include "FrameLoop.h"
+#include "Profiler.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
+#include "NBody.h"
+#include "KeplerOrbits.h"
+#include "RingSystem.h"
+#include "ParticleSystem.h"
+#include "BillboardBatcher.h"
+#include "ThreadPool.h"
+#include "OrbitBenchmark.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <vector>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
@@ -10,11 +23,33 @@
 
 
 // Data som delas mellan programmets olika delar
+static const unsigned bodyCount = 5;	// Solen och fyra planeter
+static const unsigned asteroidCount = 4000;
+static const unsigned ringParticles = 200000;
+
+
+
 struct Shared
 {
-	float time;
+	double time;					// I double, annars tappar banornas medelanomali precision efter en stund
+	double previousTime, renderTime;	// Simuleringstiden i förra steget och den interpolerade tiden vi ritar med.
 	bool pause;
 	float distance, distanceDelta;
+	float previousDistance, renderDistance;
+	FrameLoop frameLoop;			// Fast simuleringssteg oberoende av bildhastigheten.
+	RenderQueue queue;				// Ritanropen samlas här och sorteras innan de skickas till GL.
+	NBody bodies;					// Solen och planeterna rör sig med riktig gravitation.
+	unsigned sun, planets[4];
+	float previousBodies[bodyCount][3], renderBodies[bodyCount][3];	// Som previousTime och renderTime, per kropp
+	KeplerOrbits moons;				// Månarna och asteroiderna följer fasta banor som räknas direkt
+	KeplerOrbits asteroids;			// för renderTime, så de behöver ingen interpolation.
+	std::vector<float> asteroidVertices;
+	RingSystem rings;				// Planet 4:s ringar som partiklar
+	ParticleSystem particles;		// Flammor från solen
+	BillboardBatcher billboards;
+	unsigned flares;
+	double particleTime;			// renderTime när partiklarna senast uppdaterades
+	ThreadPool threadPool;
 	GLUquadric *quadric;
 	GLuint sunTexture, planetTexture, gasPlanetTexture, gasPlanetTexture2, moonTexture1,
 		moonTexture2, earthPlanetTexture, earthCloudTexture, ringsTexture;
@@ -24,13 +59,164 @@ struct Shared shared;
 
 
 
+// Planeternas startlägen (x, y, z) och massor. Lägena är desamma som i den gamla animationen,
+// och hastigheten väljs så att banan blir en cirkel kring solen. Med tyngre planeter
+// störs banorna så mycket att planet 3 till slut kastas ut.
+static const float sunMass = 20000;
+static const float planetStart[4][4] =
+{
+	{ 20, 0, 0, 2 },
+	{ 10, 0, 35, 6 },
+	{ 0, 0, 55, 3 },
+	{ -40, 0, -75, 8 }
+};
+
+
+
+// Vår egen underfunktion som lägger solen och planeterna i N-kroppssimuleringen
+void initializeBodies()
+{
+	float velocities[4][3];
+	float momentum[3] = { 0, 0, 0 };
+	for (int i = 0; i < 4; i++)
+	{
+		float x = planetStart[i][0], z = planetStart[i][2];
+		float radius = sqrtf(x * x + z * z);
+		float angularSpeed = sqrtf(sunMass / (radius * radius * radius));	// G = 1
+		velocities[i][0] = z * angularSpeed;	// Moturs sett ovanifrån, som glRotatef kring y
+		velocities[i][1] = 0;
+		velocities[i][2] = -x * angularSpeed;
+		for (int c = 0; c < 3; c++)
+			momentum[c] += velocities[i][c] * planetStart[i][3];
+	}
+
+	// Solen får motsatt rörelsemängd så att systemets tyngdpunkt står still
+	shared.bodies.clear();
+	shared.bodies.setSoftening(0.01f);
+	shared.sun = shared.bodies.add(0, 0, 0, -momentum[0] / sunMass, -momentum[1] / sunMass, -momentum[2] / sunMass, sunMass);
+	for (int i = 0; i < 4; i++)
+		shared.planets[i] = shared.bodies.add(planetStart[i][0], planetStart[i][1], planetStart[i][2], velocities[i][0], velocities[i][1], velocities[i][2], planetStart[i][3]);
+
+	for (unsigned i = 0; i < bodyCount; i++)
+	{
+		shared.previousBodies[i][0] = shared.renderBodies[i][0] = shared.bodies.x()[i];
+		shared.previousBodies[i][1] = shared.renderBodies[i][1] = shared.bodies.y()[i];
+		shared.previousBodies[i][2] = shared.renderBodies[i][2] = shared.bodies.z()[i];
+	}
+}
+
+
+
+// Månarnas banor kring sina planeter: storaxel, excentricitet, inklination, nodlinje,
+// periapsis (grader) och varv i grader per tidsenhet. Farterna är desamma som i den gamla
+// animationen; planeterna är för lätta för att hålla månar i den takten med riktig gravitation.
+static const float moonOrbits[4][6] =
+{
+	{ 8, 0.1f, 45, 135, 0, 70 },		// Planet 2 Måne 1, lutar 45 grader mot xz-planet
+	{ 10, 0.3f, 100, 30, 60, 90 },		// Planet 2 Måne 2, nästan polär och baklänges
+	{ 5, 0, 90, 0, 0, 100 },			// Planet 3 Måne, går över polerna
+	{ 8, 0.05f, 0, 0, 0, 70 }			// Planet 4 Måne
+};
+
+
+
+static float random01()
+{
+	return rand() / (RAND_MAX + 1.0f);
+}
+
+
+
+// Vår egen underfunktion som lägger upp månarnas och asteroidbältets Keplerbanor
+void initializeOrbits()
+{
+	const float degrees = 3.14159265f / 180;
+
+	shared.moons.clear();
+	for (int i = 0; i < 4; i++)
+	{
+		const float *orbit = moonOrbits[i];
+		shared.moons.add(orbit[0], orbit[1], orbit[2] * degrees, orbit[3] * degrees, orbit[4] * degrees, 0, orbit[5] * degrees);
+	}
+
+	// Bältet ligger mellan planet 2 och 3, med lätt elliptiska och lutande banor
+	shared.asteroids.clear();
+	for (unsigned i = 0; i < asteroidCount; i++)
+	{
+		float semiMajorAxis = 44 + 6 * random01();
+		shared.asteroids.add(semiMajorAxis, 0.05f * random01(), 3 * degrees * random01(), 360 * degrees * random01(),
+			360 * degrees * random01(), 360 * degrees * random01(), KeplerOrbits::meanMotionFor(sunMass, semiMajorAxis));
+	}
+	shared.asteroidVertices.resize(asteroidCount * 3);
+	shared.asteroids.setThreadPool(&shared.threadPool);
+
+	shared.moons.evaluate(0);
+	shared.asteroids.evaluate(0);
+}
+
+
+
+// Vår egen underfunktion som skapar ringpartiklarna. Färgerna och tätheten tas från
+// ringtexturens mittrad, från planetens mitt och ut till kanten på den gamla kvadraten.
+// Som för månarna är planeten för lätt för ringar som snurrar så här fort.
+void initializeRings()
+{
+	const float ringRadius = 20, ringMass = 400;
+
+	GLint width = 0, height = 0;
+	bindTexture(shared.ringsTexture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	std::vector<GLubyte> pixels(width * height * 4);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	shared.rings.setThreadPool(&shared.threadPool);
+	if (!pixels.empty())
+		shared.rings.create(ringParticles, 6, ringRadius, ringMass, &pixels[(height / 2 * width + width / 2) * 4], width / 2);
+}
+
+
+
+// Vår egen underfunktion som skapar solens flammor: gula gnistor som skjuts ut från ytan,
+// bromsas upp och blir röda medan de slocknar
+void initializeParticles()
+{
+	ParticleEmitterSettings flares;
+	flares.spawnRadius = 4;
+	flares.rate = 400;
+	flares.lifetimeMin = 1;
+	flares.lifetimeMax = 3;
+	flares.speedMin = 4;
+	flares.speedMax = 10;
+	flares.drag = 0.5f;
+	ParticleCurve size = { 1.5f, 2.5f, 0.5f }, green = { 0.9f, 0.6f, 0.3f }, blue = { 0.5f, 0.2f, 0.05f }, alpha = { 0.8f, 0.5f, 0 };
+	flares.size = size;
+	flares.green = green;
+	flares.blue = blue;
+	flares.alpha = alpha;
+
+	shared.particles.clear();
+	shared.particles.setThreadPool(&shared.threadPool);
+	shared.flares = shared.particles.addEmitter(flares, 2000);
+	shared.particleTime = 0;
+}
+
+
+
 // Vår egen underfunktion som initierar det som behövs innan renderingen börjar
 void initialize()
 {
 	shared.time = 0;
+	shared.previousTime = 0;
+	shared.renderTime = 0;
 	shared.pause = false;
 	shared.distance = 50;
 	shared.distanceDelta = 0;
+	shared.previousDistance = 50;
+	shared.renderDistance = 50;
+	initializeBodies();
+	initializeOrbits();
+	initializeParticles();
 
 	shared.quadric = gluNewQuadric();
 	gluQuadricTexture(shared.quadric, true);
@@ -44,81 +230,190 @@ void initialize()
 	loadTexture("EarthClouds.png", &shared.earthCloudTexture);
 	loadTexture("RockyPlanet3.png", &shared.moonTexture2);
 	loadTexture("Rings.png", &shared.ringsTexture);
+	renderStateReset();												// loadTexture binder texturer förbi tillståndscachen
+	initializeRings();
 
-	glEnable(GL_DEPTH_TEST);										// Jag ser till att Z-buffern är aktiverad.
-	glEnable(GL_COLOR_MATERIAL);									// Jag aktiverar material.
+	enableState(GL_DEPTH_TEST);										// Jag ser till att Z-buffern är aktiverad.
+	enableState(GL_COLOR_MATERIAL);									// Jag aktiverar material.
 	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);		// Definierar material
 }
 
 
 
+// Vår egen underfunktion som ritar en sfär med den delade quadricen
+void drawSphere(const DrawPacket &packet)
+{
+	gluSphere(shared.quadric, packet.size, 32, 32);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 32 * 33 * 2);   // 32 quad strips med 33 hörnpar vardera
+}
+
+
+
+// Vår egen underfunktion som ritar asteroiderna som punkter, relativt solen
+void drawAsteroids(const DrawPacket &)
+{
+	const float *x = shared.asteroids.x(), *y = shared.asteroids.y(), *z = shared.asteroids.z();
+	float *vertices = shared.asteroidVertices.data();
+	for (unsigned i = 0; i < asteroidCount; i++)
+	{
+		vertices[i * 3] = x[i];
+		vertices[i * 3 + 1] = y[i];
+		vertices[i * 3 + 2] = z[i];
+	}
+
+	disableState(GL_LIGHTING);
+	disableState(GL_TEXTURE_2D);
+	glColor3f(0.6f, 0.55f, 0.5f);
+	glPointSize(2);
+	enableClientArray(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glDrawArrays(GL_POINTS, 0, asteroidCount);
+	disableClientArray(GL_VERTEX_ARRAY);
+	enableState(GL_TEXTURE_2D);
+	enableState(GL_LIGHTING);
+
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", asteroidCount);
+}
+
+
+
+// Vår egen underfunktion som ritar ringpartiklarna, utan ljus och textur
+void drawRingParticles(const DrawPacket &)
+{
+	disableState(GL_LIGHTING);
+	disableState(GL_TEXTURE_2D);
+	shared.rings.draw();
+	enableState(GL_TEXTURE_2D);
+	enableState(GL_LIGHTING);
+}
+
+
+
+// Vår egen underfunktion som ritar partiklarna som billboards med additiv blandning, som solen
+void drawParticles(const DrawPacket &packet)
+{
+	disableState(GL_CULL_FACE);
+	setDepthMask(GL_FALSE);
+	disableState(GL_LIGHTING);
+	enableState(GL_BLEND);
+	setBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+	shared.billboards.build(packet.matrix, shared.particles.billboards(), shared.particles.billboardCount());
+	shared.billboards.draw();
+
+	setDepthMask(GL_TRUE);
+	disableState(GL_BLEND);
+}
+
+
+
+// Vår egen underfunktion som ritar solen via ritkön
+void drawSunPacket(const DrawPacket &packet)
+{
+	drawSun(packet.texture);
+}
+
+
+
+// Vår egen underfunktion som lägger ett objekt i ritkön med den aktuella modelview-matrisen
+void queueDraw(DrawFunction draw, GLuint texture, float size, bool transparent = false, float alpha = 1, bool lit = true, unsigned char pass = 0)
+{
+	DrawPacket packet;
+	captureModelview(packet.matrix);
+	packet.color[0] = 1;
+	packet.color[1] = 1;
+	packet.color[2] = 1;
+	packet.color[3] = alpha;
+	packet.texture = texture;
+	packet.lit = lit;
+	packet.transparent = transparent;
+	packet.pass = pass;
+	packet.draw = draw;
+	packet.size = size;
+	shared.queue.add(packet);
+}
+
+
+
+// Vår egen underfunktion som flyttar till en kropps interpolerade position
+void translateToBody(unsigned body)
+{
+	glTranslatef(shared.renderBodies[body][0], shared.renderBodies[body][1], shared.renderBodies[body][2]);
+}
+
+
+
+// Vår egen underfunktion som flyttar till en månes läge i sin bana kring planeten
+void translateToMoon(unsigned moon)
+{
+	glTranslatef(shared.moons.x()[moon], shared.moons.y()[moon], shared.moons.z()[moon]);
+}
+
+
+
 // Vår egen underfunktion som ritar ut scenen
 void drawScene()
 {
+	PROFILE_SCOPE("drawScene");
+
+	shared.queue.clear();
+
 	// Initiala renderingstillstånd
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_LIGHTING);								// Jag aktiverar ljussystemet.
-	glEnable(GL_LIGHT1);								// Aktiverar ljus med index 1.
-	glEnable(GL_BLEND);									// Aktiverar Alpha blending
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);	// Definierar blending.
+	enableState(GL_CULL_FACE);
+	enableState(GL_DEPTH_TEST);
+	enableState(GL_TEXTURE_2D);
+	enableState(GL_LIGHTING);							// Jag aktiverar ljussystemet.
+	enableState(GL_LIGHT1);								// Aktiverar ljus med index 1.
+	enableState(GL_BLEND);								// Aktiverar Alpha blending
+	setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);	// Definierar blending.
 	glColor4f(1, 1, 1, 1);
 	GLfloat lightColor[] = { 1.0, 1.0, 1.0 };			// Definierar ljus
 	GLfloat lightPosition[] = { 0, 0, 0 };
 	glLightfv(GL_LIGHT1, GL_DIFFUSE, lightColor);
 	glLightfv(GL_LIGHT1, GL_POSITION, lightPosition);
 
-	// Rita planet
-	glRotatef(shared.time * 50, 0, 1, 0);	// Transformationer till planeten
-	glTranslatef(20, 0, 0);
+	// Rita planet. Planeternas banor kommer från N-kroppssimuleringen, månarnas från Keplerbanor,
+	// och bara deras egen rotation animeras.
+	glPushMatrix();
+
+	translateToBody(shared.planets[0]);	// Transformationer till planeten
 	glRotatef(90, 1, 0, 0);
-	glRotatef(shared.time * -50, 0, 0, 1);
+	glRotatef(float(shared.renderTime * -50), 0, 0, 1);
 
-	glBindTexture(GL_TEXTURE_2D, shared.planetTexture);
-	gluSphere(shared.quadric, 3, 32, 32);
+	queueDraw(drawSphere, shared.planetTexture, 3);
 
-	glRotatef(shared.time * 50, 0, 0, 1);	// Jag ogör alla transformationer till planeten efter den har ritats ut.
-	glRotatef(-90, 1, 0, 0);
-	glTranslatef(-20, 0, 0);
-	glRotatef(shared.time * -50, 0, 1, 0);
+	glPopMatrix();
 
 	// Planet 2
 	glPushMatrix();											// Jag använder hierarkiska transformationer
 
-	glRotatef(shared.time * 40, 0, 1, 0);
-	glTranslatef(10, 0, 35);
+	translateToBody(shared.planets[1]);
 
 	glPushMatrix();
 
-	glRotatef(shared.time * 20, 0, 1, 0);
+	glRotatef(float(shared.renderTime * 20), 0, 1, 0);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.gasPlanetTexture);
-	gluSphere(shared.quadric, 5, 32, 32);
+	queueDraw(drawSphere, shared.gasPlanetTexture, 5);
 
 	glPopMatrix();
 
 	// Planet 2 Måne 1
 	glPushMatrix();
 
-	glRotatef(shared.time * 70, 1, 1, 0);			// Månen roterar 45 grader mot y planet
-	glTranslatef(0, 0, 8);
+	translateToMoon(0);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.moonTexture1);
-	gluSphere(shared.quadric, 1, 32, 32);
+	queueDraw(drawSphere, shared.moonTexture1, 1);
 
 	glPopMatrix();
 
 	// Planet 2 Måne 2
 	glPushMatrix();
 
-	glRotatef(shared.time * 20, 1, 0, 0);				// roterar kring x, y och z i olika hastighet
-	glRotatef(shared.time * 90, 0, 1, 0);
-	glRotatef(shared.time * 60, 0, 0, 1);
-	glTranslatef(10, 0, 0);
+	translateToMoon(1);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.moonTexture1);
-	gluSphere(shared.quadric, 0.7, 32, 32);
+	queueDraw(drawSphere, shared.moonTexture1, 0.7f);
 
 	glPopMatrix();
 	glPopMatrix();
@@ -126,91 +421,66 @@ void drawScene()
 	// Planet 3
 	glPushMatrix();
 
-	glRotatef(shared.time * 70, 0, 1, 0);
-	glTranslatef(0, 0, 55);
+	translateToBody(shared.planets[2]);
 
 	glPushMatrix();
 
-	glRotatef(shared.time * -30, 0, 1, 0);
+	glRotatef(float(shared.renderTime * -30), 0, 1, 0);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.earthPlanetTexture);
-	gluSphere(shared.quadric, 3, 32, 32);
-	glRotatef(shared.time * 40, 0, 0, 1);
-	glColor4f(1, 1, 1, 0.5);
-	glBindTexture(GL_TEXTURE_2D, shared.earthCloudTexture);		// Moln som roterar mot planetens rotation
-	gluSphere(shared.quadric, 3.1, 32, 32);
-	glColor4f(1, 1, 1, 1);
+	queueDraw(drawSphere, shared.earthPlanetTexture, 3);
+	glRotatef(float(shared.renderTime * 40), 0, 0, 1);
+	queueDraw(drawSphere, shared.earthCloudTexture, 3.1f, true, 0.5f);		// Moln som roterar mot planetens rotation
 
 	glPopMatrix();
 
 	// Planet 3 Måne
-	glRotatef(shared.time * -100, 0, 0, 1);
-	glTranslatef(0, 5, 0);
+	translateToMoon(2);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.moonTexture2);
-	gluSphere(shared.quadric, 0.8, 32, 32);
+	queueDraw(drawSphere, shared.moonTexture2, 0.8f);
 
 	glPopMatrix();
 
 	// Planet 4
 	glPushMatrix();
 
-	glRotatef(shared.time * 40, 0, 1, 0);
-	glTranslatef(-40, 0, -75);
+	translateToBody(shared.planets[3]);
 
 	glPushMatrix();
 
-	glRotatef(shared.time * -30, 0, 1, 0);
+	glRotatef(float(shared.renderTime * -30), 0, 1, 0);
 	glScalef(1, 1.2, 1);					// Jag använder en skalnings transformation i y ledet.
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.gasPlanetTexture2);
-	gluSphere(shared.quadric, 6, 32, 32);
+	queueDraw(drawSphere, shared.gasPlanetTexture2, 6);
 
 	glPopMatrix();
 
 	// Planet 4 Måne
 	glPushMatrix();
 
-	glRotatef(shared.time * 70, 0, 1, 0);
-	glTranslatef(0, 0, 8);
+	translateToMoon(3);
 	glRotatef(90, 1, 0, 0);
-	glBindTexture(GL_TEXTURE_2D, shared.moonTexture1);
-	gluSphere(shared.quadric, 1, 32, 32);
+	queueDraw(drawSphere, shared.moonTexture1, 1);
 
 	glPopMatrix();
 
 	// Planet 4 Ringar
-	glDisable(GL_LIGHT1);	// Jag avaktiverar ljuset.
-	glBindTexture(GL_TEXTURE_2D, shared.ringsTexture);	// Jag binder en textur till en kvadrat som spinner runt planeten
-	glRotatef(shared.time * -30, 0, 1, 0);
-	glBegin(GL_QUADS);
-
-	// Toppen
-	glTexCoord2f(0, 0);
-	glVertex3f(-20.0, 0, -20.0);
-	glTexCoord2f(1.0, 0);
-	glVertex3f(-20.0, 0, 20.0);
-	glTexCoord2f(1.0, 1.0);
-	glVertex3f(20.0, 0, 20.0);
-	glTexCoord2f(0, 1.0);
-	glVertex3f(20.0, 0, -20.0);
-
-	// Botten
-	glTexCoord2f(0, 0);
-	glVertex3f(-20.0, 0, -20.0);
-	glTexCoord2f(1.0, 0);
-	glVertex3f(20.0, 0, -20.0);
-	glTexCoord2f(1.0, 1.0);
-	glVertex3f(20.0, 0, 20.0);
-	glTexCoord2f(0, 1.0);
-	glVertex3f(-20.0, 0, 20.0);
-
-	glEnd();
+	queueDraw(drawRingParticles, 0, 0, true, 1, false);	// Partiklar på egna banor runt planeten, utan ljus
 
 	glPopMatrix();
 
-	// Rita solen (sist)
-	drawSun(shared.sunTexture);
+	// Asteroidbältet och solen. Solen gungar lite när planeterna drar i den, och bältet följer med.
+	// Solen ritas sist, i ett eget pass.
+	glPushMatrix();
+	translateToBody(shared.sun);
+	queueDraw(drawAsteroids, 0, 0, false, 1, false);
+	queueDraw(drawSunPacket, shared.sunTexture, 0, true, 1, false, 1);
+	glPopMatrix();
+
+	queueDraw(drawParticles, shared.sunTexture, 0, true, 1, false, 1);	// Partiklarna ligger i världskoordinater
+
+	// Sortera ritanropen och skicka dem till GL i ett svep
+	shared.queue.sort();
+	shared.queue.submit();
 }
 
 
@@ -251,13 +521,23 @@ void keyboardUp(unsigned char key, int x, int y)
 
 
 
-// GLUT-hanterad funktion som anropas efter att en angiven tid har löpt ut (ofta kallad timer)
-void timer(int timeout)
+// Vår egen underfunktion som stegar simuleringen ett fast tidssteg framåt
+void update()
 {
-	glutTimerFunc(timeout, timer, timeout);   // Vi måste starta om timern varje gång
+	shared.previousTime = shared.time;
+	shared.previousDistance = shared.distance;
+	for (unsigned i = 0; i < bodyCount; i++)
+	{
+		shared.previousBodies[i][0] = shared.bodies.x()[i];
+		shared.previousBodies[i][1] = shared.bodies.y()[i];
+		shared.previousBodies[i][2] = shared.bodies.z()[i];
+	}
 
 	if(!shared.pause)
-		shared.time += 0.01f;
+	{
+		shared.time += 0.01;   // Samma takt som den gamla timern på 60 Hz
+		shared.bodies.step(0.01f);
+	}
 
 	shared.distance += shared.distanceDelta;
 }
@@ -267,16 +547,21 @@ void timer(int timeout)
 // GLUT-hanterad funktion som anropas en gång för varje bildruta (frame)
 void display()
 {
+	PROFILE_SCOPE("display");
+	profilerGpuBegin();
+
 	glClearColor(0, 0, 0, 1);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);   // Vi vill rensa både skärmbuffert och z-buffert
 
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
-	gluLookAt(0, 10, shared.distance, 0, 0, 0, 0, 1, 0);   // Roterar kameran kring origo genom att skapa en ny vymatris varje bildruta
+	gluLookAt(0, 10, shared.renderDistance, 0, 0, 0, 0, 1, 0);   // Roterar kameran kring origo genom att skapa en ny vymatris varje bildruta
 
 	drawScene();
 
+	profilerGpuEnd();
 	glutSwapBuffers();
+	profilerEndFrame();
 }
 
 
@@ -296,6 +581,37 @@ void reshape(int width, int height)
 // GLUT-hanterad funktion som anropas när ingen händelse (tangentbord, utritning etc) sker 
 void idle()
 {
+	shared.frameLoop.waitForFrame();
+
+	int steps = shared.frameLoop.beginFrame();   // Simuleringen körs i fasta steg, hur ofta vi än ritar
+	for (int i = 0; i < steps; i++)
+		update();
+
+	float alpha = shared.frameLoop.alpha();
+	shared.renderTime = shared.previousTime + (shared.time - shared.previousTime) * alpha;
+	shared.renderDistance = shared.previousDistance + (shared.distance - shared.previousDistance) * alpha;
+	for (unsigned i = 0; i < bodyCount; i++)
+	{
+		shared.renderBodies[i][0] = shared.previousBodies[i][0] + (shared.bodies.x()[i] - shared.previousBodies[i][0]) * alpha;
+		shared.renderBodies[i][1] = shared.previousBodies[i][1] + (shared.bodies.y()[i] - shared.previousBodies[i][1]) * alpha;
+		shared.renderBodies[i][2] = shared.previousBodies[i][2] + (shared.bodies.z()[i] - shared.previousBodies[i][2]) * alpha;
+	}
+	shared.moons.evaluate(shared.renderTime);
+	shared.asteroids.evaluate(shared.renderTime);
+
+	const float *ringPlanet = shared.renderBodies[shared.planets[3]];	// Kameran står i (0, 10, renderDistance)
+	float dx = ringPlanet[0], dy = ringPlanet[1] - 10, dz = ringPlanet[2] - shared.renderDistance;
+	shared.rings.update(shared.renderTime, sqrtf(dx * dx + dy * dy + dz * dz));
+
+	// Partiklarna stegas med den interpolerade tiden, så de står still under paus och rör sig jämnt
+	float particleStep = float(shared.renderTime - shared.particleTime);
+	shared.particleTime = shared.renderTime;
+	ParticleEmitterSettings &flares = shared.particles.settings(shared.flares);
+	for (int i = 0; i < 3; i++)
+		flares.position[i] = shared.renderBodies[shared.sun][i];
+	if (particleStep > 0)
+		shared.particles.update(particleStep);
+
 	glutPostRedisplay();
 }
 
@@ -304,15 +620,48 @@ void idle()
 // Startpunkt för programmet
 int main(int argc, char* argv[])
 {
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-orbitbench") == 0)					// -orbitbench [namn] mäter simuleringen utan att öppna något fönster
+			return runOrbitBenchmark(i + 1 < argc ? argv[i + 1] : NULL);
+	}
+
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_DEPTH);   // Vi vill ha dubbelbuffring och z-buffert (depth buffer)
 	glutInitWindowSize(640, 480);
 	glutInitWindowPosition(100, 200);
 	glutCreateWindow("Datorgrafik");
 
+	// Mätningen startas före initialize, annars kommer texturladdningen inte med
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-profile") == 0)						// -profile [fil.json|fil.csv] mäter tider och skriver en rapport vid avslut
+		{
+			profilerStart(i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : NULL);
+			atexit(profilerFinish);
+		}
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)		// -trace fil.json skriver ett Chrome trace (chrome://tracing eller Perfetto)
+		{
+			if (profilerStartTrace(argv[++i]))
+				atexit(profilerFinish);
+		}
+	}
+
 	initialize();
 
-	glutTimerFunc(1000/60, timer, 1000/60);
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)				// -fps N sätter ett tak för bildhastigheten, 0 ger okapat benchmarkläge
+			shared.frameLoop.setFrameCap(atof(argv[++i]));
+		else if (strcmp(argv[i], "-profile") == 0)						// Startades redan före initialize
+		{
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				i++;
+		}
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)		// Startades redan före initialize
+			i++;
+	}
+
 	glutDisplayFunc(display);
 	glutReshapeFunc(reshape);
 	glutIdleFunc(idle);
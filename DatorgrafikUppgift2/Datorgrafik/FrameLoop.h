@@ -0,0 +1,43 @@
+#ifndef FRAMELOOP_H
+#define FRAMELOOP_H
+
+
+
+#include <chrono>
+
+
+
+// Bildrutsloop med fast simuleringssteg. Simuleringen stegas alltid med samma dt,
+// oberoende av hur ofta vi ritar, och resten i ackumulatorn används för att
+// interpolera mellan de två senaste simuleringstillstånden när vi ritar.
+class FrameLoop
+{
+public:
+	FrameLoop(double step = 1.0 / 60.0);
+
+	void setFrameCap(double framesPerSecond);	// 0 betyder okapad (benchmarkläge).
+	void reset();
+
+	void waitForFrame();		// Väntar tills bildhastighetstaket tillåter nästa bildruta.
+	int beginFrame();			// Returnerar antal simuleringssteg som ska tas den här bildrutan.
+
+	double step() const;
+	float alpha() const;		// Interpolationsfaktor [0, 1) mellan förra och nuvarande tillstånd.
+	double frameTime() const;	// Längden på senaste bildrutan i sekunder.
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double secondsSince(Clock::time_point point) const;
+
+	Clock::time_point lastFrame;
+	double stepLength;
+	double accumulator;
+	double minFrameTime;
+	double lastFrameTime;
+	bool started;
+};
+
+
+
+#endif
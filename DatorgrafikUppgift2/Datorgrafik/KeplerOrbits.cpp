@@ -0,0 +1,243 @@
+#include "KeplerOrbits.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+
+
+static const float pi = 3.14159265f;
+static const float halfPi = 1.57079633f;
+static const unsigned blockSize = 256;
+static const unsigned chunksPerThread = 8;
+
+
+
+KeplerOrbits::KeplerOrbits()
+{
+	evaluatedTime = 0;
+	evaluatedCount = 0;
+	threadPool = NULL;
+}
+
+
+
+unsigned KeplerOrbits::add(float semiMajorAxis, float eccentricity, float inclination, float ascendingNode,
+	float argumentOfPeriapsis, float meanAnomalyAtZero, float meanMotion)
+{
+	// Perifokala enhetsvektorer P (mot periapsis) och Q (90 grader längre fram i banan),
+	// först med z uppåt som i astronomin och sedan till scenens (x, z, -y)
+	float cosNode = cosf(ascendingNode), sinNode = sinf(ascendingNode);
+	float cosPeriapsis = cosf(argumentOfPeriapsis), sinPeriapsis = sinf(argumentOfPeriapsis);
+	float cosInclination = cosf(inclination), sinInclination = sinf(inclination);
+
+	float p[3] =
+	{
+		cosNode * cosPeriapsis - sinNode * sinPeriapsis * cosInclination,
+		sinNode * cosPeriapsis + cosNode * sinPeriapsis * cosInclination,
+		sinPeriapsis * sinInclination
+	};
+	float q[3] =
+	{
+		-cosNode * sinPeriapsis - sinNode * cosPeriapsis * cosInclination,
+		-sinNode * sinPeriapsis + cosNode * cosPeriapsis * cosInclination,
+		cosPeriapsis * sinInclination
+	};
+
+	float semiMinorAxis = semiMajorAxis * sqrtf(1 - eccentricity * eccentricity);
+	majorX.push_back(semiMajorAxis * p[0]);
+	majorY.push_back(semiMajorAxis * p[2]);
+	majorZ.push_back(-semiMajorAxis * p[1]);
+	minorX.push_back(semiMinorAxis * q[0]);
+	minorY.push_back(semiMinorAxis * q[2]);
+	minorZ.push_back(-semiMinorAxis * q[1]);
+	eccentricities.push_back(eccentricity);
+	meanAnomalies.push_back(meanAnomalyAtZero);
+	meanMotions.push_back(meanMotion);
+	eccentricAnomalies.push_back(0);
+	px.push_back(0);
+	py.push_back(0);
+	pz.push_back(0);
+	return px.size() - 1;
+}
+
+
+
+void KeplerOrbits::clear()
+{
+	majorX.clear();
+	majorY.clear();
+	majorZ.clear();
+	minorX.clear();
+	minorY.clear();
+	minorZ.clear();
+	eccentricities.clear();
+	meanAnomalies.clear();
+	meanMotions.clear();
+	eccentricAnomalies.clear();
+	px.clear();
+	py.clear();
+	pz.clear();
+	evaluatedCount = 0;
+}
+
+
+
+unsigned KeplerOrbits::size() const
+{
+	return px.size();
+}
+
+
+
+float KeplerOrbits::meanMotionFor(float centralMass, float semiMajorAxis)
+{
+	return sqrtf(centralMass / (semiMajorAxis * semiMajorAxis * semiMajorAxis));
+}
+
+
+
+void KeplerOrbits::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+}
+
+
+
+const float *KeplerOrbits::x() const { return px.data(); }
+const float *KeplerOrbits::y() const { return py.data(); }
+const float *KeplerOrbits::z() const { return pz.data(); }
+
+
+
+// Lägger en vinkel i [-pi, pi]. Medelanomalin växer utan gräns med tiden, så den räknas i
+// double; i float skulle felet vara 1e-4 radianer redan efter ett par tusen tidsenheter.
+// Avrundningen görs med heltalskonvertering, som vektoriseras utan SSE4.1 till skillnad från floor.
+static inline float wrapAngle(double angle)
+{
+	double turns = angle * (1 / 6.283185307179586);
+	double whole = double(int(turns + (turns >= 0 ? 0.5 : -0.5)));
+	return float(angle - whole * 6.283185307179586);
+}
+
+
+
+// sin och cos för x i [-3pi/2, 3pi/2]. x viks in i [-pi/2, pi/2] med sin(x) = sin(pi - x),
+// där cos byter tecken, och sedan räcker Taylorpolynom av grad 11 och 10 till ett fel
+// under 1e-6. Vikningen görs med min och max, eftersom kompilatorn inte vågar räkna
+// pi - x i bara ena grenen av ett villkor utan hopp, och hopp hindrar vektoriseringen.
+static inline void sinCos(float x, float &s, float &c)
+{
+	float folded = std::min(x, pi - x);
+	folded = std::max(folded, -pi - folded);
+	float sign = fabsf(x) > halfPi ? -1.0f : 1.0f;
+	float x2 = folded * folded;
+	s = folded * (1 + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040 + x2 * (1.0f / 362880 + x2 * (-1.0f / 39916800))))));
+	c = sign * (1 + x2 * (-1.0f / 2 + x2 * (1.0f / 24 + x2 * (-1.0f / 720 + x2 * (1.0f / 40320 + x2 * (-1.0f / 3628800))))));
+}
+
+
+
+static inline float newtonStep(float eccentric, float eccentricity, float mean)
+{
+	float s, c;
+	sinCos(eccentric, s, c);
+	return eccentric - (eccentric - eccentricity * s - mean) / (1 - eccentricity * c);
+}
+
+
+
+// Keplers ekvation E - e sin E = M löses med Newton från Danbys startgissning
+// E = M + 0.85 e sign(M), som konvergerar för alla e < 1. Antalet steg är fast, så alla
+// banor i en vektor tar lika lång tid och loopen har inga hopp. Lägena räknas först till
+// lokala arrayer, så att kompilatorn vet att skrivningarna inte kan ändra elementen.
+void KeplerOrbits::evaluateRange(double time, unsigned begin, unsigned end)
+{
+	const float *e = eccentricities.data(), *m0 = meanAnomalies.data(), *n = meanMotions.data();
+	const float *ax = majorX.data(), *ay = majorY.data(), *az = majorZ.data();
+	const float *bx = minorX.data(), *by = minorY.data(), *bz = minorZ.data();
+
+	for (unsigned block = begin; block < end; block += blockSize)
+	{
+		float anomaly[blockSize], sines[blockSize], cosines[blockSize];
+		float blockX[blockSize], blockY[blockSize], blockZ[blockSize];
+		unsigned count = std::min(blockSize, end - block);
+		const float *blockE = e + block;
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			float eccentricity = blockE[i];
+			float mean = wrapAngle(double(m0[block + i]) + double(n[block + i]) * time);
+			float eccentric = mean + (mean >= 0 ? 0.85f : -0.85f) * eccentricity;
+			eccentric = newtonStep(eccentric, eccentricity, mean);	// Fem steg räcker till full float-precision
+			eccentric = newtonStep(eccentric, eccentricity, mean);	// för e upp till 0.95. De är utskrivna i
+			eccentric = newtonStep(eccentric, eccentricity, mean);	// stället för en loop, eftersom en inre loop
+			eccentric = newtonStep(eccentric, eccentricity, mean);	// hindrar vektoriseringen av den yttre.
+			eccentric = newtonStep(eccentric, eccentricity, mean);
+			float s, c;
+			sinCos(eccentric, s, c);
+			anomaly[i] = eccentric;
+			sines[i] = s;
+			cosines[i] = c;
+		}
+
+		for (unsigned i = 0; i < count; i++)
+		{
+			float u = cosines[i] - blockE[i], v = sines[i];
+			blockX[i] = ax[block + i] * u + bx[block + i] * v;
+			blockY[i] = ay[block + i] * u + by[block + i] * v;
+			blockZ[i] = az[block + i] * u + bz[block + i] * v;
+		}
+
+		std::copy(anomaly, anomaly + count, eccentricAnomalies.begin() + block);
+		std::copy(blockX, blockX + count, px.begin() + block);
+		std::copy(blockY, blockY + count, py.begin() + block);
+		std::copy(blockZ, blockZ + count, pz.begin() + block);
+	}
+}
+
+
+
+void KeplerOrbits::evaluate(double time)
+{
+	evaluate(time, size());
+}
+
+
+
+void KeplerOrbits::evaluate(double time, unsigned count)
+{
+	PROFILE_SCOPE("KeplerOrbits::evaluate");
+
+	evaluatedTime = time;
+	evaluatedCount = std::min(count, size());
+	count = evaluatedCount;
+	unsigned chunks = threadPool ? threadPool->size() * chunksPerThread : 1;
+	if (chunks > count / blockSize)
+		chunks = count / blockSize;		// Minst ett helt block per bit
+	if (chunks <= 1)
+	{
+		evaluateRange(time, 0, count);
+		return;
+	}
+
+	threadPool->parallelFor(chunks, [&](unsigned chunk)
+	{
+		evaluateRange(time, unsigned((unsigned long long)count * chunk / chunks), unsigned((unsigned long long)count * (chunk + 1) / chunks));
+	});
+}
+
+
+
+float KeplerOrbits::residual() const
+{
+	double largest = 0;
+	for (unsigned i = 0; i < evaluatedCount; i++)
+	{
+		double mean = fmod((double)meanAnomalies[i] + (double)meanMotions[i] * evaluatedTime, 2 * 3.14159265358979);
+		double eccentric = eccentricAnomalies[i];
+		double error = fmod(eccentric - eccentricities[i] * sin(eccentric) - mean, 2 * 3.14159265358979);
+		error = std::min(fabs(error), 2 * 3.14159265358979 - fabs(error));
+		largest = std::max(largest, error);
+	}
+	return float(largest);
+}
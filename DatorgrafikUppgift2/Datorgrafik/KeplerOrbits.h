@@ -0,0 +1,64 @@
+#ifndef KEPLERORBITS_H
+#define KEPLERORBITS_H
+
+
+
+#include "ThreadPool.h"
+#include <vector>
+
+
+
+// Kroppar som följer fasta Keplerbanor (ellipser) i stället för att integreras. Lägena
+// räknas direkt ur banelementen för en godtycklig tidpunkt, så att pausa, spola eller
+// hoppa i tiden kostar ingenting och resultatet beror inte på hur man har stegat.
+//
+// Elementen ligger i separata arrayer (SoA). Keplers ekvation löses med ett fast antal
+// Newtonsteg och en egen sin/cos utan hopp, så att loopen över banorna kan vektoriseras.
+//
+// Referensplanet är xz-planet med y uppåt, som i scenen. Med inklination 0 går banorna
+// moturs sett ovanifrån, åt samma håll som planeterna i NBody.
+class KeplerOrbits
+{
+public:
+	KeplerOrbits();
+
+	// Vinklar i radianer. meanMotion är medelvinkelhastigheten i radianer per tidsenhet,
+	// t.ex. från meanMotionFor. Returnerar banans index.
+	unsigned add(float semiMajorAxis, float eccentricity, float inclination, float ascendingNode,
+		float argumentOfPeriapsis, float meanAnomalyAtZero, float meanMotion);
+	void clear();
+	unsigned size() const;
+
+	static float meanMotionFor(float centralMass, float semiMajorAxis);	// sqrt(GM / a^3) med G = 1 som i NBody
+
+	void setThreadPool(ThreadPool *pool);	// NULL kör allt på den anropande tråden
+
+	// Räknar alla lägen, relativt banornas brännpunkt, vid tiden time. Tiden är en double
+	// eftersom medelanomalin n t blir stor efter en stund och float tappar i precision.
+	void evaluate(double time);
+	void evaluate(double time, unsigned count);	// Bara de count första banorna
+
+	const float *x() const;
+	const float *y() const;
+	const float *z() const;
+
+	float residual() const;				// Största |E - e sin E - M| i senaste evaluate. För att kontrollera lösaren.
+
+private:
+	void evaluateRange(double time, unsigned begin, unsigned end);
+
+	// Per bana: ellipsens två halvaxlar som vektorer (a P och b Q), så att läget
+	// blir a P (cos E - e) + b Q sin E utan några trigonometriska anrop för orienteringen
+	std::vector<float> majorX, majorY, majorZ, minorX, minorY, minorZ;
+	std::vector<float> eccentricities, meanAnomalies, meanMotions;
+	std::vector<float> eccentricAnomalies;	// Senaste lösningen, för residual
+	std::vector<float> px, py, pz;
+	double evaluatedTime;
+	unsigned evaluatedCount;
+
+	ThreadPool *threadPool;
+};
+
+
+
+#endif
@@ -0,0 +1,481 @@
+#include "NBody.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+
+
+static const unsigned directLimit = 2048;	// Under så här många kroppar är den direkta summan snabbare än trädet
+static const unsigned leafSize = 8;
+static const unsigned chunksPerThread = 8;	// Fler bitar än trådar jämnar ut lasten
+
+
+
+NBody::NBody()
+{
+	gravity = 1;
+	softening = 0.01f;
+	theta = 0.5f;
+	method = Automatic;
+	threadPool = NULL;
+	accelerationsValid = false;
+}
+
+
+
+unsigned NBody::add(float x, float y, float z, float vx, float vy, float vz, float mass)
+{
+	px.push_back(x);
+	py.push_back(y);
+	pz.push_back(z);
+	velocityX.push_back(vx);
+	velocityY.push_back(vy);
+	velocityZ.push_back(vz);
+	masses.push_back(mass);
+	ax.push_back(0);
+	ay.push_back(0);
+	az.push_back(0);
+	accelerationsValid = false;
+	return px.size() - 1;
+}
+
+
+
+void NBody::clear()
+{
+	px.clear();
+	py.clear();
+	pz.clear();
+	velocityX.clear();
+	velocityY.clear();
+	velocityZ.clear();
+	masses.clear();
+	ax.clear();
+	ay.clear();
+	az.clear();
+	accelerationsValid = false;
+}
+
+
+
+unsigned NBody::size() const
+{
+	return px.size();
+}
+
+
+
+void NBody::setGravity(float constant)
+{
+	gravity = constant;
+	accelerationsValid = false;
+}
+
+
+
+void NBody::setSoftening(float length)
+{
+	softening = length;
+	accelerationsValid = false;
+}
+
+
+
+void NBody::setTheta(float newTheta)
+{
+	theta = newTheta;
+	accelerationsValid = false;
+}
+
+
+
+void NBody::setMethod(Method newMethod)
+{
+	method = newMethod;
+	accelerationsValid = false;
+}
+
+
+
+void NBody::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+}
+
+
+
+const float *NBody::x() const { return px.data(); }
+const float *NBody::y() const { return py.data(); }
+const float *NBody::z() const { return pz.data(); }
+const float *NBody::vx() const { return velocityX.data(); }
+const float *NBody::vy() const { return velocityY.data(); }
+const float *NBody::vz() const { return velocityZ.data(); }
+const float *NBody::mass() const { return masses.data(); }
+
+
+
+// Delar kropparna i lika stora bitar och kör function(begin, end) för varje bit i trådpoolen
+template<typename Function>
+void NBody::forRanges(Function function)
+{
+	unsigned count = size();
+	unsigned chunks = threadPool ? threadPool->size() * chunksPerThread : 1;
+	if (chunks > count)
+		chunks = count;
+	if (chunks <= 1)
+	{
+		function(0u, count);
+		return;
+	}
+
+	threadPool->parallelFor(chunks, [&](unsigned chunk)
+	{
+		function(unsigned((unsigned long long)count * chunk / chunks), unsigned((unsigned long long)count * (chunk + 1) / chunks));
+	});
+}
+
+
+
+void NBody::step(float dt)
+{
+	PROFILE_SCOPE("NBody::step");
+
+	if (size() == 0)
+		return;
+	if (!accelerationsValid)
+		computeAccelerations();
+
+	float halfStep = dt * 0.5f;
+	forRanges([&](unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; i++)
+		{
+			velocityX[i] += ax[i] * halfStep;
+			velocityY[i] += ay[i] * halfStep;
+			velocityZ[i] += az[i] * halfStep;
+			px[i] += velocityX[i] * dt;
+			py[i] += velocityY[i] * dt;
+			pz[i] += velocityZ[i] * dt;
+		}
+	});
+
+	computeAccelerations();
+
+	forRanges([&](unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; i++)
+		{
+			velocityX[i] += ax[i] * halfStep;
+			velocityY[i] += ay[i] * halfStep;
+			velocityZ[i] += az[i] * halfStep;
+		}
+	});
+}
+
+
+
+bool NBody::useTree() const
+{
+	return method == BarnesHut || (method == Automatic && size() > directLimit);
+}
+
+
+
+void NBody::computeAccelerations()
+{
+	if (useTree())
+	{
+		buildTree();
+		forRanges([&](unsigned begin, unsigned end) { accelerationsTree(begin, end); });
+	}
+	else
+		forRanges([&](unsigned begin, unsigned end) { accelerationsDirect(begin, end); });
+
+	accelerationsValid = true;
+}
+
+
+
+// Målkropparna tas i block som får plats i cachen, och den inre loopen går över blocket
+// i stället för över källorna. Då summeras varje acceleration i sin egen arrayplats och
+// loopen kan vektoriseras utan att kompilatorn behöver ändra ordningen på additionerna.
+// En kropp drar inte i sig själv eftersom avståndet då är noll, och mjukningen gör att
+// vi aldrig delar med noll, så loopen har inga villkor.
+void NBody::accelerationsDirect(unsigned begin, unsigned end)
+{
+	PROFILE_SCOPE("NBody::accelerationsDirect");
+
+	static const unsigned blockSize = 256;
+	unsigned count = size();
+	const float *x = px.data(), *y = py.data(), *z = pz.data(), *m = masses.data();
+	float softeningSquared = softening * softening;
+
+	for (unsigned block = begin; block < end; block += blockSize)
+	{
+		// Lokala kopior, så att kompilatorn vet att skrivningarna inte kan ändra positionerna
+		float xi[blockSize], yi[blockSize], zi[blockSize];
+		float sumX[blockSize], sumY[blockSize], sumZ[blockSize];
+		unsigned n = std::min(blockSize, end - block);
+		for (unsigned i = 0; i < n; i++)
+		{
+			xi[i] = x[block + i];
+			yi[i] = y[block + i];
+			zi[i] = z[block + i];
+			sumX[i] = sumY[i] = sumZ[i] = 0;
+		}
+
+		for (unsigned j = 0; j < count; j++)
+		{
+			float xj = x[j], yj = y[j], zj = z[j], mj = m[j];
+			for (unsigned i = 0; i < n; i++)
+			{
+				float dx = xj - xi[i];
+				float dy = yj - yi[i];
+				float dz = zj - zi[i];
+				float inverse = 1 / sqrtf(dx * dx + dy * dy + dz * dz + softeningSquared);
+				float strength = mj * inverse * inverse * inverse;
+				sumX[i] += dx * strength;
+				sumY[i] += dy * strength;
+				sumZ[i] += dz * strength;
+			}
+		}
+
+		for (unsigned i = 0; i < n; i++)
+		{
+			ax[block + i] = sumX[i] * gravity;
+			ay[block + i] = sumY[i] * gravity;
+			az[block + i] = sumZ[i] * gravity;
+		}
+	}
+}
+
+
+
+// Sprider ut de 10 lägsta bitarna så att det blir två nollor mellan varje bit
+static unsigned spreadBits(unsigned value)
+{
+	value &= 0x3ff;
+	value = (value | (value << 16)) & 0x030000ff;
+	value = (value | (value << 8)) & 0x0300f00f;
+	value = (value | (value << 4)) & 0x030c30c3;
+	value = (value | (value << 2)) & 0x09249249;
+	return value;
+}
+
+
+
+void NBody::buildTree()
+{
+	PROFILE_SCOPE("NBody::buildTree");
+
+	unsigned count = size();
+
+	float minX = px[0], minY = py[0], minZ = pz[0];
+	float maxX = minX, maxY = minY, maxZ = minZ;
+	for (unsigned i = 1; i < count; i++)
+	{
+		minX = std::min(minX, px[i]);
+		minY = std::min(minY, py[i]);
+		minZ = std::min(minZ, pz[i]);
+		maxX = std::max(maxX, px[i]);
+		maxY = std::max(maxY, py[i]);
+		maxZ = std::max(maxZ, pz[i]);
+	}
+	float size = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ));
+	if (!(size > 0))
+		size = 1;
+	float scale = 1023.0f / size;
+
+	// Kropparna sorteras på Morton-kod, så att varje nod i trädet blir en sammanhängande följd
+	keys.resize(count);
+	forRanges([&](unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; i++)
+		{
+			keys[i].code = spreadBits(unsigned((px[i] - minX) * scale))
+				| (spreadBits(unsigned((py[i] - minY) * scale)) << 1)
+				| (spreadBits(unsigned((pz[i] - minZ) * scale)) << 2);
+			keys[i].index = i;
+		}
+	});
+	std::sort(keys.begin(), keys.end(), [](const MortonKey &a, const MortonKey &b) { return a.code < b.code; });
+
+	sortedX.resize(count);
+	sortedY.resize(count);
+	sortedZ.resize(count);
+	sortedMass.resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		unsigned index = keys[i].index;
+		sortedX[i] = px[index];
+		sortedY[i] = py[index];
+		sortedZ[i] = pz[index];
+		sortedMass[i] = masses[index];
+	}
+
+	nodes.clear();
+	nodes.push_back(Node());
+	buildNode(0, 0, count, 27, size);
+}
+
+
+
+// Noderna byggs uppifrån och ned, masscentrum räknas nedifrån och upp. shift är positionen
+// för de tre bitar i Morton-koden som väljer barn på den här nivån.
+void NBody::buildNode(unsigned node, unsigned begin, unsigned end, int shift, float size)
+{
+	nodes[node].size = size;
+
+	if (end - begin <= leafSize || shift < 0)
+	{
+		float mass = 0, x = 0, y = 0, z = 0;
+		for (unsigned i = begin; i < end; i++)
+		{
+			mass += sortedMass[i];
+			x += sortedX[i] * sortedMass[i];
+			y += sortedY[i] * sortedMass[i];
+			z += sortedZ[i] * sortedMass[i];
+		}
+		Node &leaf = nodes[node];
+		leaf.first = begin;
+		leaf.count = end - begin;
+		leaf.firstChild = 0;
+		leaf.childCount = 0;
+		leaf.mass = mass;
+		leaf.x = mass > 0 ? x / mass : sortedX[begin];
+		leaf.y = mass > 0 ? y / mass : sortedY[begin];
+		leaf.z = mass > 0 ? z / mass : sortedZ[begin];
+		return;
+	}
+
+	// Dela följden i upp till åtta delar efter de tre bitarna. Koderna är sorterade och de
+	// högre bitarna är lika inom noden, så varje barn är en sammanhängande del.
+	unsigned bounds[9];
+	bounds[0] = begin;
+	for (unsigned octant = 0; octant < 8; octant++)
+	{
+		unsigned i = bounds[octant];
+		while (i < end && ((keys[i].code >> shift) & 7) == octant)
+			i++;
+		bounds[octant + 1] = i;
+	}
+
+	unsigned firstChild = nodes.size();
+	unsigned childCount = 0;
+	for (unsigned octant = 0; octant < 8; octant++)
+	{
+		if (bounds[octant + 1] > bounds[octant])
+			childCount++;
+	}
+	nodes.resize(firstChild + childCount);
+
+	unsigned child = firstChild;
+	for (unsigned octant = 0; octant < 8; octant++)
+	{
+		if (bounds[octant + 1] > bounds[octant])
+			buildNode(child++, bounds[octant], bounds[octant + 1], shift - 3, size * 0.5f);
+	}
+
+	float mass = 0, x = 0, y = 0, z = 0;
+	for (unsigned i = firstChild; i < firstChild + childCount; i++)
+	{
+		mass += nodes[i].mass;
+		x += nodes[i].x * nodes[i].mass;
+		y += nodes[i].y * nodes[i].mass;
+		z += nodes[i].z * nodes[i].mass;
+	}
+	Node &inner = nodes[node];
+	inner.first = begin;
+	inner.count = end - begin;
+	inner.firstChild = firstChild;
+	inner.childCount = childCount;
+	inner.mass = mass;
+	inner.x = mass > 0 ? x / mass : nodes[firstChild].x;
+	inner.y = mass > 0 ? y / mass : nodes[firstChild].y;
+	inner.z = mass > 0 ? z / mass : nodes[firstChild].z;
+}
+
+
+
+// Går igenom kropparna i Morton-ordning, så att grannar i tur och ordning besöker nästan
+// samma noder och de ligger kvar i cachen.
+void NBody::accelerationsTree(unsigned begin, unsigned end)
+{
+	PROFILE_SCOPE("NBody::accelerationsTree");
+
+	float softeningSquared = softening * softening;
+	float thetaSquared = theta * theta;
+	unsigned stack[128];	// Högst 11 nivåer med 8 barn var
+
+	for (unsigned k = begin; k < end; k++)
+	{
+		float xi = sortedX[k], yi = sortedY[k], zi = sortedZ[k];
+		float sumX = 0, sumY = 0, sumZ = 0;
+
+		unsigned top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node &node = nodes[stack[--top]];
+			float dx = node.x - xi;
+			float dy = node.y - yi;
+			float dz = node.z - zi;
+			float distanceSquared = dx * dx + dy * dy + dz * dz;
+
+			if (node.size * node.size < thetaSquared * distanceSquared)
+			{
+				// Tillräckligt långt bort, hela noden räknas som en punkt
+				float inverse = 1 / sqrtf(distanceSquared + softeningSquared);
+				float strength = node.mass * inverse * inverse * inverse;
+				sumX += dx * strength;
+				sumY += dy * strength;
+				sumZ += dz * strength;
+			}
+			else if (node.childCount == 0)
+			{
+				for (unsigned j = node.first; j < node.first + node.count; j++)
+				{
+					float ddx = sortedX[j] - xi;
+					float ddy = sortedY[j] - yi;
+					float ddz = sortedZ[j] - zi;
+					float inverse = 1 / sqrtf(ddx * ddx + ddy * ddy + ddz * ddz + softeningSquared);
+					float strength = sortedMass[j] * inverse * inverse * inverse;
+					sumX += ddx * strength;
+					sumY += ddy * strength;
+					sumZ += ddz * strength;
+				}
+			}
+			else
+			{
+				for (unsigned c = 0; c < node.childCount; c++)
+					stack[top++] = node.firstChild + c;
+			}
+		}
+
+		unsigned index = keys[k].index;
+		ax[index] = sumX * gravity;
+		ay[index] = sumY * gravity;
+		az[index] = sumZ * gravity;
+	}
+}
+
+
+
+double NBody::energy() const
+{
+	unsigned count = size();
+	double kinetic = 0, potential = 0;
+	double softeningSquared = double(softening) * softening;
+	for (unsigned i = 0; i < count; i++)
+	{
+		kinetic += 0.5 * masses[i] * (double(velocityX[i]) * velocityX[i] + double(velocityY[i]) * velocityY[i] + double(velocityZ[i]) * velocityZ[i]);
+		for (unsigned j = i + 1; j < count; j++)
+		{
+			double dx = double(px[j]) - px[i];
+			double dy = double(py[j]) - py[i];
+			double dz = double(pz[j]) - pz[i];
+			potential -= gravity * double(masses[i]) * masses[j] / sqrt(dx * dx + dy * dy + dz * dz + softeningSquared);
+		}
+	}
+	return kinetic + potential;
+}
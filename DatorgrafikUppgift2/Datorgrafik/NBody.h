@@ -0,0 +1,93 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+
+
+#include "ThreadPool.h"
+#include <vector>
+
+
+
+// Gravitationssimulering av N kroppar. Positioner, hastigheter, accelerationer och massor
+// ligger i separata arrayer (SoA) så att looparna över kropparna kan vektoriseras.
+// Integratorn är leapfrog (kick-drift-kick), som är symplektisk: energin driver inte
+// iväg med tiden, den svänger bara kring rätt värde.
+//
+// Krafterna räknas antingen direkt mellan alla par, O(n^2), eller med ett Barnes-Hut-oktträd,
+// O(n log n), där avlägsna grupper av kroppar ersätts med sin masscentrum. Trädet byggs
+// av kropparna sorterade i Morton-ordning, så löven är sammanhängande delar av arrayerna.
+class NBody
+{
+public:
+	enum Method
+	{
+		Automatic,		// Direkt för få kroppar, annars Barnes-Hut
+		Direct,
+		BarnesHut
+	};
+
+	NBody();
+
+	unsigned add(float x, float y, float z, float vx, float vy, float vz, float mass);
+	void clear();
+	unsigned size() const;
+
+	void setGravity(float constant);	// G, 1 om inget annat anges
+	void setSoftening(float length);	// Hindrar krafterna från att bli oändliga när två kroppar möts. Måste vara större än noll.
+	void setTheta(float theta);			// Barnes-Hut: en nod räknas som en punkt om storlek / avstånd < theta
+	void setMethod(Method method);
+	void setThreadPool(ThreadPool *pool);	// NULL kör allt på den anropande tråden
+
+	void step(float dt);
+
+	const float *x() const;
+	const float *y() const;
+	const float *z() const;
+	const float *vx() const;
+	const float *vy() const;
+	const float *vz() const;
+	const float *mass() const;
+
+	double energy() const;				// Kinetisk plus potentiell energi, O(n^2). För att kontrollera integratorn.
+
+private:
+	struct Node
+	{
+		float x, y, z, mass;			// Masscentrum och total massa
+		float size;						// Kubens kantlängd
+		unsigned first, count;			// Löv: kropparna [first, first + count) i sorterad ordning
+		unsigned firstChild, childCount;	// Inre nod: barnen ligger i följd i nodes
+	};
+
+	struct MortonKey
+	{
+		unsigned code;
+		unsigned index;
+	};
+
+	bool useTree() const;
+	void computeAccelerations();
+	void accelerationsDirect(unsigned begin, unsigned end);
+	void buildTree();
+	void buildNode(unsigned node, unsigned begin, unsigned end, int shift, float size);
+	void accelerationsTree(unsigned begin, unsigned end);
+
+	template<typename Function>
+	void forRanges(Function function);
+
+	std::vector<float> px, py, pz, velocityX, velocityY, velocityZ, ax, ay, az, masses;
+	std::vector<MortonKey> keys;
+	std::vector<float> sortedX, sortedY, sortedZ, sortedMass;	// Kropparna i Morton-ordning för trädet
+	std::vector<Node> nodes;
+
+	float gravity;
+	float softening;
+	float theta;
+	Method method;
+	ThreadPool *threadPool;
+	bool accelerationsValid;
+};
+
+
+
+#endif
@@ -0,0 +1,390 @@
+#include "OrbitBenchmark.h"
+#include "NBody.h"
+#include "KeplerOrbits.h"
+#include "RingSystem.h"
+#include "ParticleSystem.h"
+#include "BillboardBatcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+
+
+static double seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+static float random01()
+{
+	return (rand() + 0.5f) / (RAND_MAX + 1.0f);
+}
+
+
+
+// En Plummer-sfär med total massa 1 (G = 1), en vanlig modell av en stjärnhop i jämvikt.
+// Radierna dras ur den kumulativa massfördelningen och farterna med förkastningsmetoden.
+static void plummerSphere(NBody &bodies, unsigned count)
+{
+	bodies.clear();
+	for (unsigned i = 0; i < count; i++)
+	{
+		float radius = 1 / sqrtf(powf(random01(), -2.0f / 3.0f) - 1);
+		if (radius > 20)
+			radius = 20;
+
+		float z = 2 * random01() - 1;
+		float angle = 2 * 3.14159265f * random01();
+		float ring = sqrtf(1 - z * z);
+
+		float q, g;
+		do
+		{
+			q = random01();
+			g = 0.1f * random01();
+		} while (g > q * q * powf(1 - q * q, 3.5f));
+		float speed = q * sqrtf(2.0f) * powf(1 + radius * radius, -0.25f);
+
+		float vz = 2 * random01() - 1;
+		float vAngle = 2 * 3.14159265f * random01();
+		float vRing = sqrtf(1 - vz * vz);
+
+		bodies.add(radius * ring * cosf(angle), radius * ring * sinf(angle), radius * z,
+			speed * vRing * cosf(vAngle), speed * vRing * sinf(vAngle), speed * vz, 1.0f / count);
+	}
+}
+
+
+
+// Stegar tills minst en sekund har gått och returnerar antal steg per sekund
+static double stepsPerSecond(NBody &bodies, float dt)
+{
+	bodies.step(dt);	// Första steget räknar också de första accelerationerna
+
+	unsigned steps = 0;
+	double start = seconds(), elapsed = 0;
+	while (steps < 2 || elapsed < 1)
+	{
+		bodies.step(dt);
+		steps++;
+		elapsed = seconds() - start;
+	}
+	return steps / elapsed;
+}
+
+
+
+// Steg per sekund mot antal kroppar, med direkt summa och med Barnes-Hut. Energidriften
+// (relativ ändring av totalenergin under mätningen) visar att integratorn håller.
+static void benchmarkNBody()
+{
+	ThreadPool pool;
+	static const unsigned counts[] = { 1000, 10000, 100000, 1000000 };
+	static const unsigned directMax = 20000;
+	static const unsigned energyMax = 20000;
+	const float dt = 0.001f;
+
+	printf("nbody: Plummer-sfär, %u trådar, theta 0.5\n", pool.size());
+	printf("  %10s %14s %14s %14s\n", "kroppar", "direkt steg/s", "B-H steg/s", "energidrift");
+
+	NBody bodies;
+	bodies.setThreadPool(&pool);
+	for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		unsigned count = counts[c];
+		srand(1);
+		plummerSphere(bodies, count);
+
+		char direct[32] = "-";
+		if (count <= directMax)
+		{
+			bodies.setMethod(NBody::Direct);
+			sprintf(direct, "%.1f", stepsPerSecond(bodies, dt));
+			srand(1);
+			plummerSphere(bodies, count);
+		}
+
+		bodies.setMethod(NBody::BarnesHut);
+		double before = count <= energyMax ? bodies.energy() : 0;
+		double rate = stepsPerSecond(bodies, dt);
+		char drift[32] = "-";
+		if (count <= energyMax)
+			sprintf(drift, "%.2e", fabs((bodies.energy() - before) / before));
+
+		printf("  %10u %14s %14.1f %14s\n", count, direct, rate, drift);
+	}
+}
+
+
+
+// Ett asteroidbälte kring en sol med massan 20000. Elementen sparas också för den skalära jämförelsen.
+struct BeltElements
+{
+	std::vector<float> semiMajorAxis, eccentricity, inclination, ascendingNode, argumentOfPeriapsis, meanAnomaly, meanMotion;
+};
+
+static void asteroidBelt(BeltElements &belt, KeplerOrbits &orbits, unsigned count)
+{
+	belt = BeltElements();
+	orbits.clear();
+	for (unsigned i = 0; i < count; i++)
+	{
+		float a = 62 + 13 * random01();
+		float e = 0.2f * random01();
+		float inclination = 0.1f * random01();
+		float node = 2 * 3.14159265f * random01();
+		float periapsis = 2 * 3.14159265f * random01();
+		float mean = 2 * 3.14159265f * random01();
+		float motion = KeplerOrbits::meanMotionFor(20000, a);
+		orbits.add(a, e, inclination, node, periapsis, mean, motion);
+
+		belt.semiMajorAxis.push_back(a);
+		belt.eccentricity.push_back(e);
+		belt.inclination.push_back(inclination);
+		belt.ascendingNode.push_back(node);
+		belt.argumentOfPeriapsis.push_back(periapsis);
+		belt.meanAnomaly.push_back(mean);
+		belt.meanMotion.push_back(motion);
+	}
+}
+
+
+
+// Som en lärobok gör det: en bana i taget, Newton tills ändringen är liten och
+// orienteringen med sinf och cosf varje gång. Medelanomalin räknas i double som i KeplerOrbits.
+static void evaluateScalar(const BeltElements &belt, float time, std::vector<float> &x, std::vector<float> &y, std::vector<float> &z)
+{
+	for (unsigned i = 0; i < belt.semiMajorAxis.size(); i++)
+	{
+		float e = belt.eccentricity[i];
+		float mean = float(fmod(double(belt.meanAnomaly[i]) + double(belt.meanMotion[i]) * time, 2 * 3.14159265358979));
+		float eccentric = e < 0.8f ? mean : 3.14159265f;
+		for (int step = 0; step < 50; step++)
+		{
+			float delta = (eccentric - e * sinf(eccentric) - mean) / (1 - e * cosf(eccentric));
+			eccentric -= delta;
+			if (fabsf(delta) < 1e-6f)
+				break;
+		}
+
+		float a = belt.semiMajorAxis[i];
+		float u = a * (cosf(eccentric) - e), v = a * sqrtf(1 - e * e) * sinf(eccentric);
+		float cn = cosf(belt.ascendingNode[i]), sn = sinf(belt.ascendingNode[i]);
+		float cp = cosf(belt.argumentOfPeriapsis[i]), sp = sinf(belt.argumentOfPeriapsis[i]);
+		float ci = cosf(belt.inclination[i]), si = sinf(belt.inclination[i]);
+		x[i] = (cn * cp - sn * sp * ci) * u + (-cn * sp - sn * cp * ci) * v;
+		z[i] = -((sn * cp + cn * sp * ci) * u + (-sn * sp + cn * cp * ci) * v);
+		y[i] = sp * si * u + cp * si * v;
+	}
+}
+
+
+
+// Lägen per sekund för Keplerbanor, skalärt med sinf/cosf och med KeplerOrbits (SoA, fasta
+// Newtonsteg, vektoriserad sin/cos och trådpoolen). Största avvikelsen mellan dem och
+// residualen i Keplers ekvation visar att den snabba lösaren räcker till.
+static void benchmarkKepler()
+{
+	ThreadPool pool;
+	static const unsigned counts[] = { 1000, 100000, 1000000, 4000000 };
+	static const unsigned scalarMax = 1000000;
+
+	printf("kepler: asteroidbälte med e < 0.2, %u trådar\n", pool.size());
+	printf("  %10s %14s %14s %12s %12s\n", "banor", "skalär Mbana/s", "SoA Mbana/s", "residual", "max avvikelse");
+
+	BeltElements belt;
+	KeplerOrbits orbits;
+	orbits.setThreadPool(&pool);
+	for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		unsigned count = counts[c];
+		asteroidBelt(belt, orbits, count);
+		std::vector<float> x(count), y(count), z(count);
+
+		char scalar[32] = "-";
+		float deviation = 0;
+		if (count <= scalarMax)
+		{
+			unsigned runs = 0;
+			double start = seconds(), elapsed = 0;
+			while (runs < 2 || elapsed < 1)
+			{
+				evaluateScalar(belt, 1000 + runs * 0.1f, x, y, z);
+				runs++;
+				elapsed = seconds() - start;
+			}
+			sprintf(scalar, "%.1f", count * (runs / elapsed) * 1e-6);
+
+			orbits.evaluate(1000 + (runs - 1) * 0.1f);
+			for (unsigned i = 0; i < count; i++)
+			{
+				deviation = std::max(deviation, fabsf(orbits.x()[i] - x[i]));
+				deviation = std::max(deviation, fabsf(orbits.y()[i] - y[i]));
+				deviation = std::max(deviation, fabsf(orbits.z()[i] - z[i]));
+			}
+		}
+
+		unsigned runs = 0;
+		double start = seconds(), elapsed = 0;
+		while (runs < 2 || elapsed < 1)
+		{
+			orbits.evaluate(1000 + runs * 0.1f);
+			runs++;
+			elapsed = seconds() - start;
+		}
+
+		char deviationText[32] = "-";
+		if (count <= scalarMax)
+			sprintf(deviationText, "%.2e", deviation);
+		printf("  %10u %14s %14.1f %12.2e %12s\n", count, scalar, count * (runs / elapsed) * 1e-6, orbits.residual(), deviationText);
+	}
+}
+
+
+
+// Millisekunder per update för ringpartiklarna, på nära håll där alla räknas och på tre
+// gånger så långt avstånd där bara en niondel behövs. Budgeten vid 60 Hz är 16.7 ms.
+static void benchmarkRings()
+{
+	ThreadPool pool;
+	static const unsigned counts[] = { 100000, 300000, 1000000 };
+
+	// En grå ring från radie 12 till 20, som ungefär motsvarar Rings.png
+	unsigned char profile[21 * 4];
+	for (unsigned i = 0; i < 21; i++)
+	{
+		profile[i * 4] = profile[i * 4 + 1] = profile[i * 4 + 2] = 160;
+		profile[i * 4 + 3] = i >= 12 ? 255 : 0;
+	}
+
+	printf("rings: %u trådar, full täthet närmare än 60\n", pool.size());
+	printf("  %10s %16s %16s\n", "partiklar", "ms på avstånd 60", "ms på avstånd 180");
+
+	RingSystem rings;
+	rings.setThreadPool(&pool);
+	for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		rings.create(counts[c], 6, 20, 400, profile, 21);
+
+		double milliseconds[2];
+		static const float distances[2] = { 60, 180 };
+		for (int d = 0; d < 2; d++)
+		{
+			unsigned frames = 0;
+			double start = seconds(), elapsed = 0;
+			while (frames < 2 || elapsed < 1)
+			{
+				rings.update(frames / 60.0, distances[d]);
+				frames++;
+				elapsed = seconds() - start;
+			}
+			milliseconds[d] = elapsed / frames * 1000;
+		}
+
+		printf("  %10u %16.2f %16.2f\n", rings.size(), milliseconds[0], milliseconds[1]);
+	}
+}
+
+
+
+// Millisekunder per bildruta för partikelsystemet och billboard-batchern med 16 emittrar,
+// när antalet levande partiklar har stabiliserats (födslar per tidsenhet gånger medellivslängd)
+static void benchmarkParticles()
+{
+	ThreadPool pool;
+	static const unsigned counts[] = { 10000, 100000, 1000000 };
+	static const unsigned emitters = 16;
+	const float dt = 1 / 60.0f;
+	static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	printf("particles: %u emittrar, %u trådar\n", emitters, pool.size());
+	printf("  %10s %12s %12s %12s\n", "partiklar", "update ms", "build ms", "totalt ms");
+
+	ParticleSystem particles;
+	particles.setThreadPool(&pool);
+	BillboardBatcher batcher;
+	for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		unsigned capacity = counts[c] / emitters;
+		particles.clear();
+		for (unsigned e = 0; e < emitters; e++)
+		{
+			ParticleEmitterSettings settings;
+			settings.position[0] = float(e);
+			settings.rate = capacity / 2.5f;			// Medellivslängden är 2, så poolen blir aldrig full
+			settings.lifetimeMin = 1;
+			settings.lifetimeMax = 3;
+			settings.speedMin = 1;
+			settings.speedMax = 3;
+			settings.acceleration[1] = -1;
+			settings.drag = 0.2f;
+			ParticleCurve size = { 0.2f, 0.5f, 0.1f }, fade = { 1, 0.6f, 0 };
+			settings.size = size;
+			settings.alpha = fade;
+			particles.addEmitter(settings, capacity);
+		}
+		for (int warmup = 0; warmup < 240; warmup++)
+			particles.update(dt);
+
+		unsigned frames = 0;
+		double updateTime = 0, buildTime = 0, start = seconds();
+		while (frames < 2 || seconds() - start < 1)
+		{
+			double before = seconds();
+			particles.update(dt);
+			double middle = seconds();
+			batcher.build(identity, particles.billboards(), particles.billboardCount());
+			updateTime += middle - before;
+			buildTime += seconds() - middle;
+			frames++;
+		}
+
+		printf("  %10u %12.2f %12.2f %12.2f\n", particles.billboardCount(), updateTime / frames * 1000, buildTime / frames * 1000,
+			(updateTime + buildTime) / frames * 1000);
+	}
+}
+
+
+
+struct OrbitBenchmark
+{
+	const char *name;
+	void (*run)();
+};
+
+static const OrbitBenchmark benchmarks[] =
+{
+	{ "nbody", benchmarkNBody },
+	{ "kepler", benchmarkKepler },
+	{ "rings", benchmarkRings },
+	{ "particles", benchmarkParticles }
+};
+
+
+
+int runOrbitBenchmark(const char *name)
+{
+	bool found = false;
+	for (unsigned i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+	{
+		if (!name || strcmp(name, benchmarks[i].name) == 0)
+		{
+			srand(1);
+			benchmarks[i].run();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		fprintf(stderr, "Okänd benchmark: %s\n", name);
+		return 1;
+	}
+	return 0;
+}
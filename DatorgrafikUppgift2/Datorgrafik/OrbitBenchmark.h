@@ -0,0 +1,12 @@
+#ifndef ORBITBENCHMARK_H
+#define ORBITBENCHMARK_H
+
+
+
+// Benchmarkar för simuleringen av himlakropparna. De körs med -orbitbench [namn] innan
+// något fönster öppnas, skriver ut resultaten och avslutar.
+int runOrbitBenchmark(const char *name);	// NULL kör alla. Returnerar 1 om namnet är okänt.
+
+
+
+#endif
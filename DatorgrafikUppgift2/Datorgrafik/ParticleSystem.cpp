@@ -0,0 +1,291 @@
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+
+
+ParticleEmitterSettings::ParticleEmitterSettings()
+{
+	position[0] = position[1] = position[2] = 0;
+	spawnRadius = 0;
+	rate = 1;
+	lifetimeMin = lifetimeMax = 1;
+	speedMin = speedMax = 0;
+	velocity[0] = velocity[1] = velocity[2] = 0;
+	acceleration[0] = acceleration[1] = acceleration[2] = 0;
+	drag = 0;
+	ParticleCurve one = { 1, 1, 1 };
+	size = red = green = blue = alpha = one;
+}
+
+
+
+ParticleSystem::ParticleSystem()
+{
+	streamCount = 0;
+	threadPool = NULL;
+}
+
+
+
+unsigned ParticleSystem::addEmitter(const ParticleEmitterSettings &settings, unsigned capacity)
+{
+	pools.push_back(Pool());
+	Pool &pool = pools.back();
+	pool.settings = settings;
+	pool.capacity = capacity;
+	pool.count = 0;
+	pool.spawnDebt = 0;
+	pool.random = 2463534242u + 7919u * pools.size();	// Olika frön, så att emittrarna inte blir likadana
+
+	std::vector<float> *arrays[] = { &pool.x, &pool.y, &pool.z, &pool.vx, &pool.vy, &pool.vz, &pool.age, &pool.inverseLifetime,
+		&pool.phase, &pool.size, &pool.red, &pool.green, &pool.blue, &pool.alpha };
+	for (unsigned i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+		arrays[i]->resize(capacity);
+
+	offsets.push_back(0);
+	stream.resize(stream.size() + capacity);			// Strömmen rymmer alla pooler fulla
+	return pools.size() - 1;
+}
+
+
+
+ParticleEmitterSettings &ParticleSystem::settings(unsigned emitter)
+{
+	return pools[emitter].settings;
+}
+
+
+
+unsigned ParticleSystem::emitterCount() const
+{
+	return pools.size();
+}
+
+
+
+void ParticleSystem::clear()
+{
+	pools.clear();
+	offsets.clear();
+	stream.clear();
+	streamCount = 0;
+}
+
+
+
+void ParticleSystem::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+}
+
+
+
+const Billboard *ParticleSystem::billboards() const
+{
+	return stream.data();
+}
+
+
+
+unsigned ParticleSystem::billboardCount() const
+{
+	return streamCount;
+}
+
+
+
+// xorshift32, liten och snabb och med eget tillstånd per emitter
+float ParticleSystem::random01(unsigned &state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state >> 8) * (1.0f / 16777216);
+}
+
+
+
+void ParticleSystem::spawn(Pool &pool, float dt)
+{
+	const ParticleEmitterSettings &settings = pool.settings;
+	pool.spawnDebt += settings.rate * dt;
+	unsigned wanted = unsigned(pool.spawnDebt);
+	pool.spawnDebt -= wanted;
+	unsigned end = std::min(pool.count + wanted, pool.capacity);
+
+	for (unsigned i = pool.count; i < end; i++)
+	{
+		// Jämnt fördelad riktning på enhetssfären
+		float z = 2 * random01(pool.random) - 1;
+		float angle = 6.28318531f * random01(pool.random);
+		float ring = sqrtf(1 - z * z);
+		float direction[3] = { ring * cosf(angle), ring * sinf(angle), z };
+		float speed = settings.speedMin + (settings.speedMax - settings.speedMin) * random01(pool.random);
+		float lifetime = settings.lifetimeMin + (settings.lifetimeMax - settings.lifetimeMin) * random01(pool.random);
+
+		pool.x[i] = settings.position[0] + direction[0] * settings.spawnRadius;
+		pool.y[i] = settings.position[1] + direction[1] * settings.spawnRadius;
+		pool.z[i] = settings.position[2] + direction[2] * settings.spawnRadius;
+		pool.vx[i] = settings.velocity[0] + direction[0] * speed;
+		pool.vy[i] = settings.velocity[1] + direction[1] * speed;
+		pool.vz[i] = settings.velocity[2] + direction[2] * speed;
+		pool.age[i] = 0;
+		pool.inverseLifetime[i] = 1 / lifetime;
+	}
+	pool.count = end;
+}
+
+
+
+// En axel i taget, så att varje loop bara läser och skriver två arrayer
+static void integrateAxis(float *position, float *velocity, unsigned count, float acceleration, float damping, float dt)
+{
+	for (unsigned i = 0; i < count; i++)
+	{
+		velocity[i] = velocity[i] * damping + acceleration * dt;
+		position[i] += velocity[i] * dt;
+	}
+}
+
+
+
+void ParticleSystem::integrate(Pool &pool, float dt)
+{
+	const ParticleEmitterSettings &settings = pool.settings;
+	float damping = std::max(0.0f, 1 - settings.drag * dt);
+	integrateAxis(pool.x.data(), pool.vx.data(), pool.count, settings.acceleration[0], damping, dt);
+	integrateAxis(pool.y.data(), pool.vy.data(), pool.count, settings.acceleration[1], damping, dt);
+	integrateAxis(pool.z.data(), pool.vz.data(), pool.count, settings.acceleration[2], damping, dt);
+
+	float *age = pool.age.data();
+	for (unsigned i = 0; i < pool.count; i++)
+		age[i] += dt;
+}
+
+
+
+// Kontrollpunkten väljs så att kurvan går genom middle när phase är 0.5
+static void evaluateCurve(const ParticleCurve &curve, const float *phase, float *out, unsigned count)
+{
+	float start = curve.start, control = 2 * curve.middle - (curve.start + curve.end) * 0.5f, end = curve.end;
+	for (unsigned i = 0; i < count; i++)
+	{
+		float t = phase[i], s = 1 - t;
+		out[i] = s * s * start + 2 * s * t * control + t * t * end;
+	}
+}
+
+
+
+void ParticleSystem::evaluateCurves(Pool &pool)
+{
+	const float *age = pool.age.data(), *inverseLifetime = pool.inverseLifetime.data();
+	float *phase = pool.phase.data();
+	for (unsigned i = 0; i < pool.count; i++)
+		phase[i] = std::min(age[i] * inverseLifetime[i], 1.0f);
+
+	const ParticleEmitterSettings &settings = pool.settings;
+	evaluateCurve(settings.size, phase, pool.size.data(), pool.count);
+	evaluateCurve(settings.red, phase, pool.red.data(), pool.count);
+	evaluateCurve(settings.green, phase, pool.green.data(), pool.count);
+	evaluateCurve(settings.blue, phase, pool.blue.data(), pool.count);
+	evaluateCurve(settings.alpha, phase, pool.alpha.data(), pool.count);
+}
+
+
+
+// Döda partiklar ersätts med den sista levande, så poolen hålls tät utan att något flyttas
+// mer än en gång. Kurvorna räknas om efteråt och behöver inte flyttas med.
+void ParticleSystem::removeDead(Pool &pool)
+{
+	unsigned i = 0;
+	while (i < pool.count)
+	{
+		if (pool.age[i] * pool.inverseLifetime[i] < 1)
+		{
+			i++;
+			continue;
+		}
+
+		unsigned last = --pool.count;
+		pool.x[i] = pool.x[last];
+		pool.y[i] = pool.y[last];
+		pool.z[i] = pool.z[last];
+		pool.vx[i] = pool.vx[last];
+		pool.vy[i] = pool.vy[last];
+		pool.vz[i] = pool.vz[last];
+		pool.age[i] = pool.age[last];
+		pool.inverseLifetime[i] = pool.inverseLifetime[last];
+	}
+}
+
+
+
+void ParticleSystem::updatePool(unsigned index, float dt)
+{
+	Pool &pool = pools[index];
+	integrate(pool, dt);
+	removeDead(pool);
+	spawn(pool, dt);
+	evaluateCurves(pool);
+}
+
+
+
+static GLubyte toByte(float value)
+{
+	return GLubyte(std::min(std::max(value, 0.0f), 1.0f) * 255 + 0.5f);
+}
+
+
+
+void ParticleSystem::writeBillboards(unsigned index)
+{
+	const Pool &pool = pools[index];
+	Billboard *out = stream.data() + offsets[index];
+	for (unsigned i = 0; i < pool.count; i++)
+	{
+		out[i].x = pool.x[i];
+		out[i].y = pool.y[i];
+		out[i].z = pool.z[i];
+		out[i].size = pool.size[i];
+		out[i].color[0] = toByte(pool.red[i]);
+		out[i].color[1] = toByte(pool.green[i]);
+		out[i].color[2] = toByte(pool.blue[i]);
+		out[i].color[3] = toByte(pool.alpha[i]);
+	}
+}
+
+
+
+void ParticleSystem::update(float dt)
+{
+	PROFILE_SCOPE("ParticleSystem::update");
+
+	unsigned emitters = pools.size();
+	if (threadPool)
+		threadPool->parallelFor(emitters, [&](unsigned i) { updatePool(i, dt); });
+	else
+	{
+		for (unsigned i = 0; i < emitters; i++)
+			updatePool(i, dt);
+	}
+
+	// Poolernas platser i strömmen följer av hur många som lever, så de bestäms mellan passen
+	streamCount = 0;
+	for (unsigned i = 0; i < emitters; i++)
+	{
+		offsets[i] = streamCount;
+		streamCount += pools[i].count;
+	}
+
+	if (threadPool)
+		threadPool->parallelFor(emitters, [&](unsigned i) { writeBillboards(i); });
+	else
+	{
+		for (unsigned i = 0; i < emitters; i++)
+			writeBillboards(i);
+	}
+}
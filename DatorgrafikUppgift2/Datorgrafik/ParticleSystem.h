@@ -0,0 +1,94 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+
+
+#include "BillboardBatcher.h"
+#include "ThreadPool.h"
+#include <vector>
+
+
+
+// Ett värde som ändras under partikelns liv, given vid födseln, halvvägs och vid döden.
+// Det räknas som en kvadratisk Bézierkurva, så det blir samma aritmetik för alla partiklar
+// utan tabelluppslag och loopen kan vektoriseras.
+struct ParticleCurve
+{
+	float start, middle, end;
+};
+
+
+
+// Inställningarna för en emitter. Tiden är i samma enhet som dt i update. Konstruktorn
+// ger en vit partikel per tidsenhet som står still och lever en tidsenhet.
+struct ParticleEmitterSettings
+{
+	ParticleEmitterSettings();
+
+	float position[3];
+	float spawnRadius;						// Partiklarna föds på en sfär med den här radien kring position
+	float rate;								// Partiklar per tidsenhet
+	float lifetimeMin, lifetimeMax;
+	float speedMin, speedMax;				// Fart rakt ut från position
+	float velocity[3];						// Läggs till alla nya partiklar, t.ex. emitterns egen fart
+	float acceleration[3];
+	float drag;								// Andel av farten som försvinner per tidsenhet
+	ParticleCurve size, red, green, blue, alpha;
+};
+
+
+
+// Partikelsystem med en pool med fast kapacitet per emitter. Partiklarna ligger i separata
+// arrayer (SoA) som allokeras en gång; en död partikel ersätts med den sista i poolen, så
+// de levande ligger alltid först och inget allokeras medan systemet körs. Är poolen full
+// föds inga nya partiklar.
+//
+// update kör varje emitter som en uppgift i trådpoolen: födslar, integration, kurvor och
+// livslängd är var sin enkel loop över arrayerna som kompilatorn kan vektorisera. Sist
+// skrivs alla levande partiklar tätt packade till en Billboard-ström för BillboardBatcher.
+class ParticleSystem
+{
+public:
+	ParticleSystem();
+
+	unsigned addEmitter(const ParticleEmitterSettings &settings, unsigned capacity);
+	ParticleEmitterSettings &settings(unsigned emitter);	// För att t.ex. flytta en emitter mellan bildrutorna
+	unsigned emitterCount() const;
+	void clear();
+
+	void setThreadPool(ThreadPool *pool);	// NULL kör allt på den anropande tråden
+
+	void update(float dt);
+
+	const Billboard *billboards() const;
+	unsigned billboardCount() const;		// Antal levande partiklar
+
+private:
+	struct Pool
+	{
+		ParticleEmitterSettings settings;
+		unsigned capacity, count;
+		float spawnDebt;					// Delar av partiklar som inte hunnit födas än
+		unsigned random;					// Egen slumpgenerator, rand() är inte trådsäker
+		std::vector<float> x, y, z, vx, vy, vz, age, inverseLifetime;
+		std::vector<float> phase, size, red, green, blue, alpha;	// phase är ålder / livslängd, 0 till 1
+	};
+
+	static float random01(unsigned &state);
+	static void spawn(Pool &pool, float dt);
+	static void integrate(Pool &pool, float dt);
+	static void evaluateCurves(Pool &pool);
+	static void removeDead(Pool &pool);
+	void updatePool(unsigned index, float dt);
+	void writeBillboards(unsigned index);
+
+	std::vector<Pool> pools;
+	std::vector<unsigned> offsets;			// Var varje pools partiklar börjar i strömmen
+	std::vector<Billboard> stream;
+	unsigned streamCount;
+	ThreadPool *threadPool;
+};
+
+
+
+#endif
@@ -0,0 +1,568 @@
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <GL/gl.h>
+#else
+#include <GL/gl.h>
+#include <GL/glx.h>
+#endif
+
+
+
+// En ringbuffert per tråd. Bara ägartråden skriver (head) och bara huvudtråden
+// läser (tail), så det räcker med atomiska index och inga lås.
+static const unsigned ringSize = 4096;
+
+struct ProfileRing
+{
+	ProfileSample samples[ringSize];
+	std::atomic<unsigned> head, tail;
+	unsigned short thread;
+	unsigned short depth;
+	unsigned dropped;
+};
+
+// Summerad tid per zon och räknarnas värden för varje bildruta.
+struct ProfileFrame
+{
+	double frameTime;
+	std::vector<double> zoneTimes;
+	std::vector<double> counters;
+};
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+static bool enabled = false;
+static bool reporting = false;
+static const char *outputFile = NULL;
+static const char *label = NULL;
+static FILE *traceFile = NULL;
+static unsigned tracedThreads = 0;
+static std::mutex ringMutex;				// Används bara när en ny tråd registrerar sin buffert
+static std::vector<ProfileRing*> rings;
+static thread_local ProfileRing *threadRing = NULL;
+
+static std::vector<const char*> zoneNames;
+static std::vector<double> currentZoneTimes;
+static std::vector<ProfileFrame> frames;
+static double lastFrameEnd = 0;
+
+static std::vector<const char*> counterNames;
+static std::vector<double> counterValues;
+
+
+
+static ProfileRing *getThreadRing()
+{
+	if (!threadRing)
+	{
+		threadRing = new ProfileRing();
+		threadRing->head = 0;
+		threadRing->tail = 0;
+		threadRing->depth = 0;
+		threadRing->dropped = 0;
+
+		std::lock_guard<std::mutex> lock(ringMutex);
+		threadRing->thread = (unsigned short)rings.size();
+		rings.push_back(threadRing);
+	}
+	return threadRing;
+}
+
+
+
+static unsigned zoneIndex(const char *name)
+{
+	for (unsigned i = 0; i < zoneNames.size(); i++)
+		if (zoneNames[i] == name || strcmp(zoneNames[i], name) == 0)
+			return i;
+
+	zoneNames.push_back(name);
+	currentZoneTimes.push_back(0);
+	return zoneNames.size() - 1;
+}
+
+
+
+static void addZoneTime(const char *name, double microseconds)
+{
+	currentZoneTimes[zoneIndex(name)] += microseconds;
+}
+
+
+
+ProfileScope::ProfileScope(const char *name)
+{
+	this->name = name;
+	if (!enabled)
+	{
+		start = -1;
+		return;
+	}
+
+	getThreadRing()->depth++;
+	start = profilerNow();
+}
+
+
+
+ProfileScope::~ProfileScope()
+{
+	if (start < 0)
+		return;
+
+	ProfileSample sample;
+	sample.name = name;
+	sample.start = start;
+	sample.end = profilerNow();
+
+	ProfileRing *ring = getThreadRing();
+	ring->depth--;
+	sample.thread = ring->thread;
+	sample.depth = ring->depth;
+
+	unsigned head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) >= ringSize)
+	{
+		ring->dropped++;		// Hellre tappa mätningar än att blockera tråden
+		return;
+	}
+	ring->samples[head % ringSize] = sample;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+
+
+void profilerSetLabel(const char *text)
+{
+	label = text;
+}
+
+
+
+void profilerStart(const char *file)
+{
+	enabled = true;
+	reporting = true;
+	outputFile = file;
+	lastFrameEnd = profilerNow();
+}
+
+
+
+// Spåret skrivs i Chromes JSON-arrayformat. Den avslutande ] är valfri i det
+// formatet, så filen går att öppna även om programmet avslutas abrupt.
+bool profilerStartTrace(const char *file)
+{
+	traceFile = fopen(file, "w");
+	if (!traceFile)
+		return false;
+
+	setvbuf(traceFile, NULL, _IOFBF, 1 << 16);
+	fprintf(traceFile, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Datorgrafik\"}}");
+
+	if (!enabled)
+		lastFrameEnd = profilerNow();
+	enabled = true;
+	return true;
+}
+
+
+
+bool profilerEnabled()
+{
+	return enabled;
+}
+
+
+
+bool profilerReporting()
+{
+	return reporting;
+}
+
+
+
+double profilerNow()
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+
+
+void profilerCount(const char *name, double value)
+{
+	if (!enabled)
+		return;
+
+	for (unsigned i = 0; i < counterNames.size(); i++)
+	{
+		if (counterNames[i] == name || strcmp(counterNames[i], name) == 0)
+		{
+			counterValues[i] += value;
+			return;
+		}
+	}
+	counterNames.push_back(name);
+	counterValues.push_back(value);
+}
+
+
+
+static void traceSample(const ProfileSample &sample)
+{
+	fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+		sample.name, sample.start, sample.end - sample.start, (unsigned)sample.thread);
+}
+
+
+
+static void traceFrame(double now)
+{
+	for (; tracedThreads < rings.size(); tracedThreads++)
+		fprintf(traceFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			tracedThreads, tracedThreads ? "worker" : "main", tracedThreads);
+
+	fprintf(traceFile, ",\n{\"name\":\"frame %u\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}",
+		(unsigned)frames.size(), now);
+
+	for (unsigned i = 0; i < counterNames.size(); i++)
+		fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%g}}",
+			counterNames[i], now, counterValues[i]);
+}
+
+
+
+void profilerEndFrame()
+{
+	if (!enabled)
+		return;
+
+	std::vector<ProfileRing*> currentRings;
+	{
+		std::lock_guard<std::mutex> lock(ringMutex);
+		currentRings = rings;
+		if (traceFile)
+			traceFrame(profilerNow());
+	}
+
+	for (unsigned i = 0; i < currentRings.size(); i++)
+	{
+		ProfileRing *ring = currentRings[i];
+		unsigned tail = ring->tail.load(std::memory_order_relaxed);
+		unsigned head = ring->head.load(std::memory_order_acquire);
+		for (; tail != head; tail++)
+		{
+			const ProfileSample &sample = ring->samples[tail % ringSize];
+			addZoneTime(sample.name, sample.end - sample.start);
+			if (traceFile)
+				traceSample(sample);
+		}
+		ring->tail.store(tail, std::memory_order_release);
+	}
+
+	double now = profilerNow();
+	ProfileFrame frame;
+	frame.frameTime = now - lastFrameEnd;
+	frame.zoneTimes = currentZoneTimes;
+	frame.counters = counterValues;
+	frames.push_back(frame);
+	lastFrameEnd = now;
+
+	std::fill(currentZoneTimes.begin(), currentZoneTimes.end(), 0.0);
+	std::fill(counterValues.begin(), counterValues.end(), 0.0);
+}
+
+
+
+// GPU-tider mäts med GL_TIME_ELAPSED (ARB_timer_query). Resultaten läses några
+// bildrutor i efterhand så att vi aldrig väntar på GPU:n.
+#ifndef __APPLE__
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+typedef void (APIENTRY *GenQueriesProc)(GLsizei n, GLuint *ids);
+typedef void (APIENTRY *BeginQueryProc)(GLenum target, GLuint id);
+typedef void (APIENTRY *EndQueryProc)(GLenum target);
+typedef void (APIENTRY *GetQueryObjectui64vProc)(GLuint id, GLenum pname, unsigned long long *params);
+
+static GenQueriesProc genQueries = NULL;
+static BeginQueryProc beginQuery = NULL;
+static EndQueryProc endQuery = NULL;
+static GetQueryObjectui64vProc getQueryObjectui64v = NULL;
+
+static void *getProcAddress(const char *name)
+{
+#ifdef _WIN32
+	return (void*)wglGetProcAddress(name);
+#else
+	return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+#endif
+
+static const int gpuQueryCount = 4;
+static GLuint gpuQueries[gpuQueryCount];
+static bool gpuPending[gpuQueryCount];
+static int gpuIndex = 0;
+static int gpuState = 0;	// 0 = inte undersökt, 1 = tillgängligt, -1 = saknas
+
+
+
+static bool gpuTimersAvailable()
+{
+	if (gpuState != 0)
+		return gpuState > 0;
+
+	gpuState = -1;
+#ifndef __APPLE__
+	const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+	if (!extensions || !strstr(extensions, "GL_ARB_timer_query"))
+		return false;
+
+	genQueries = (GenQueriesProc)getProcAddress("glGenQueries");
+	beginQuery = (BeginQueryProc)getProcAddress("glBeginQuery");
+	endQuery = (EndQueryProc)getProcAddress("glEndQuery");
+	getQueryObjectui64v = (GetQueryObjectui64vProc)getProcAddress("glGetQueryObjectui64v");
+	if (!genQueries || !beginQuery || !endQuery || !getQueryObjectui64v)
+		return false;
+
+	genQueries(gpuQueryCount, gpuQueries);
+	for (int i = 0; i < gpuQueryCount; i++)
+		gpuPending[i] = false;
+	gpuState = 1;
+#endif
+	return gpuState > 0;
+}
+
+
+
+void profilerGpuBegin()
+{
+	if (!enabled || !gpuTimersAvailable())
+		return;
+
+#ifndef __APPLE__
+	if (gpuPending[gpuIndex])
+	{
+		unsigned long long nanoseconds = 0;
+		getQueryObjectui64v(gpuQueries[gpuIndex], GL_QUERY_RESULT, &nanoseconds);
+		addZoneTime("gpu", nanoseconds / 1000.0);
+		gpuPending[gpuIndex] = false;
+	}
+	beginQuery(GL_TIME_ELAPSED, gpuQueries[gpuIndex]);
+#endif
+}
+
+
+
+void profilerGpuEnd()
+{
+	if (!enabled || gpuState <= 0)
+		return;
+
+#ifndef __APPLE__
+	endQuery(GL_TIME_ELAPSED);
+	gpuPending[gpuIndex] = true;
+	gpuIndex = (gpuIndex + 1) % gpuQueryCount;
+#endif
+}
+
+
+
+static double percentile(std::vector<double> values, double p)
+{
+	if (values.empty())
+		return 0;
+
+	size_t index = size_t(p * (values.size() - 1) + 0.5);
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+
+
+// Zonernas värden i rapporterna är i millisekunder, räknarnas i antal per bildruta.
+struct ProfileSummary
+{
+	const char *name;
+	double average, p50, p95, p99, max;
+};
+
+static ProfileSummary summarize(const char *name, const std::vector<double> &values)
+{
+	ProfileSummary summary;
+	summary.name = name;
+	summary.average = 0;
+	summary.max = 0;
+	for (unsigned i = 0; i < values.size(); i++)
+	{
+		summary.average += values[i];
+		summary.max = std::max(summary.max, values[i]);
+	}
+	if (!values.empty())
+		summary.average /= values.size();
+	summary.p50 = percentile(values, 0.50);
+	summary.p95 = percentile(values, 0.95);
+	summary.p99 = percentile(values, 0.99);
+	return summary;
+}
+
+static std::vector<ProfileSummary> summarizeAll()
+{
+	std::vector<ProfileSummary> summaries;
+	std::vector<double> values(frames.size());
+
+	for (unsigned f = 0; f < frames.size(); f++)
+		values[f] = frames[f].frameTime / 1000.0;
+	summaries.push_back(summarize("frame", values));
+
+	for (unsigned z = 0; z < zoneNames.size(); z++)
+	{
+		for (unsigned f = 0; f < frames.size(); f++)
+			values[f] = z < frames[f].zoneTimes.size() ? frames[f].zoneTimes[z] / 1000.0 : 0;
+		summaries.push_back(summarize(zoneNames[z], values));
+	}
+	return summaries;
+}
+
+static std::vector<ProfileSummary> summarizeCounters()
+{
+	std::vector<ProfileSummary> summaries;
+	std::vector<double> values(frames.size());
+
+	for (unsigned c = 0; c < counterNames.size(); c++)
+	{
+		for (unsigned f = 0; f < frames.size(); f++)
+			values[f] = c < frames[f].counters.size() ? frames[f].counters[c] : 0;
+		summaries.push_back(summarize(counterNames[c], values));
+	}
+	return summaries;
+}
+
+
+
+static bool writeCsv(const char *file)
+{
+	FILE *out = fopen(file, "w");
+	if (!out)
+		return false;
+
+	fprintf(out, "frame,frame_ms");
+	for (unsigned z = 0; z < zoneNames.size(); z++)
+		fprintf(out, ",%s_ms", zoneNames[z]);
+	for (unsigned c = 0; c < counterNames.size(); c++)
+		fprintf(out, ",%s", counterNames[c]);
+	fprintf(out, "\n");
+
+	for (unsigned f = 0; f < frames.size(); f++)
+	{
+		fprintf(out, "%u,%.4f", f, frames[f].frameTime / 1000.0);
+		for (unsigned z = 0; z < zoneNames.size(); z++)
+			fprintf(out, ",%.4f", z < frames[f].zoneTimes.size() ? frames[f].zoneTimes[z] / 1000.0 : 0.0);
+		for (unsigned c = 0; c < counterNames.size(); c++)
+			fprintf(out, ",%g", c < frames[f].counters.size() ? frames[f].counters[c] : 0.0);
+		fprintf(out, "\n");
+	}
+
+	fclose(out);
+	return true;
+}
+
+
+
+static bool writeJson(const char *file)
+{
+	FILE *out = fopen(file, "w");
+	if (!out)
+		return false;
+
+	std::vector<ProfileSummary> summaries = summarizeAll();
+	std::vector<ProfileSummary> counters = summarizeCounters();
+	fprintf(out, "{\n");
+	if (label)
+		fprintf(out, "  \"label\": \"%s\",\n", label);
+	fprintf(out, "  \"frames\": %u,\n  \"zones\": {\n", (unsigned)frames.size());
+	for (unsigned i = 0; i < summaries.size(); i++)
+	{
+		const ProfileSummary &s = summaries[i];
+		fprintf(out, "    \"%s\": { \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+			s.name, s.average, s.p50, s.p95, s.p99, s.max, i + 1 < summaries.size() ? "," : "");
+	}
+	fprintf(out, "  },\n  \"counters\": {\n");
+	for (unsigned i = 0; i < counters.size(); i++)
+	{
+		const ProfileSummary &s = counters[i];
+		fprintf(out, "    \"%s\": { \"avg\": %.1f, \"p50\": %.1f, \"p95\": %.1f, \"max\": %.1f }%s\n",
+			s.name, s.average, s.p50, s.p95, s.max, i + 1 < counters.size() ? "," : "");
+	}
+	fprintf(out, "  },\n  \"frameTimes\": [");
+	for (unsigned f = 0; f < frames.size(); f++)
+		fprintf(out, "%s%.4f", f ? ", " : "", frames[f].frameTime / 1000.0);
+	fprintf(out, "]\n}\n");
+
+	fclose(out);
+	return true;
+}
+
+
+
+void profilerFinish()
+{
+	if (traceFile)
+	{
+		fprintf(traceFile, "\n]\n");
+		fclose(traceFile);
+		traceFile = NULL;
+	}
+
+	if (!enabled || !reporting || frames.empty())
+		return;
+	enabled = false;
+
+	std::vector<ProfileSummary> summaries = summarizeAll();
+	if (label)
+		printf("%s\n", label);
+	printf("%-16s %10s %10s %10s %10s %10s   (ms, %u frames)\n", "zone", "avg", "p50", "p95", "p99", "max", (unsigned)frames.size());
+	for (unsigned i = 0; i < summaries.size(); i++)
+	{
+		const ProfileSummary &s = summaries[i];
+		printf("%-16s %10.3f %10.3f %10.3f %10.3f %10.3f\n", s.name, s.average, s.p50, s.p95, s.p99, s.max);
+	}
+
+	std::vector<ProfileSummary> counters = summarizeCounters();
+	if (!counters.empty())
+		printf("%-16s %10s %10s %10s %10s   (per frame)\n", "counter", "avg", "p50", "p95", "max");
+	for (unsigned i = 0; i < counters.size(); i++)
+	{
+		const ProfileSummary &s = counters[i];
+		printf("%-16s %10.1f %10.1f %10.1f %10.1f\n", s.name, s.average, s.p50, s.p95, s.max);
+	}
+
+	std::lock_guard<std::mutex> lock(ringMutex);
+	unsigned dropped = 0;
+	for (unsigned i = 0; i < rings.size(); i++)
+		dropped += rings[i]->dropped;
+	if (dropped)
+		printf("%u samples dropped (ring buffer full)\n", dropped);
+
+	if (outputFile)
+	{
+		size_t length = strlen(outputFile);
+		bool csv = length > 4 && strcmp(outputFile + length - 4, ".csv") == 0;
+		if (!(csv ? writeCsv(outputFile) : writeJson(outputFile)))
+			printf("Could not write profile: %s\n", outputFile);
+	}
+}
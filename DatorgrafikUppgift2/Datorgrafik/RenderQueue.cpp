@@ -0,0 +1,143 @@
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include "Profiler.h"
+#include <string.h>
+
+
+
+// Nyckelns layout, från mest till minst signifikanta bit:
+//   63-60  pass
+//   59     genomskinlig
+//   58-35  ogenomskinlig: material   genomskinlig: inverterat djup
+//   23-0   ogenomskinlig: djup       genomskinlig: material
+static const int passShift = 60;
+static const int transparentShift = 59;
+static const int highShift = 35;
+static const unsigned long long fieldMask = 0xFFFFFF;
+
+
+
+// Avståndet längs kamerans blickriktning kvantiserat till 24 bitar. För positiva
+// flyttal växer bitmönstret med värdet, så de översta bitarna går att jämföra direkt.
+static unsigned long long depthBits(const float *matrix)
+{
+	float depth = -matrix[14];
+	if (!(depth > 0))
+		return 0;
+
+	unsigned int bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return bits >> 7;
+}
+
+
+
+unsigned long long RenderQueue::sortKey(const DrawPacket &packet)
+{
+	unsigned long long material = ((unsigned long long)(packet.texture & 0x7FFFFF) << 1) | (packet.lit ? 1 : 0);
+	unsigned long long depth = depthBits(packet.matrix);
+	unsigned long long key = (unsigned long long)(packet.pass & 0xF) << passShift;
+
+	if (packet.transparent)
+		key |= (1ULL << transparentShift) | ((fieldMask - depth) << highShift) | material;
+	else
+		key |= (material << highShift) | depth;
+
+	return key;
+}
+
+
+
+void RenderQueue::clear()
+{
+	packets.clear();
+	entries.clear();
+}
+
+
+
+void RenderQueue::add(const DrawPacket &packet)
+{
+	SortEntry entry;
+	entry.key = sortKey(packet);
+	entry.index = packets.size();
+
+	packets.push_back(packet);
+	entries.push_back(entry);
+}
+
+
+
+// LSD-radixsortering med 8 bitar per svep. Svep där alla nycklar har samma
+// siffra hoppas över, vilket är vanligt för de höga bitarna.
+void RenderQueue::sort()
+{
+	PROFILE_SCOPE("RenderQueue::sort");
+
+	scratch.resize(entries.size());
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned counts[256] = { 0 };
+		for (unsigned i = 0; i < entries.size(); i++)
+			counts[(entries[i].key >> shift) & 0xFF]++;
+
+		if (entries.empty() || counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+			continue;
+
+		unsigned offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			unsigned count = counts[digit];
+			counts[digit] = offset;
+			offset += count;
+		}
+
+		for (unsigned i = 0; i < entries.size(); i++)
+			scratch[counts[(entries[i].key >> shift) & 0xFF]++] = entries[i];
+
+		entries.swap(scratch);
+	}
+}
+
+
+
+void RenderQueue::submit()
+{
+	PROFILE_SCOPE("RenderQueue::submit");
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+
+	for (unsigned i = 0; i < entries.size(); i++)
+	{
+		const DrawPacket &packet = packets[entries[i].index];
+
+		if (packet.lit)
+			enableState(GL_LIGHT1);
+		else
+			disableState(GL_LIGHT1);
+		bindTexture(packet.texture);
+
+		glColor4fv(packet.color);
+		glLoadMatrixf(packet.matrix);
+		packet.draw(packet);
+	}
+
+	glPopMatrix();
+	glColor4f(1, 1, 1, 1);
+}
+
+
+
+unsigned RenderQueue::size() const
+{
+	return packets.size();
+}
+
+
+
+void captureModelview(float *matrix)
+{
+	glGetFloatv(GL_MODELVIEW_MATRIX, matrix);
+}
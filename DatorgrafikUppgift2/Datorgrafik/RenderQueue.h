@@ -0,0 +1,61 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+
+
+#include "Support.h"
+#include <vector>
+
+
+
+struct DrawPacket;
+typedef void (*DrawFunction)(const DrawPacket &packet);
+
+// Ett ritanrop med allt som behövs för att kunna rita det i godtycklig ordning.
+struct DrawPacket
+{
+	float matrix[16];		// Modelview-matrisen, kolumnvis som i OpenGL
+	float color[4];
+	GLuint texture;
+	bool lit;				// Om GL_LIGHT1 ska vara aktiverat
+	bool transparent;
+	unsigned char pass;		// Högre pass ritas senare, oavsett allt annat
+	DrawFunction draw;
+	float size;				// Parameter till draw, t.ex. en sfärs radie
+};
+
+
+
+// Samlar ritanrop under en bildruta, sorterar dem på en 64-bitars nyckel och
+// skickar dem sedan till GL i ett enda linjärt svep. Ogenomskinliga objekt
+// sorteras på material och sedan framifrån och bakåt, genomskinliga bakifrån och fram.
+class RenderQueue
+{
+public:
+	void clear();
+	void add(const DrawPacket &packet);
+	void sort();
+	void submit();
+
+	unsigned size() const;
+
+	static unsigned long long sortKey(const DrawPacket &packet);
+
+private:
+	struct SortEntry
+	{
+		unsigned long long key;
+		unsigned index;
+	};
+
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> entries, scratch;
+};
+
+
+
+void captureModelview(float *matrix);	// Hämtar aktuell modelview-matris till ett paket
+
+
+
+#endif
@@ -0,0 +1,196 @@
+#include "RenderState.h"
+#include "Profiler.h"
+
+
+
+static const int unknown = -1;
+
+// Av- och påslagna tillstånd lagras som par (tillstånd, värde). Det är bara en
+// handfull olika tillstånd i programmen så en linjär sökning räcker gott.
+struct CapState
+{
+	GLenum cap;
+	int enabled;
+};
+
+static const int maxCaps = 32;
+static CapState caps[maxCaps];
+static int capCount = 0;
+static CapState clientArrays[maxCaps];
+static int clientArrayCount = 0;
+
+static int depthMask = unknown;
+static int polygonModeFront = unknown, polygonModeBack = unknown;
+static int blendSource = unknown, blendDestination = unknown;
+static GLuint boundTexture = 0;
+static bool textureKnown = false;
+
+static unsigned issued = 0;
+static unsigned filtered = 0;
+
+
+
+// Returnerar true om anropet behöver skickas och uppdaterar räknarna.
+static bool changed(bool needed)
+{
+	if (needed)
+	{
+		issued++;
+		PROFILE_COUNT("stateCalls", 1);
+	}
+	else
+	{
+		filtered++;
+		PROFILE_COUNT("stateCallsFiltered", 1);
+	}
+	return needed;
+}
+
+
+
+static int &findCap(CapState *table, int &count, GLenum cap)
+{
+	for (int i = 0; i < count; i++)
+		if (table[i].cap == cap)
+			return table[i].enabled;
+
+	if (count == maxCaps)			// Fullt, låt anropet alltid gå igenom
+	{
+		static int overflow;
+		overflow = unknown;
+		return overflow;
+	}
+
+	table[count].cap = cap;
+	table[count].enabled = unknown;
+	return table[count++].enabled;
+}
+
+
+
+void renderStateReset()
+{
+	capCount = 0;
+	clientArrayCount = 0;
+	depthMask = unknown;
+	polygonModeFront = unknown;
+	polygonModeBack = unknown;
+	blendSource = unknown;
+	blendDestination = unknown;
+	textureKnown = false;
+}
+
+
+
+void enableState(GLenum cap)
+{
+	int &state = findCap(caps, capCount, cap);
+	if (changed(state != 1))
+	{
+		glEnable(cap);
+		state = 1;
+	}
+}
+
+
+
+void disableState(GLenum cap)
+{
+	int &state = findCap(caps, capCount, cap);
+	if (changed(state != 0))
+	{
+		glDisable(cap);
+		state = 0;
+	}
+}
+
+
+
+void enableClientArray(GLenum array)
+{
+	int &state = findCap(clientArrays, clientArrayCount, array);
+	if (changed(state != 1))
+	{
+		glEnableClientState(array);
+		state = 1;
+	}
+}
+
+
+
+void disableClientArray(GLenum array)
+{
+	int &state = findCap(clientArrays, clientArrayCount, array);
+	if (changed(state != 0))
+	{
+		glDisableClientState(array);
+		state = 0;
+	}
+}
+
+
+
+void setDepthMask(GLboolean flag)
+{
+	if (changed(depthMask != int(flag)))
+	{
+		glDepthMask(flag);
+		depthMask = flag;
+	}
+}
+
+
+
+void setPolygonMode(GLenum face, GLenum mode)
+{
+	bool front = face == GL_FRONT || face == GL_FRONT_AND_BACK;
+	bool back = face == GL_BACK || face == GL_FRONT_AND_BACK;
+
+	if (changed((front && polygonModeFront != int(mode)) || (back && polygonModeBack != int(mode))))
+	{
+		glPolygonMode(face, mode);
+		if (front)
+			polygonModeFront = mode;
+		if (back)
+			polygonModeBack = mode;
+	}
+}
+
+
+
+void setBlendFunc(GLenum source, GLenum destination)
+{
+	if (changed(blendSource != int(source) || blendDestination != int(destination)))
+	{
+		glBlendFunc(source, destination);
+		blendSource = source;
+		blendDestination = destination;
+	}
+}
+
+
+
+void bindTexture(GLuint texture)
+{
+	if (changed(!textureKnown || boundTexture != texture))
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		PROFILE_COUNT("textureBinds", 1);
+		boundTexture = texture;
+		textureKnown = true;
+	}
+}
+
+
+
+unsigned renderStateIssued()
+{
+	return issued;
+}
+
+
+
+unsigned renderStateFiltered()
+{
+	return filtered;
+}
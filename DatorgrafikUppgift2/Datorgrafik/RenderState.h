@@ -0,0 +1,29 @@
+#ifndef RENDERSTATE_H
+#define RENDERSTATE_H
+
+
+
+#include "Support.h"
+
+
+
+// Skuggar GL-tillståndet på CPU:n och släpper bara igenom anrop som faktiskt
+// ändrar något. Allt som ändrar de här tillstånden bör gå via funktionerna
+// nedan, annars måste renderStateReset() anropas efteråt.
+void renderStateReset();				// Glömmer allt, nästa anrop skickas alltid vidare till GL
+
+void enableState(GLenum cap);
+void disableState(GLenum cap);
+void enableClientArray(GLenum array);
+void disableClientArray(GLenum array);
+void setDepthMask(GLboolean flag);
+void setPolygonMode(GLenum face, GLenum mode);
+void setBlendFunc(GLenum source, GLenum destination);
+void bindTexture(GLuint texture);
+
+unsigned renderStateIssued();			// Antal anrop som skickats till GL
+unsigned renderStateFiltered();			// Antal anrop som var onödiga och filtrerades bort
+
+
+
+#endif
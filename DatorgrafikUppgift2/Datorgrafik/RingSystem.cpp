@@ -0,0 +1,152 @@
+#include "RingSystem.h"
+#include "RenderState.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+
+
+static const float thickness = 0.003f;		// Största inklination i radianer, ger ringarna lite tjocklek
+static const GLubyte particleAlpha = 128;
+static const unsigned chunksPerThread = 8;
+static const unsigned minimumChunk = 4096;
+
+
+
+static float random01()
+{
+	return rand() / (RAND_MAX + 1.0f);
+}
+
+
+
+RingSystem::RingSystem()
+{
+	visibleCount = 0;
+	fullDensityDistance = 60;
+	threadPool = NULL;
+}
+
+
+
+void RingSystem::create(unsigned count, float innerRadius, float outerRadius, float centralMass,
+	const unsigned char *profile, unsigned profileLength)
+{
+	orbits.clear();
+	colors.clear();
+	visibleCount = 0;
+	if (profileLength == 0)
+		return;
+
+	// Radien dras jämnt över ringens yta och behålls med sannolikheten alfa / 255 i profilen.
+	// Försöken är begränsade så att en genomskinlig profil inte ger en oändlig loop.
+	unsigned attempts = count * 100;
+	while (orbits.size() < count && attempts-- > 0)
+	{
+		float radius = sqrtf(innerRadius * innerRadius + random01() * (outerRadius * outerRadius - innerRadius * innerRadius));
+		unsigned index = std::min(unsigned(radius / outerRadius * (profileLength - 1) + 0.5f), profileLength - 1);
+		const unsigned char *texel = profile + index * 4;
+		if (random01() * 255 >= texel[3])
+			continue;
+
+		orbits.add(radius, 0, thickness * random01(), 6.28318531f * random01(), 0, 6.28318531f * random01(),
+			KeplerOrbits::meanMotionFor(centralMass, radius));
+		colors.push_back(texel[0]);
+		colors.push_back(texel[1]);
+		colors.push_back(texel[2]);
+		colors.push_back(particleAlpha);
+	}
+
+	vertices.resize(orbits.size() * 3);
+}
+
+
+
+void RingSystem::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+	orbits.setThreadPool(pool);
+}
+
+
+
+void RingSystem::setFullDensityDistance(float distance)
+{
+	fullDensityDistance = distance;
+}
+
+
+
+unsigned RingSystem::size() const
+{
+	return orbits.size();
+}
+
+
+
+unsigned RingSystem::visible() const
+{
+	return visibleCount;
+}
+
+
+
+void RingSystem::packVertices(unsigned begin, unsigned end)
+{
+	const float *x = orbits.x(), *y = orbits.y(), *z = orbits.z();
+	float *out = vertices.data();
+	for (unsigned i = begin; i < end; i++)
+	{
+		out[i * 3] = x[i];
+		out[i * 3 + 1] = y[i];
+		out[i * 3 + 2] = z[i];
+	}
+}
+
+
+
+void RingSystem::update(double time, float distance)
+{
+	PROFILE_SCOPE("RingSystem::update");
+
+	float fraction = distance > fullDensityDistance ? fullDensityDistance * fullDensityDistance / (distance * distance) : 1;
+	visibleCount = std::min(size(), unsigned(size() * fraction) + 1);
+	orbits.evaluate(time, visibleCount);
+
+	unsigned chunks = threadPool ? threadPool->size() * chunksPerThread : 1;
+	chunks = std::min(chunks, visibleCount / minimumChunk);
+	if (chunks <= 1)
+	{
+		packVertices(0, visibleCount);
+		return;
+	}
+
+	unsigned count = visibleCount;
+	threadPool->parallelFor(chunks, [&](unsigned chunk)
+	{
+		packVertices(unsigned((unsigned long long)count * chunk / chunks), unsigned((unsigned long long)count * (chunk + 1) / chunks));
+	});
+}
+
+
+
+void RingSystem::draw() const
+{
+	if (visibleCount == 0)
+		return;
+
+	enableState(GL_POINT_SMOOTH);					// Runda punkter i stället för fyrkanter
+	glPointSize(2);
+	enableClientArray(GL_VERTEX_ARRAY);
+	enableClientArray(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+	glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors.data());
+	glDrawArrays(GL_POINTS, 0, visibleCount);
+	disableClientArray(GL_COLOR_ARRAY);
+	disableClientArray(GL_VERTEX_ARRAY);
+	disableState(GL_POINT_SMOOTH);
+
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", visibleCount);
+}
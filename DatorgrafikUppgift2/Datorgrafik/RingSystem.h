@@ -0,0 +1,50 @@
+#ifndef RINGSYSTEM_H
+#define RINGSYSTEM_H
+
+
+
+#include "KeplerOrbits.h"
+#include "Support.h"
+#include <vector>
+
+
+
+// Planetringar som hundratusentals partiklar på cirkulära Keplerbanor i stället för en
+// texturerad kvadrat. Banorna räknas med KeplerOrbits (SoA, vektoriserat och i trådpoolen)
+// och ritas som runda punkter i ett enda glDrawArrays.
+//
+// Partiklarna ligger i slumpvis ordning, så de n första är ett jämnt urval av hela ringen.
+// På avstånd räknas och ritas bara så många att tätheten på skärmen blir densamma som på
+// nära håll; antalet minskar med kvadraten på avståndet, precis som ringens yta på skärmen.
+class RingSystem
+{
+public:
+	RingSystem();
+
+	// profile är RGBA-färger från ringens mitt ut till outerRadius, t.ex. en rad ur ringtexturen.
+	// Alfa styr tätheten: partiklarna placeras där alfa är stort.
+	void create(unsigned count, float innerRadius, float outerRadius, float centralMass,
+		const unsigned char *profile, unsigned profileLength);
+	void setThreadPool(ThreadPool *pool);
+	void setFullDensityDistance(float distance);	// Närmare än så ritas alla partiklar
+
+	void update(double time, float distance);		// distance är kamerans avstånd till planeten
+	void draw() const;								// Ritar i planetens koordinatsystem, ringarna i xz-planet
+
+	unsigned size() const;
+	unsigned visible() const;						// Antal partiklar i senaste update
+
+private:
+	void packVertices(unsigned begin, unsigned end);
+
+	KeplerOrbits orbits;
+	std::vector<float> vertices;					// x, y, z tätt packade för glVertexPointer
+	std::vector<GLubyte> colors;					// RGBA per partikel, sätts en gång i create
+	unsigned visibleCount;
+	float fullDensityDistance;
+	ThreadPool *threadPool;
+};
+
+
+
+#endif
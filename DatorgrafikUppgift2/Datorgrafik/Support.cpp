@@ -1,4 +1,6 @@
 #include "Support.h"
+#include "Profiler.h"
+#include "RenderState.h"
 #include <stdlib.h>
 #include <iostream>
 #ifdef __APPLE__
@@ -12,6 +14,8 @@
 #ifdef __APPLE__
 void loadTexture(const char *file, GLuint *image)
 {
+	PROFILE_SCOPE("loadTexture");
+
 	glGenTextures(1, image);
 
 	CFBundleRef mainBundle = CFBundleGetMainBundle();
@@ -48,6 +52,8 @@ void loadTexture(const char *file, GLuint *image)
 #else
 void loadTexture(const char *file, GLuint *image)
 {
+	PROFILE_SCOPE("loadTexture");
+
 	ilInit();
 
 	ILuint ilImage;
@@ -83,15 +89,17 @@ void loadTexture(const char *file, GLuint *image)
 
 void drawSun(GLuint texture)
 {
-	glDisable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glDisable(GL_LIGHTING);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	PROFILE_SCOPE("drawSun");
+
+	disableState(GL_CULL_FACE);
+	enableState(GL_DEPTH_TEST);
+	setDepthMask(GL_FALSE);
+	disableState(GL_LIGHTING);
+	enableState(GL_BLEND);
+	setBlendFunc(GL_SRC_ALPHA, GL_ONE);
 
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture);
+	enableState(GL_TEXTURE_2D);
+	bindTexture(texture);
 
 	float modelview[16];
 	glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
@@ -118,7 +126,9 @@ void drawSun(GLuint texture)
 		glTexCoord2f(0.99f, 0.01f);
 		glVertex3f(0-((right[0]-up[0])*size)*3, 0-((right[1]-up[1])*size)*3, 0-((right[2]-up[2])*size)*3);
 	glEnd();
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 4);
 
-	glDepthMask(GL_TRUE);
-	glDisable(GL_BLEND);
+	setDepthMask(GL_TRUE);
+	disableState(GL_BLEND);
 }
@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+	task = NULL;
+	taskCount = 0;
+	nextTask = 0;
+	busyWorkers = 0;
+	generation = 0;
+	quit = false;
+
+	if (threads == 0)
+	{
+		unsigned cores = std::thread::hardware_concurrency();
+		threads = cores > 1 ? cores - 1 : 0;
+	}
+
+	for (unsigned i = 0; i < threads; i++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (unsigned i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+
+
+void ThreadPool::parallelFor(unsigned count, const std::function<void(unsigned)> &function)
+{
+	if (count == 0)
+		return;
+
+	// Små jobb eller en pool utan arbetare körs direkt på den anropande tråden
+	if (count == 1 || workers.empty())
+	{
+		for (unsigned i = 0; i < count; i++)
+			function(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = &function;
+		taskCount = count;
+		nextTask = 0;
+		busyWorkers = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return busyWorkers == 0; });
+	task = NULL;
+}
+
+
+
+unsigned ThreadPool::size() const
+{
+	return workers.size() + 1;
+}
+
+
+
+void ThreadPool::runTasks()
+{
+	for (;;)
+	{
+		unsigned index = nextTask++;
+		if (index >= taskCount)
+			break;
+		(*task)(index);
+	}
+}
+
+
+
+void ThreadPool::workerLoop()
+{
+	unsigned seenGeneration = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seenGeneration; });
+			if (quit)
+				return;
+			seenGeneration = generation;
+		}
+
+		runTasks();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busyWorkers == 0)
+			done.notify_one();
+	}
+}
@@ -0,0 +1,599 @@
+#include "Bvh.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+#include <xmmintrin.h>
+
+
+
+static const unsigned binCount = 16;
+
+
+
+static BoundingBox emptyBox()
+{
+	BoundingBox box = { Vector3f(1e30f, 1e30f, 1e30f), Vector3f(-1e30f, -1e30f, -1e30f) };
+	return box;
+}
+
+
+
+static void grow(BoundingBox &box, const BoundingBox &other)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		box.minimum[axis] = std::min(box.minimum[axis], other.minimum[axis]);
+		box.maximum[axis] = std::max(box.maximum[axis], other.maximum[axis]);
+	}
+}
+
+
+
+// Halva ytan räcker, SAH jämför bara kostnader med varandra
+static float halfArea(const BoundingBox &box)
+{
+	Vector3f size = box.maximum - box.minimum;
+	return size.x() * size.y() + size.y() * size.z() + size.z() * size.x();
+}
+
+
+
+// Sant om lådan ligger helt på utsidan av något av stympens plan
+static bool boxOutside(const Frustum &frustum, const BoundingBox &box)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const Vector4f &plane = frustum.planes[i];
+		float x = plane.x() > 0 ? box.maximum.x() : box.minimum.x();
+		float y = plane.y() > 0 ? box.maximum.y() : box.minimum.y();
+		float z = plane.z() > 0 ? box.maximum.z() : box.minimum.z();
+		if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0)
+			return true;
+	}
+	return false;
+}
+
+
+
+static bool boxesOverlap(const BoundingBox &a, const BoundingBox &b)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (a.minimum[axis] > b.maximum[axis] || a.maximum[axis] < b.minimum[axis])
+			return false;
+	}
+	return true;
+}
+
+
+
+// Bitmask med de platser i noden som har ett barn
+static unsigned validMask(const unsigned *children, unsigned empty)
+{
+	return (children[0] != empty ? 1 : 0) | (children[1] != empty ? 2 : 0) | (children[2] != empty ? 4 : 0) | (children[3] != empty ? 8 : 0);
+}
+
+
+
+void Bvh::build(const BoundingBox *newBoxes, unsigned count)
+{
+	PROFILE_SCOPE("Bvh::build");
+
+	boxes.assign(newBoxes, newBoxes + count);
+	centers.resize(count);
+	objects.resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		centers[i] = (boxes[i].minimum + boxes[i].maximum) * 0.5f;
+		objects[i] = i;
+	}
+
+	nodes.clear();
+	parents.clear();
+	objectLeaves.resize(count);
+	if (count > 0)
+	{
+		nodes.reserve(count / 2 + 1);
+		parents.reserve(count / 2 + 1);
+		buildNode(0, count, noHit);
+	}
+
+	std::vector<Vector3f>().swap(centers);
+}
+
+
+
+// Delar objekten i två eller fyra delar och gör löv av de delar som är små nog
+unsigned Bvh::buildNode(unsigned begin, unsigned end, unsigned parent)
+{
+	unsigned index = nodes.size();
+	nodes.push_back(Node());
+	parents.push_back(parent);
+
+	unsigned ranges[4][2], rangeCount = 0;
+	if (end - begin <= leafSize)
+	{
+		ranges[0][0] = begin;
+		ranges[0][1] = end;
+		rangeCount = 1;
+	}
+	else
+	{
+		unsigned middle = split(begin, end);
+		unsigned halves[2][2] = { { begin, middle }, { middle, end } };
+		for (int h = 0; h < 2; h++)
+		{
+			if (halves[h][1] - halves[h][0] <= leafSize)
+			{
+				ranges[rangeCount][0] = halves[h][0];
+				ranges[rangeCount++][1] = halves[h][1];
+				continue;
+			}
+			unsigned quarter = split(halves[h][0], halves[h][1]);
+			ranges[rangeCount][0] = halves[h][0];
+			ranges[rangeCount++][1] = quarter;
+			ranges[rangeCount][0] = quarter;
+			ranges[rangeCount++][1] = halves[h][1];
+		}
+	}
+
+	for (unsigned slot = 0; slot < 4; slot++)
+	{
+		if (slot >= rangeCount)
+		{
+			nodes[index].children[slot] = emptyChild;
+			setChildBounds(nodes[index], slot, emptyBox());
+			continue;
+		}
+
+		unsigned first = ranges[slot][0], last = ranges[slot][1];
+		unsigned child;
+		if (last - first <= leafSize)
+		{
+			child = leafFlag | (first << 3) | (last - first);
+			for (unsigned i = first; i < last; i++)
+				objectLeaves[objects[i]] = (index << 2) | slot;
+		}
+		else
+			child = buildNode(first, last, (index << 2) | slot);	// nodes kan flyttas här, så inga referenser hålls över anropet
+
+		nodes[index].children[slot] = child;
+		setChildBounds(nodes[index], slot, rangeBounds(first, last));
+	}
+
+	return index;
+}
+
+
+
+// Binnad SAH: mittpunkterna sorteras i fack längs varje axel, och för varje gräns mellan
+// två fack räknas kostnaden yta * antal på båda sidor. Ger ingen delning två icke-tomma
+// delar (t.ex. när alla mittpunkter sammanfaller) delas objekten på mitten i stället.
+unsigned Bvh::split(unsigned begin, unsigned end)
+{
+	BoundingBox centerBounds = emptyBox();
+	for (unsigned i = begin; i < end; i++)
+	{
+		BoundingBox point = { centers[objects[i]], centers[objects[i]] };
+		grow(centerBounds, point);
+	}
+
+	// Alla tre axlarna binnas i samma pass över objekten
+	BoundingBox binBounds[3][binCount];
+	unsigned binObjects[3][binCount] = {};
+	float low[3], scale[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		low[axis] = centerBounds.minimum[axis];
+		float extent = centerBounds.maximum[axis] - low[axis];
+		scale[axis] = extent > 0 ? binCount / extent : 0;
+		for (unsigned b = 0; b < binCount; b++)
+			binBounds[axis][b] = emptyBox();
+	}
+
+	for (unsigned i = begin; i < end; i++)
+	{
+		unsigned object = objects[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			unsigned b = std::min(unsigned((centers[object][axis] - low[axis]) * scale[axis]), binCount - 1);
+			binObjects[axis][b]++;
+			grow(binBounds[axis][b], boxes[object]);
+		}
+	}
+
+	float bestCost = 1e30f;
+	int bestAxis = -1;
+	unsigned bestBin = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (scale[axis] == 0)
+			continue;
+
+		// Ytorna till höger om varje gräns räknas bakifrån, sedan sveper vi framifrån
+		float rightArea[binCount];
+		unsigned rightCount[binCount];
+		BoundingBox accumulated = emptyBox();
+		unsigned accumulatedCount = 0;
+		for (unsigned b = binCount - 1; b > 0; b--)
+		{
+			grow(accumulated, binBounds[axis][b]);
+			accumulatedCount += binObjects[axis][b];
+			rightArea[b] = halfArea(accumulated);
+			rightCount[b] = accumulatedCount;
+		}
+
+		accumulated = emptyBox();
+		accumulatedCount = 0;
+		for (unsigned b = 0; b < binCount - 1; b++)
+		{
+			grow(accumulated, binBounds[axis][b]);
+			accumulatedCount += binObjects[axis][b];
+			if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+				continue;
+			float cost = halfArea(accumulated) * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis >= 0)
+	{
+		const std::vector<Vector3f> &c = centers;
+		int axis = bestAxis;
+		float axisLow = low[axis], axisScale = scale[axis];
+		unsigned *middle = std::partition(&objects[begin], &objects[0] + end, [&](unsigned object)
+		{
+			return std::min(unsigned((c[object][axis] - axisLow) * axisScale), binCount - 1) <= bestBin;
+		});
+		return unsigned(middle - &objects[0]);
+	}
+
+	unsigned middle = (begin + end) / 2;
+	return middle;
+}
+
+
+
+BoundingBox Bvh::rangeBounds(unsigned begin, unsigned end) const
+{
+	BoundingBox box = emptyBox();
+	for (unsigned i = begin; i < end; i++)
+		grow(box, boxes[objects[i]]);
+	return box;
+}
+
+
+
+BoundingBox Bvh::childBounds(unsigned child) const
+{
+	if (child & leafFlag)
+	{
+		unsigned first = (child & ~leafFlag) >> 3;
+		return rangeBounds(first, first + (child & 7));
+	}
+
+	const Node &node = nodes[child];
+	BoundingBox box = emptyBox();
+	for (unsigned slot = 0; slot < 4; slot++)
+	{
+		if (node.children[slot] == emptyChild)
+			continue;
+		BoundingBox slotBox = { Vector3f(node.minX[slot], node.minY[slot], node.minZ[slot]), Vector3f(node.maxX[slot], node.maxY[slot], node.maxZ[slot]) };
+		grow(box, slotBox);
+	}
+	return box;
+}
+
+
+
+void Bvh::setChildBounds(Node &node, unsigned slot, const BoundingBox &box)
+{
+	node.minX[slot] = box.minimum.x();
+	node.minY[slot] = box.minimum.y();
+	node.minZ[slot] = box.minimum.z();
+	node.maxX[slot] = box.maximum.x();
+	node.maxY[slot] = box.maximum.y();
+	node.maxZ[slot] = box.maximum.z();
+}
+
+
+
+// Går från objektets löv upp mot roten. Om en låda inte ändrades blir inte heller
+// någon förälders låda annorlunda, så vi kan sluta där.
+void Bvh::update(unsigned object, const BoundingBox &box)
+{
+	boxes[object] = box;
+	unsigned location = objectLeaves[object];
+	while (location != noHit)
+	{
+		Node &node = nodes[location >> 2];
+		unsigned slot = location & 3;
+		BoundingBox updated = childBounds(node.children[slot]);
+		if (updated.minimum.x() == node.minX[slot] && updated.minimum.y() == node.minY[slot] && updated.minimum.z() == node.minZ[slot]
+			&& updated.maximum.x() == node.maxX[slot] && updated.maximum.y() == node.maxY[slot] && updated.maximum.z() == node.maxZ[slot])
+			break;
+		setChildBounds(node, slot, updated);
+		location = parents[location >> 2];
+	}
+}
+
+
+
+// Barnen ligger efter sina föräldrar i arrayen, så bakifrån är alla barn klara före föräldern
+void Bvh::refit(const BoundingBox *newBoxes)
+{
+	PROFILE_SCOPE("Bvh::refit");
+
+	boxes.assign(newBoxes, newBoxes + boxes.size());
+	for (unsigned i = nodes.size(); i-- > 0;)
+	{
+		Node &node = nodes[i];
+		for (unsigned slot = 0; slot < 4; slot++)
+		{
+			if (node.children[slot] != emptyChild)
+				setChildBounds(node, slot, childBounds(node.children[slot]));
+		}
+	}
+}
+
+
+
+unsigned Bvh::size() const
+{
+	return boxes.size();
+}
+
+
+
+unsigned Bvh::nodeCount() const
+{
+	return nodes.size();
+}
+
+
+
+const BoundingBox &Bvh::bounds(unsigned object) const
+{
+	return boxes[object];
+}
+
+
+
+void Bvh::collectSubtree(unsigned child, std::vector<unsigned> &results) const
+{
+	if (child & leafFlag)
+	{
+		unsigned first = (child & ~leafFlag) >> 3;
+		results.insert(results.end(), objects.begin() + first, objects.begin() + first + (child & 7));
+		return;
+	}
+
+	const Node &node = nodes[child];
+	for (unsigned slot = 0; slot < 4; slot++)
+	{
+		if (node.children[slot] != emptyChild)
+			collectSubtree(node.children[slot], results);
+	}
+}
+
+
+
+// Stacken för frågorna nedan. En per tråd, eftersom vyerna gallras parallellt, och den
+// växer med trädets djup i stället för att tappa noder, eftersom SAH-bygget inte har
+// något djuptak. Den behåller sin storlek mellan frågorna.
+std::vector<unsigned> &Bvh::traversalStack()
+{
+	static thread_local std::vector<unsigned> stack;
+	stack.clear();
+	return stack;
+}
+
+
+
+// Fyra lådor mot sex plan på en gång. För varje plan ger det största av a * min och a * max
+// (och samma för y och z) det hörn som ligger längst in, och det minsta det som ligger
+// längst ut. Ligger det innersta hörnet utanför något plan är lådan osynlig; ligger det
+// yttersta innanför alla plan är hela lådan synlig och barnen behöver inte testas.
+void Bvh::queryFrustum(const Frustum &frustum, std::vector<unsigned> &results) const
+{
+	PROFILE_SCOPE("Bvh::queryFrustum");
+
+	if (nodes.empty())
+		return;
+
+	__m128 planes[6][4];
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i][0] = _mm_set1_ps(frustum.planes[i].x());
+		planes[i][1] = _mm_set1_ps(frustum.planes[i].y());
+		planes[i][2] = _mm_set1_ps(frustum.planes[i].z());
+		planes[i][3] = _mm_set1_ps(frustum.planes[i].w());
+	}
+	__m128 zero = _mm_setzero_ps();
+
+	std::vector<unsigned> &stack = traversalStack();
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		__m128 minX = _mm_loadu_ps(node.minX), minY = _mm_loadu_ps(node.minY), minZ = _mm_loadu_ps(node.minZ);
+		__m128 maxX = _mm_loadu_ps(node.maxX), maxY = _mm_loadu_ps(node.maxY), maxZ = _mm_loadu_ps(node.maxZ);
+
+		__m128 outside = zero, inside = _mm_cmpeq_ps(zero, zero);
+		for (int i = 0; i < 6; i++)
+		{
+			__m128 x0 = _mm_mul_ps(planes[i][0], minX), x1 = _mm_mul_ps(planes[i][0], maxX);
+			__m128 y0 = _mm_mul_ps(planes[i][1], minY), y1 = _mm_mul_ps(planes[i][1], maxY);
+			__m128 z0 = _mm_mul_ps(planes[i][2], minZ), z1 = _mm_mul_ps(planes[i][2], maxZ);
+			__m128 farthest = _mm_add_ps(_mm_add_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_add_ps(_mm_max_ps(z0, z1), planes[i][3]));
+			__m128 nearest = _mm_add_ps(_mm_add_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_add_ps(_mm_min_ps(z0, z1), planes[i][3]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(farthest, zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(nearest, zero));
+		}
+
+		unsigned valid = validMask(node.children, emptyChild);
+		unsigned visible = ~_mm_movemask_ps(outside) & valid;
+		unsigned contained = _mm_movemask_ps(inside) & visible;
+		for (unsigned slot = 0; slot < 4; slot++)
+		{
+			if (!(visible & (1 << slot)))
+				continue;
+
+			unsigned child = node.children[slot];
+			if (contained & (1 << slot))
+				collectSubtree(child, results);
+			else if (child & leafFlag)
+			{
+				unsigned first = (child & ~leafFlag) >> 3;
+				for (unsigned i = first; i < first + (child & 7); i++)
+				{
+					if (!boxOutside(frustum, boxes[objects[i]]))
+						results.push_back(objects[i]);
+				}
+			}
+			else
+				stack.push_back(child);
+		}
+	}
+}
+
+
+
+void Bvh::queryOverlap(const BoundingBox &box, std::vector<unsigned> &results) const
+{
+	if (nodes.empty())
+		return;
+
+	__m128 queryMinX = _mm_set1_ps(box.minimum.x()), queryMinY = _mm_set1_ps(box.minimum.y()), queryMinZ = _mm_set1_ps(box.minimum.z());
+	__m128 queryMaxX = _mm_set1_ps(box.maximum.x()), queryMaxY = _mm_set1_ps(box.maximum.y()), queryMaxZ = _mm_set1_ps(box.maximum.z());
+
+	std::vector<unsigned> &stack = traversalStack();
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		__m128 separated = _mm_or_ps(
+			_mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(node.minX), queryMaxX), _mm_cmplt_ps(_mm_loadu_ps(node.maxX), queryMinX)),
+			_mm_or_ps(
+				_mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(node.minY), queryMaxY), _mm_cmplt_ps(_mm_loadu_ps(node.maxY), queryMinY)),
+				_mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(node.minZ), queryMaxZ), _mm_cmplt_ps(_mm_loadu_ps(node.maxZ), queryMinZ))));
+		unsigned overlapping = ~_mm_movemask_ps(separated) & validMask(node.children, emptyChild);
+
+		for (unsigned slot = 0; slot < 4; slot++)
+		{
+			if (!(overlapping & (1 << slot)))
+				continue;
+
+			unsigned child = node.children[slot];
+			if (child & leafFlag)
+			{
+				unsigned first = (child & ~leafFlag) >> 3;
+				for (unsigned i = first; i < first + (child & 7); i++)
+				{
+					if (boxesOverlap(box, boxes[objects[i]]))
+						results.push_back(objects[i]);
+				}
+			}
+			else
+				stack.push_back(child);
+		}
+	}
+}
+
+
+
+// Riktningar som är exakt noll byts mot ett mycket litet tal, så att inversen blir
+// stor men ändlig och slab-testet aldrig räknar noll gånger oändligheten
+Bvh::Ray Bvh::makeRay(const Vector3f &origin, const Vector3f &direction)
+{
+	Ray ray;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float d = direction[axis];
+		if (fabsf(d) < 1e-20f)
+			d = d < 0 ? -1e-20f : 1e-20f;
+		ray.origin[axis] = origin[axis];
+		ray.inverse[axis] = 1 / d;
+	}
+	return ray;
+}
+
+
+
+// Slab-testet: strålen är inne i lådan mellan det största inträdet och det minsta utträdet
+bool Bvh::rayHitsBox(const Ray &ray, const BoundingBox &box, float maxDistance)
+{
+	float entry = 0, exit = maxDistance;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (box.minimum[axis] - ray.origin[axis]) * ray.inverse[axis];
+		float t1 = (box.maximum[axis] - ray.origin[axis]) * ray.inverse[axis];
+		entry = std::max(entry, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+	}
+	return entry <= exit;
+}
+
+
+
+unsigned Bvh::intersectRay(const Node &node, const Ray &ray, float maxDistance, float *entry) const
+{
+	__m128 originX = _mm_set1_ps(ray.origin[0]), originY = _mm_set1_ps(ray.origin[1]), originZ = _mm_set1_ps(ray.origin[2]);
+	__m128 inverseX = _mm_set1_ps(ray.inverse[0]), inverseY = _mm_set1_ps(ray.inverse[1]), inverseZ = _mm_set1_ps(ray.inverse[2]);
+
+	__m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), originX), inverseX);
+	__m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), originX), inverseX);
+	__m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), originY), inverseY);
+	__m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), originY), inverseY);
+	__m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), originZ), inverseZ);
+	__m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), originZ), inverseZ);
+
+	__m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+	__m128 leave = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(maxDistance)));
+	_mm_storeu_ps(entry, enter);
+	return _mm_movemask_ps(_mm_cmple_ps(enter, leave)) & validMask(node.children, emptyChild);
+}
+
+
+
+void Bvh::queryRay(const Vector3f &origin, const Vector3f &direction, float maxDistance, std::vector<unsigned> &results) const
+{
+	if (nodes.empty())
+		return;
+
+	Ray ray = makeRay(origin, direction);
+	std::vector<unsigned> &stack = traversalStack();
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		float entry[4];
+		unsigned mask = intersectRay(node, ray, maxDistance, entry);
+		for (unsigned slot = 0; slot < 4; slot++)
+		{
+			if (!(mask & (1 << slot)))
+				continue;
+
+			unsigned child = node.children[slot];
+			if (child & leafFlag)
+			{
+				unsigned first = (child & ~leafFlag) >> 3;
+				for (unsigned i = first; i < first + (child & 7); i++)
+				{
+					if (rayHitsBox(ray, boxes[objects[i]], maxDistance))
+						results.push_back(objects[i]);
+				}
+			}
+			else
+				stack.push_back(child);
+		}
+	}
+}
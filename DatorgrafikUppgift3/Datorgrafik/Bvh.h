@@ -0,0 +1,161 @@
+#ifndef BVH_H
+#define BVH_H
+
+
+
+#include "Frustum.h"
+#include <vector>
+
+
+
+// Axelparallell låda i världsrummet
+struct BoundingBox
+{
+	Vector3f minimum, maximum;
+};
+
+inline BoundingBox sphereBounds(const Vector3f &center, float radius)
+{
+	BoundingBox box = { center - Vector3f(radius, radius, radius), center + Vector3f(radius, radius, radius) };
+	return box;
+}
+
+
+
+// Hierarki av omslutande lådor (BVH) över ett antal objekt, för gallring, strålar och
+// överlappstester på O(log n) i stället för att testa varje objekt.
+//
+// Trädet byggs uppifrån med binnad SAH (surface area heuristic): objektens mittpunkter
+// sorteras i 16 fack per axel och delningen som ger lägst förväntad kostnad väljs. Varje
+// nod delas två gånger, så noderna får fyra barn. Barnens lådor ligger som fyra flyttal
+// per koordinat, så en nod testas med en SSE-instruktion per koordinat för alla barnen.
+// Noderna ligger i en platt array i djupet-först-ordning, föräldrar före barn.
+//
+// Objekt som rör sig flyttas med update, som bara justerar lådorna på vägen upp till
+// roten. Trädets form ändras inte, så efter stora förflyttningar lönar det sig att bygga om.
+class Bvh
+{
+public:
+	static const unsigned noHit = ~0u;
+
+	void build(const BoundingBox *boxes, unsigned count);
+	void update(unsigned object, const BoundingBox &box);	// Inkrementell refit för ett objekt
+	void refit(const BoundingBox *boxes);					// Alla objekt på en gång, samma antal som i build
+
+	unsigned size() const;
+	unsigned nodeCount() const;
+	const BoundingBox &bounds(unsigned object) const;
+
+	// Resultaten läggs till i results, i ingen särskild ordning
+	void queryFrustum(const Frustum &frustum, std::vector<unsigned> &results) const;
+	void queryOverlap(const BoundingBox &box, std::vector<unsigned> &results) const;
+	void queryRay(const Vector3f &origin, const Vector3f &direction, float maxDistance, std::vector<unsigned> &results) const;
+
+	// Närmaste träff längs strålen. hit(object, distance) gör det exakta testet mot objektet
+	// och returnerar avståndet till träffen, eller ett negativt värde om strålen missar.
+	// Noderna besöks närmast först och allt bortom den närmaste träffen hoppas över.
+	// distance är strålens längd in och avståndet till träffen ut.
+	template<typename HitFunction>
+	unsigned raycast(const Vector3f &origin, const Vector3f &direction, float &distance, HitFunction hit) const;
+
+private:
+	static const unsigned leafFlag = 0x80000000u;	// Barn med den biten satt är löv: första objektet << 3 | antal
+	static const unsigned emptyChild = ~0u;
+	static const unsigned leafSize = 4;
+
+	struct Node
+	{
+		float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+		unsigned children[4];
+	};
+
+	struct Ray
+	{
+		float origin[3], inverse[3];
+	};
+
+	unsigned buildNode(unsigned begin, unsigned end, unsigned parent);
+	unsigned split(unsigned begin, unsigned end);
+	BoundingBox rangeBounds(unsigned begin, unsigned end) const;
+	BoundingBox childBounds(unsigned child) const;
+	void setChildBounds(Node &node, unsigned slot, const BoundingBox &box);
+
+	static Ray makeRay(const Vector3f &origin, const Vector3f &direction);
+	static bool rayHitsBox(const Ray &ray, const BoundingBox &box, float maxDistance);
+	unsigned intersectRay(const Node &node, const Ray &ray, float maxDistance, float *entry) const;	// Bitmask över barnen
+	void collectSubtree(unsigned child, std::vector<unsigned> &results) const;
+	static std::vector<unsigned> &traversalStack();
+
+	std::vector<Node> nodes;
+	std::vector<unsigned> objects;			// Objektindex i lövordning
+	std::vector<BoundingBox> boxes;			// Per objekt
+	std::vector<Vector3f> centers;			// Per objekt, bara under build
+	std::vector<unsigned> parents;			// Per nod: förälder << 2 | plats, noHit för roten
+	std::vector<unsigned> objectLeaves;		// Per objekt: nod << 2 | plats för lövet som håller objektet
+};
+
+
+
+template<typename HitFunction>
+unsigned Bvh::raycast(const Vector3f &origin, const Vector3f &direction, float &distance, HitFunction hit) const
+{
+	unsigned closest = noHit;
+	if (nodes.empty())
+		return closest;
+
+	// Egna stackar och inte traversalStack, eftersom hit får ställa egna frågor till trädet
+	Ray ray = makeRay(origin, direction);
+	std::vector<unsigned> stack(1, 0);
+	std::vector<float> stackEntry(1, 0.0f);
+
+	while (!stack.empty())
+	{
+		unsigned child = stack.back();
+		float childEntry = stackEntry.back();
+		stack.pop_back();
+		stackEntry.pop_back();
+		if (childEntry > distance)		// En närmare träff har hittats sedan barnet lades på stacken
+			continue;
+
+		if (child & leafFlag)
+		{
+			unsigned first = (child & ~leafFlag) >> 3, count = child & 7;
+			for (unsigned i = first; i < first + count; i++)
+			{
+				float t = hit(objects[i], distance);
+				if (t >= 0 && t <= distance)
+				{
+					distance = t;
+					closest = objects[i];
+				}
+			}
+			continue;
+		}
+
+		// Träffade barn läggs på stacken längst bort först, så att det närmaste tas först
+		float entry[4];
+		unsigned mask = intersectRay(nodes[child], ray, distance, entry);
+		unsigned order[4], count = 0;
+		for (unsigned i = 0; i < 4; i++)
+		{
+			if (mask & (1 << i))
+			{
+				unsigned j = count++;
+				for (; j > 0 && entry[order[j - 1]] < entry[i]; j--)
+					order[j] = order[j - 1];
+				order[j] = i;
+			}
+		}
+		for (unsigned i = 0; i < count; i++)
+		{
+			stack.push_back(nodes[child].children[order[i]]);
+			stackEntry.push_back(entry[order[i]]);
+		}
+	}
+
+	return closest;
+}
+
+
+
+#endif
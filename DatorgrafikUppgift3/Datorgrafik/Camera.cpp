@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "Profiler.h"
 
 
 
@@ -10,108 +11,159 @@ Camera::Camera()
 
 	targetDistance = 50;
 	position.assign(0, 5, 50);
-	target.assign(position + forward * targetDistance);
+	target = madd(position, forward, targetDistance);
+	projection = createPerspectiveMatrix(45.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+	inverseValid = false;
 }
 
 
 
 void Camera::movePosition(float distanceX, float distanceY, float distanceZ)
 {
+	PROFILE_SCOPE("Camera::movePosition");
+
 	Vector3f direction(distanceX, distanceY, distanceZ);
 	position += direction;
+	inverseValid = false;
 }
 
 
 
 void Camera::moveTarget(float distanceX, float distanceY, float distanceZ)
 {
+	PROFILE_SCOPE("Camera::moveTarget");
+
 	Vector3f direction(distanceX, distanceY, distanceZ);
 	target += direction;
+	inverseValid = false;
 }
 
 
 
 void Camera::strafeRight(float distance)
 {
+	PROFILE_SCOPE("Camera::strafeRight");
+
 	position += right * distance;
 	target += right * distance;
+	inverseValid = false;
 }
 
 
 
 void Camera::strafeUp(float distance)
 {
+	PROFILE_SCOPE("Camera::strafeUp");
+
 	position += up * distance;
 	target += up * distance;
+	inverseValid = false;
 }
 
 
 
 void Camera::strafeForward(float distance)
 {
+	PROFILE_SCOPE("Camera::strafeForward");
+
 	position += forward * distance;
 	target += forward * distance;
+	inverseValid = false;
 }
 
 
 
 void Camera::tumbleYaw(float angle)
 {
+	PROFILE_SCOPE("Camera::tumbleYaw");
+
 	Quaternionf rotation((angle * PIdiv180), up);
-	right = rotation.matrix() * right;
-	forward = rotation.matrix() * forward;
+	right = rotation.rotate(right);
+	forward = rotation.rotate(forward);
 
-	target = position + forward * targetDistance;
+	target = madd(position, forward, targetDistance);
+	inverseValid = false;
 }
 
 
 
 void Camera::tumblePitch(float angle)
 {
+	PROFILE_SCOPE("Camera::tumblePitch");
+
 	Quaternionf rotation((angle * PIdiv180), right);
-	forward = rotation.matrix() * forward;
-	up = rotation.matrix() * up;
+	forward = rotation.rotate(forward);
+	up = rotation.rotate(up);
 
-	target = position + forward * targetDistance;
+	target = madd(position, forward, targetDistance);
+	inverseValid = false;
 }
 
 
 
 void Camera::orbitYaw(float angle)
 {
+	PROFILE_SCOPE("Camera::orbitYaw");
+
 	Quaternionf rotation((angle * PIdiv180), up);
-	right = rotation.matrix() * right;
-	forward = rotation.matrix() * forward;
+	right = rotation.rotate(right);
+	forward = rotation.rotate(forward);
 
-	position = target - forward * targetDistance;
+	position = madd(target, forward, -targetDistance);
+	inverseValid = false;
 }
 
 
 
 void Camera::orbitPitch(float angle)
 {
+	PROFILE_SCOPE("Camera::orbitPitch");
+
 	Quaternionf rotation((angle * PIdiv180), right);
-	forward = rotation.matrix() * forward;
-	up = rotation.matrix() * up;
+	forward = rotation.rotate(forward);
+	up = rotation.rotate(up);
 
-	position = target - forward * targetDistance;
+	position = madd(target, forward, -targetDistance);
+	inverseValid = false;
 }
 
 
 
 void Camera::roll(float angle)
 {
+	PROFILE_SCOPE("Camera::roll");
+
 	Quaternionf rotation((angle * PIdiv180), forward);
-	up = rotation.matrix() * up;
-	right = rotation.matrix() * right;
+	up = rotation.rotate(up);
+	right = rotation.rotate(right);
 
-	target = position + forward * targetDistance;
+	target = madd(position, forward, targetDistance);
+	inverseValid = false;
+}
+
+
+
+void Camera::setPose(const Vector3f &newPosition, const Quaternionf &orientation)
+{
+	PROFILE_SCOPE("Camera::setPose");
+
+	Quaternionf unit = orientation;
+	unit.normalize();
+	right = unit.rotateUnit(Vector3f(1, 0, 0));
+	up = unit.rotateUnit(Vector3f(0, 1, 0));
+	forward = unit.rotateUnit(Vector3f(0, 0, -1));
+
+	position = newPosition;
+	target = madd(position, forward, targetDistance);
+	inverseValid = false;
 }
 
 
 
 void Camera::lookAt()
 {	
+	PROFILE_SCOPE("Camera::lookAt");
+
 	gluLookAt(
 		position.x(), position.y(), position.z(), 
 		target.x(), target.y(), target.z(), 
@@ -121,6 +173,46 @@ void Camera::lookAt()
 
 
 
+Matrix4x4f Camera::viewMatrix() const
+{
+	return createLookAtMatrix(position, target, up);
+}
+
+
+
+void Camera::setProjection(const Matrix4x4f &newProjection)
+{
+	projection = newProjection;
+	inverseValid = false;
+}
+
+
+
+const Matrix4x4f &Camera::inverseViewProjection()
+{
+	if (!inverseValid)
+	{
+		inverse = (projection * viewMatrix()).inverse();
+		inverseValid = true;
+	}
+	return inverse;
+}
+
+
+
+// Punkterna p nr- och fjrrplanet under (x, y) frs tillbaka till vrlden, strlen gr mellan dem
+void Camera::unproject(float x, float y, Vector3f &origin, Vector3f &direction)
+{
+	const Matrix4x4f &m = inverseViewProjection();
+	Vector4f nearPoint = m * Vector4f(x, y, -1.0f, 1.0f);
+	Vector4f farPoint = m * Vector4f(x, y, 1.0f, 1.0f);
+
+	origin = Vector3f(nearPoint.x(), nearPoint.y(), nearPoint.z()) / nearPoint.w();
+	direction = (Vector3f(farPoint.x(), farPoint.y(), farPoint.z()) / farPoint.w() - origin).getNormalized();
+}
+
+
+
 Vector3f Camera::GetCamPos(){ return position; }		// Hjlpfunktioner fr att hmta kameraposition och kameraml.
 
 Vector3f Camera::GetTarPos(){ return target; }
\ No newline at end of file
@@ -37,7 +37,16 @@ public:
 
 	void roll(float angle);
 
+	void setPose(const Vector3f &newPosition, const Quaternionf &orientation);	// Orienteringen vrider -z till framt och y till uppt.
+
 	void lookAt();
+	Matrix4x4f viewMatrix() const;	// Samma vymatris som lookAt, men berknad p CPU:n.
+
+	// Projektionen anvnds bara fr att g frn skrmen tillbaka in i vrlden. Inversen av
+	// projektion * vy sparas och rknas om frst nr kameran eller projektionen ndrats.
+	void setProjection(const Matrix4x4f &newProjection);
+	const Matrix4x4f &inverseViewProjection();
+	void unproject(float x, float y, Vector3f &origin, Vector3f &direction);	// x och y i -1 till 1, direction normaliseras
 
 	Vector3f GetCamPos();		// Hjlpfunktioner fr att hmta kameraposition och kameraml.
 	Vector3f GetTarPos();
@@ -46,6 +55,8 @@ private:
 	Vector3f position, target;
 	Vector3f right, up, forward;
 	float targetDistance;
+	Matrix4x4f projection, inverse;
+	bool inverseValid;
 };
 
 
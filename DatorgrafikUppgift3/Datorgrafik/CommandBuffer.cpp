@@ -0,0 +1,267 @@
+#include "CommandBuffer.h"
+#include "RenderState.h"
+#include "Mesh.h"
+#include "Profiler.h"
+
+
+
+void CommandBuffer::clear()
+{
+	commands.clear();
+	matrices.clear();
+}
+
+
+
+void CommandBuffer::setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	Command command;
+	command.type = CommandViewport;
+	command.viewport[0] = x;
+	command.viewport[1] = y;
+	command.viewport[2] = width;
+	command.viewport[3] = height;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::loadMatrix(const Matrix4x4f &modelview)
+{
+	Command command;
+	command.type = CommandLoadMatrix;
+	command.matrix = matrices.size();
+	matrices.push_back(modelview);
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::bindTexture(GLuint texture)
+{
+	Command command;
+	command.type = CommandBindTexture;
+	command.texture = texture;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::enable(GLenum state)
+{
+	Command command;
+	command.type = CommandEnable;
+	command.state[0] = state;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::disable(GLenum state)
+{
+	Command command;
+	command.type = CommandDisable;
+	command.state[0] = state;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::depthMask(GLboolean flag)
+{
+	Command command;
+	command.type = CommandDepthMask;
+	command.state[0] = flag;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::polygonMode(GLenum face, GLenum mode)
+{
+	Command command;
+	command.type = CommandPolygonMode;
+	command.state[0] = face;
+	command.state[1] = mode;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::color(float red, float green, float blue, float alpha)
+{
+	Command command;
+	command.type = CommandColor;
+	command.color[0] = red;
+	command.color[1] = green;
+	command.color[2] = blue;
+	command.color[3] = alpha;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::draw(MeshFunction mesh)
+{
+	Command command;
+	command.type = CommandDraw;
+	command.mesh = mesh;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::drawMesh(const Mesh *mesh, unsigned level)
+{
+	Command command;
+	command.type = CommandDrawMesh;
+	command.meshLevel.mesh = mesh;
+	command.meshLevel.level = level;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::line(const Vector3f &from, const Vector3f &to)
+{
+	Command command;
+	command.type = CommandLine;
+	command.line[0] = from.x();
+	command.line[1] = from.y();
+	command.line[2] = from.z();
+	command.line[3] = to.x();
+	command.line[4] = to.y();
+	command.line[5] = to.z();
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::copyToTexture(GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	Command command;
+	command.type = CommandCopyToTexture;
+	command.copy.texture = texture;
+	command.copy.rect[0] = x;
+	command.copy.rect[1] = y;
+	command.copy.rect[2] = width;
+	command.copy.rect[3] = height;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::drawTexture(GLuint texture, float u, float v)
+{
+	Command command;
+	command.type = CommandDrawTexture;
+	command.quad.texture = texture;
+	command.quad.extent[0] = u;
+	command.quad.extent[1] = v;
+	commands.push_back(command);
+}
+
+
+
+void CommandBuffer::append(const CommandBuffer &buffer)
+{
+	unsigned matrixOffset = matrices.size();
+	matrices.insert(matrices.end(), buffer.matrices.begin(), buffer.matrices.end());
+
+	for (unsigned i = 0; i < buffer.commands.size(); i++)
+	{
+		commands.push_back(buffer.commands[i]);
+		if (commands.back().type == CommandLoadMatrix)
+			commands.back().matrix += matrixOffset;
+	}
+}
+
+
+
+void CommandBuffer::execute() const
+{
+	PROFILE_SCOPE("CommandBuffer::execute");
+
+	glMatrixMode(GL_MODELVIEW);
+
+	for (unsigned i = 0; i < commands.size(); i++)
+	{
+		const Command &command = commands[i];
+		switch (command.type)
+		{
+		case CommandViewport:
+			glViewport(command.viewport[0], command.viewport[1], command.viewport[2], command.viewport[3]);
+			break;
+		case CommandLoadMatrix:
+			glLoadMatrixf(matrices[command.matrix].data());
+			break;
+		case CommandBindTexture:
+			::bindTexture(command.texture);
+			break;
+		case CommandEnable:
+			enableState(command.state[0]);
+			break;
+		case CommandDisable:
+			disableState(command.state[0]);
+			break;
+		case CommandDepthMask:
+			setDepthMask(GLboolean(command.state[0]));
+			break;
+		case CommandPolygonMode:
+			setPolygonMode(command.state[0], command.state[1]);
+			break;
+		case CommandColor:
+			glColor4fv(command.color);
+			break;
+		case CommandDraw:
+			command.mesh();
+			break;
+		case CommandDrawMesh:
+			command.meshLevel.mesh->draw(command.meshLevel.level);
+			break;
+		case CommandLine:
+			glBegin(GL_LINES);
+			glVertex3fv(command.line);
+			glVertex3fv(command.line + 3);
+			glEnd();
+			PROFILE_COUNT("drawCalls", 1);
+			PROFILE_COUNT("vertices", 2);
+			break;
+		case CommandCopyToTexture:
+			::bindTexture(command.copy.texture);
+			glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, command.copy.rect[0], command.copy.rect[1], command.copy.rect[2], command.copy.rect[3]);
+			break;
+		case CommandDrawTexture:
+			// En fyrhörning över hela vyporten, utan projektion och djuptest
+			::bindTexture(command.quad.texture);
+			enableState(GL_TEXTURE_2D);
+			disableState(GL_DEPTH_TEST);
+			disableState(GL_CULL_FACE);
+			glColor3f(1, 1, 1);
+			glMatrixMode(GL_PROJECTION);
+			glPushMatrix();
+			glLoadIdentity();
+			glMatrixMode(GL_MODELVIEW);
+			glLoadIdentity();
+			glBegin(GL_QUADS);
+			glTexCoord2f(0, 0); glVertex2f(-1, -1);
+			glTexCoord2f(command.quad.extent[0], 0); glVertex2f(1, -1);
+			glTexCoord2f(command.quad.extent[0], command.quad.extent[1]); glVertex2f(1, 1);
+			glTexCoord2f(0, command.quad.extent[1]); glVertex2f(-1, 1);
+			glEnd();
+			glMatrixMode(GL_PROJECTION);
+			glPopMatrix();
+			glMatrixMode(GL_MODELVIEW);
+			PROFILE_COUNT("drawCalls", 1);
+			PROFILE_COUNT("vertices", 4);
+			break;
+		}
+	}
+}
+
+
+
+unsigned CommandBuffer::size() const
+{
+	return commands.size();
+}
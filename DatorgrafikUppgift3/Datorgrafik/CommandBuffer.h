@@ -0,0 +1,104 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+
+
+#include "Support.h"
+#include "MathUtils.h"
+#include <vector>
+
+
+
+typedef void (*MeshFunction)();
+class Mesh;
+
+enum CommandType
+{
+	CommandViewport,
+	CommandLoadMatrix,
+	CommandBindTexture,
+	CommandEnable,
+	CommandDisable,
+	CommandDepthMask,
+	CommandPolygonMode,
+	CommandColor,
+	CommandDraw,
+	CommandDrawMesh,
+	CommandLine,
+	CommandCopyToTexture,
+	CommandDrawTexture
+};
+
+struct TextureRect
+{
+	GLuint texture;
+	GLint rect[4];
+};
+
+struct TextureQuad
+{
+	GLuint texture;
+	float extent[2];		// Texturkoordinater i övre högra hörnet
+};
+
+struct MeshLevel
+{
+	const Mesh *mesh;
+	unsigned level;
+};
+
+struct Command
+{
+	CommandType type;
+	union
+	{
+		GLint viewport[4];
+		unsigned matrix;		// Index i buffertens matrislista
+		GLuint texture;
+		GLenum state[2];		// Tillstånd, eller sida och läge för CommandPolygonMode
+		float color[4];
+		MeshFunction mesh;
+		MeshLevel meshLevel;
+		float line[6];
+		TextureRect copy;		// Textur och fönsterområde för CommandCopyToTexture
+		TextureQuad quad;		// Textur och använd del av den för CommandDrawTexture
+	};
+};
+
+
+
+// En inspelad lista med renderingskommandon. Inspelningen rör aldrig GL, så den
+// kan göras på vilken tråd som helst. execute() spelar upp listan och måste
+// anropas på tråden som äger GL-kontexten.
+class CommandBuffer
+{
+public:
+	void clear();
+
+	void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void loadMatrix(const Matrix4x4f &modelview);
+	void bindTexture(GLuint texture);
+	void enable(GLenum state);
+	void disable(GLenum state);
+	void depthMask(GLboolean flag);
+	void polygonMode(GLenum face, GLenum mode);
+	void color(float red, float green, float blue, float alpha = 1);
+	void draw(MeshFunction mesh);
+	void drawMesh(const Mesh *mesh, unsigned level);	// En detaljnivå av en inläst modell
+	void line(const Vector3f &from, const Vector3f &to);
+	void copyToTexture(GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height);	// Kopierar ett område av färgbufferten
+	void drawTexture(GLuint texture, float u = 1, float v = 1);	// Fyller hela vyporten med texturen upp till (u, v)
+
+	void append(const CommandBuffer &buffer);	// Lägger till en annan bufferts kommandon sist
+	void execute() const;
+
+	unsigned size() const;
+
+private:
+	std::vector<Command> commands;
+	std::vector<Matrix4x4f> matrices;
+};
+
+
+
+#endif
@@ -1,7 +1,22 @@
 #include "Support.h"
 #include "Camera.h"
+#include "FrameLoop.h"
+#include "Profiler.h"
+#include "RenderState.h"
+#include "CommandBuffer.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+#include "InputLog.h"
+#include "Flythrough.h"
+#include "MathBenchmark.h"
+#include "Mesh.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <chrono>
+#include <functional>
+#include <vector>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #include <ApplicationServices/ApplicationServices.h>
@@ -15,26 +30,127 @@
 struct Shared
 {
 	float time;
+	unsigned tick;					// Antal simuleringssteg sedan start, inspelad indata stämplas med det.
+	float previousTime, renderTime;	// Simuleringstiden i förra steget och den interpolerade tiden vi ritar med.
 	bool pause;
 	bool mouseWarped;
+	FrameLoop frameLoop;			// Fast simuleringssteg oberoende av bildhastigheten.
 	GLuint floorTexture, pillarTexture;
 	Camera camera;
 	bool tumble = true;				// en bool för att byta mellan tumble och orbit.
 	bool roll = false;				// en bool som aktiverar roll.
 	bool viewports = false;			// en bool som aktiverar viewports.
+	bool cacheViews = true;			// De fasta vyportarna sparas i texturer och ritas bara om när de ändrats.
 	int screenWidth, screenHeight;	// Jag använder ett par ints för att spara fönsterstorleken.
-	bool cameraBall = false;		// en bool som aktiverar kamerabollen och målbollen.
 	GLUquadric *quadric;			// Jag tog den här från uppgift 2 för att rita svärer.
+	Scene scene;					// Golv, pelare, referensobjekt och kamerabollar
+	unsigned diamond, box, cameraBall, targetBall;	// Index för de objekt som rör sig
+	SceneView views[4];				// Den aktiva kameran och de tre fasta kamerorna
+	CommandBuffer viewBuffers[4];	// En inspelad kommandobuffert per vyport.
+	CommandBuffer frameBuffer;		// Alla vyportar samlade, spelas upp i ett svep.
+	ThreadPool threadPool;			// Vyportarna spelas in parallellt, GL-anropen görs bara på huvudtråden.
+	GLuint viewTextures[4];			// Sparad bild för varje fast vyport
+	bool viewTextureValid[4];
+	float viewTextureExtent[2];		// Hur stor del av texturerna vyportbilden täcker
+	unsigned drawnLineRevision[4];	// Kamerabollarnas revisioner när linjen senast ritades
+	bool benchmark = false;			// Kameran följer en skriptad åkning och programmet avslutas efteråt.
+	Flythrough flythrough;
+	unsigned benchmarkFrame;
+	Mesh models[8];					// Modeller inlästa med -model, ritas i en rad mitt på golvet
+	unsigned modelCount;
 };
 
 struct Shared shared;
 
 
 
+// Vår egen underfunktion som ritar en enhetssfär med den delade quadricen
+void drawSphere()
+{
+	gluSphere(shared.quadric, 1, 32, 32);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 32 * 33 * 2);
+}
+
+
+
+// Vår egen underfunktion som läser in modellerna och ställer dem i en rad mitt på golvet,
+// skalade så att de är lika stora oavsett vilka enheter filerna använder. Flera modeller
+// läses in och förenklas parallellt, en per tråd. En ensam modell tolkas i stället parallellt.
+bool addModels(const std::vector<const char *> &files)
+{
+	const unsigned maxModels = sizeof(shared.models) / sizeof(shared.models[0]);
+	if (files.size() > maxModels)
+	{
+		fprintf(stderr, "Högst %u modeller kan läsas in\n", maxModels);
+		return false;
+	}
+
+	std::vector<double> milliseconds(files.size());
+	std::vector<char> loaded(files.size());		// Inte vector<bool>, trådarna skriver var sitt element
+	std::function<void(unsigned)> load = [&](unsigned i)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		shared.models[i].setThreadPool(files.size() == 1 ? &shared.threadPool : NULL);
+		loaded[i] = shared.models[i].load(files[i]);
+		milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	if (files.size() == 1)
+		load(0);
+	else
+		shared.threadPool.parallelFor(files.size(), load);
+
+	for (unsigned i = 0; i < files.size(); i++)
+	{
+		if (!loaded[i])
+			return false;
+
+		const Mesh &model = shared.models[i];
+		printf("%s: %u hörn, %u trianglar, %.1f ms %s\n", files[i], model.vertexCount(), model.indexCount() / 3,
+			milliseconds[i], model.fromCache() ? "från cachen" : "importerad");
+		if (!model.fromCache())
+		{
+			const VertexCacheStats &before = model.importedStats(), &after = model.optimizedStats();
+			printf("  hörncache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+		}
+		for (unsigned level = 1; level < model.levelCount(); level++)
+			printf("  nivå %u: %u trianglar, fel %g\n", level, model.indexCount(level) / 3, model.levelError(level));
+
+		const float size = 4;
+		float scale = model.boundRadius() > 0 ? size / model.boundRadius() : 1;
+		const Vector3f &center = model.boundCenter();
+
+		SceneObject object;
+		object.model = createTranslationMatrix((i - (files.size() - 1) / 2.0f) * 2.5f * size, -10 + size, 0.0f)
+			* createScaleMatrix(scale, scale, scale)
+			* createTranslationMatrix(-center.x(), -center.y(), -center.z());
+		object.boundCenter = center;
+		object.boundRadius = model.boundRadius();
+		object.mesh = NULL;
+		object.levels = &model;
+		object.triangles = NULL;
+		object.texture = 0;
+		object.depthTest = true;
+		object.cullFace = false;
+		object.colored = false;
+		object.dynamic = false;
+		object.viewMask = 0xf;
+		shared.scene.add(object);
+	}
+	shared.modelCount = files.size();
+	return true;
+}
+
+
+
 // Vår egen underfunktion som initierar det som behövs innan renderingen börjar
 void initialize()
 {
 	shared.time = 0;
+	shared.tick = 0;
+	shared.previousTime = 0;
+	shared.renderTime = 0;
+	shared.modelCount = 0;
 	shared.pause = false;
 	shared.mouseWarped = false;
 
@@ -43,78 +159,165 @@ void initialize()
 
 	loadTexture("Floor.png", &shared.floorTexture);
 	loadTexture("Pillar.png", &shared.pillarTexture);
+	glGenTextures(4, shared.viewTextures);
+	for (int i = 0; i < 4; i++)
+		shared.viewTextureValid[i] = false;
+	renderStateReset();   // loadTexture binder texturer förbi tillståndscachen
+
+	// Bygg scenen. Statiska objekt får sin transform här, de dynamiska i updateScene.
+	SceneObject object;
+	object.model = createTranslationMatrix(0.0f, 0.0f, 0.0f);
+	object.colored = false;
+	object.dynamic = false;
+	object.viewMask = 0xf;
+	object.depthTest = true;
+	object.cullFace = true;
+	object.levels = NULL;
+
+	object.mesh = drawFloor;
+	object.triangles = &floorMesh;
+	object.texture = shared.floorTexture;
+	object.boundCenter = Vector3f(0, -10, 0);
+	object.boundRadius = 35.4f;
+	shared.scene.add(object);
+
+	// Pelarnas och de fasta kamerornas matriser räknas ut redan när programmet kompileras
+	static constexpr Matrix4x4f pillarModels[4] =
+	{
+		createTranslationMatrix(-7.0f, 0.0f, -7.0f),
+		createTranslationMatrix(7.0f, 0.0f, 7.0f),
+		createTranslationMatrix(-7.0f, 0.0f, 7.0f),
+		createTranslationMatrix(7.0f, 0.0f, -7.0f)
+	};
+	object.mesh = drawPillar;
+	object.triangles = &pillarMesh;
+	object.texture = shared.pillarTexture;
+	object.boundCenter = Vector3f(0, -2, 0);
+	object.boundRadius = 8.2f;
+	for (int i = 0; i < 4; i++)
+	{
+		object.model = pillarModels[i];
+		shared.scene.add(object);
+	}
+
+	// Referensobjekten ritas utan djuptest, precis som förut
+	object.dynamic = true;
+	object.depthTest = false;
+	object.cullFace = false;
+	object.texture = 0;
+	object.boundCenter = Vector3f(0, 0, 0);
+	object.mesh = drawDiamond;
+	object.triangles = &diamondMesh;
+	object.boundRadius = 1;
+	shared.diamond = shared.scene.add(object);
+	object.mesh = drawBox;
+	object.triangles = &boxMesh;
+	object.boundRadius = 1.75f;
+	shared.box = shared.scene.add(object);
+
+	// Kamerabollarna syns bara i de fasta vyerna
+	object.mesh = drawSphere;
+	object.triangles = NULL;
+	object.boundRadius = 1;
+	object.colored = true;
+	object.viewMask = 0xe;
+	object.color[0] = 1; object.color[1] = 0; object.color[2] = 0;
+	shared.cameraBall = shared.scene.add(object);
+	object.color[0] = 0; object.color[1] = 0; object.color[2] = 1;
+	shared.targetBall = shared.scene.add(object);
+
+	static constexpr Matrix4x4f fixedViews[3] =
+	{
+		createConstantLookAtMatrix(Vector3f(50, 5, 0), Vector3f(0, 0, 0), Vector3f(0, 1, 0)),
+		createConstantLookAtMatrix(Vector3f(0, 50, 0), Vector3f(0, 0, 0), Vector3f(0, 0, 1)),
+		createConstantLookAtMatrix(Vector3f(0, 5, 50), Vector3f(0, 0, 0), Vector3f(0, 1, 0))
+	};
+	for (int i = 0; i < 4; i++)
+	{
+		shared.views[i].index = i;
+		shared.views[i].fixed = i > 0;
+		shared.views[i].cached = false;
+		if (i > 0)
+			shared.views[i].view = fixedViews[i - 1];
+	}
+}
+
+
+
+// Vår egen underfunktion som sätter transformerna för allt som rör sig. De beror inte på
+// vyn, så de räknas ut en gång per bildruta och delas av alla vyportar.
+void updateScene()
+{
+	PROFILE_SCOPE("updateScene");
+
+	const float degrees = float(PIdiv180);
+	const float time = shared.renderTime;
+
+	shared.scene.setModel(shared.diamond,
+		createTranslationMatrix(sin(time) * 10, sin(time * 4) * 4, 0.0f)
+		* createRotationMatrix(Vector3f(1, 0, 0), time * 100 * degrees));
+
+	shared.scene.setModel(shared.box,
+		createRotationMatrix(Vector3f(0, 1, 0), time * -40 * degrees)
+		* createTranslationMatrix(14.0f, 0.0f, 0.0f)
+		* createRotationMatrix(Vector3f(0, 1, 0), time * 40 * degrees));
+
+	Vector3f camPos = shared.camera.GetCamPos();
+	Vector3f tarPos = shared.camera.GetTarPos();
+	shared.scene.setModel(shared.cameraBall, createTranslationMatrix(camPos.x(), camPos.y(), camPos.z()));
+	shared.scene.setModel(shared.targetBall, createTranslationMatrix(tarPos.x(), tarPos.y(), tarPos.z()) * createScaleMatrix(0.5f, 0.5f, 0.5f));
+
+	shared.scene.buildHierarchy();
+	shared.views[0].view = shared.camera.viewMatrix();
 }
 
 
 
-// Vår egen underfunktion som ritar ut scenen
-void drawScene()
+// Vår egen underfunktion som gallrar och spelar in en vy. Inga GL-anrop görs här,
+// så funktionen kan köras på vilken tråd som helst. Returnerar sant om vyn kunde
+// tas från sin sparade textur i stället för att ritas om.
+bool recordView(CommandBuffer &buffer, SceneView &view, GLint x, GLint y, GLsizei width, GLsizei height)
 {
-	// Initiala renderingstillstånd
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
-	glEnable(GL_TEXTURE_2D);
-	glDisable(GL_BLEND);
-	glPolygonMode(GL_FRONT, GL_FILL);
-
-	// Rita golv och pelare
-	drawFloor(shared.floorTexture);
-	drawPillars(shared.pillarTexture);
-
-	// Rita referensobjekt
-	glPushMatrix();														// Jag ritar ut två referensobjekt med diverse transformationer.
-	glTranslatef(sin(shared.time) * 10, sin(shared.time * 4) * 4, 0);
-	glRotatef(shared.time * 100, 1, 0, 0);
-	drawDiamond();
-	glPopMatrix();
-
-	glPushMatrix();
-	glRotatef(shared.time * -40, 0, 1, 0);
-	glTranslatef(14, 0, 0);
-	glRotatef(shared.time * 40, 0, 1, 0);
-	drawBox();
-	glPopMatrix();
-
-	// Rita kameraboll, målboll och linje
-	if (shared.cameraBall)
+	buffer.clear();
+	buffer.setViewport(x, y, width, height);
+
+	shared.scene.buildVisibleSet(view);
+
+	// Linjen följer kamerabollarna även när de själva är utanför bilden
+	unsigned lineRevision = shared.scene.object(shared.cameraBall).revision + shared.scene.object(shared.targetBall).revision;
+	bool cache = shared.cacheViews && view.fixed;
+	if (cache && shared.viewTextureValid[view.index] && lineRevision == shared.drawnLineRevision[view.index]
+		&& !shared.scene.changedSince(view))
 	{
-		glPushMatrix();									// Jag ritar ut två bollar med samma positioner som
-														// kameran och kameramålet. Jag ritar också ut en linje mellan dem.
-		glColor3f(1, 0, 0);
-		Vector3f camPos = shared.camera.GetCamPos();
-		float cX = camPos.x();
-		float cY = camPos.y();
-		float cZ = camPos.z();
-		glTranslatef(cX, cY, cZ);
-		gluSphere(shared.quadric, 1, 32, 32);
-
-		glPopMatrix();
-
-		glPushMatrix();
-
-		glColor3f(0, 0, 1);
-		Vector3f tarPos = shared.camera.GetTarPos();
-		float tX = tarPos.x();
-		float tY = tarPos.y();
-		float tZ = tarPos.z();
-		glTranslatef(tX, tY, tZ);
-		gluSphere(shared.quadric, 0.5, 32, 32);
-
-		glPopMatrix();
-
-		glColor3f(0, 1, 0);
-		glBegin(GL_LINES);
-		glVertex3f(cX, cY, cZ);
-		glVertex3f(tX, tY, tZ);
-		glEnd();
+		buffer.drawTexture(shared.viewTextures[view.index], shared.viewTextureExtent[0], shared.viewTextureExtent[1]);
+		return true;
 	}
+
+	shared.scene.record(buffer, view);
+
+	// Linjen mellan kameran och målet
+	if (view.fixed)
+	{
+		buffer.disable(GL_TEXTURE_2D);
+		buffer.color(0, 1, 0);
+		buffer.loadMatrix(view.view);
+		buffer.line(shared.camera.GetCamPos(), shared.camera.GetTarPos());
+	}
+
+	if (cache)
+	{
+		buffer.copyToTexture(shared.viewTextures[view.index], x, y, width, height);
+		shared.scene.markDrawn(view);
+		shared.drawnLineRevision[view.index] = lineRevision;
+		shared.viewTextureValid[view.index] = true;
+	}
+	return false;
 }
 
 
 
-// GLUT-hanterad funktion som anropas varje gång en tangent trycks ned
-void keyboard(unsigned char key, int x, int y)
+// Vår egen underfunktion som hanterar en nedtryckt tangent, direkt eller från en inspelning
+void handleKey(unsigned char key)
 {
 	switch(key)
 	{
@@ -175,13 +378,39 @@ void keyboard(unsigned char key, int x, int y)
 	case 'c':									// c togglar mellan vyporterna.
 		shared.viewports = !shared.viewports;
 		break;
+	case 'v':									// v slår av och på cachningen av de fasta vyportarna.
+		shared.cacheViews = !shared.cacheViews;
+		for (int i = 0; i < 4; i++)
+			shared.viewTextureValid[i] = false;
+		break;
 	}
 }
 
 
 
-// GLUT-hanterad funktion som anropas varje gång en tangent släpps upp
-void keyboardUp(unsigned char key, int x, int y)
+// Vår egen underfunktion som säger om kameran styrs av en inspelning eller en benchmark i stället för av användaren
+bool scriptedInput()
+{
+	return inputReplaying() || shared.benchmark;
+}
+
+
+
+// GLUT-hanterad funktion som anropas varje gång en tangent trycks ned
+void keyboard(unsigned char key, int x, int y)
+{
+	if (scriptedInput() && key != 27)   // Under uppspelning styr bara skriptet, men Esc avslutar alltid
+		return;
+
+	InputEvent event = { shared.tick, InputKeyDown, key, 0, 0 };
+	inputRecord(event);
+	handleKey(key);
+}
+
+
+
+// Vår egen underfunktion som hanterar en släppt tangent
+void handleKeyUp(unsigned char key)
 {
 	switch(key)
 	{
@@ -193,14 +422,70 @@ void keyboardUp(unsigned char key, int x, int y)
 
 
 
-// GLUT-hanterad funktion som anropas efter att en angiven tid har löpt ut (ofta kallad timer)
-void timer(int timeout)
+// GLUT-hanterad funktion som anropas varje gång en tangent släpps upp
+void keyboardUp(unsigned char key, int x, int y)
+{
+	if (scriptedInput())
+		return;
+
+	InputEvent event = { shared.tick, InputKeyUp, key, 0, 0 };
+	inputRecord(event);
+	handleKeyUp(key);
+}
+
+
+
+// Vår egen underfunktion som vrider kameran efter musens förflyttning från fönstrets mitt
+void handleMotion(int deltaX, int deltaY)
+{
+	PROFILE_SCOPE("handleMotion");
+
+	float scale = 0.3f;
+	float x = float(deltaX) * scale;
+	float y = float(deltaY) * scale;
+
+	if (!shared.roll)
+	{
+		if (shared.tumble)							// Kontrollerar kamera rörelserna
+		{
+			shared.camera.tumbleYaw(-x);
+			shared.camera.tumblePitch(-y);
+		}
+		else
+		{
+			shared.camera.orbitYaw(-x);
+			shared.camera.orbitPitch(-y);
+		}
+	}
+	else
+	{
+		shared.camera.roll(x);
+	}
+}
+
+
+
+// Vår egen underfunktion som stegar simuleringen ett fast tidssteg framåt
+void update()
 {
-	glutTimerFunc(timeout, timer, timeout);   // Vi måste starta om timern varje gång
+	// Inspelad indata läggs in i samma steg som den en gång kom i
+	InputEvent event;
+	while (inputReplayNext(shared.tick, event))
+	{
+		if (event.type == InputKeyDown)
+			handleKey(event.key);
+		else if (event.type == InputKeyUp)
+			handleKeyUp(event.key);
+		else
+			handleMotion(event.x, event.y);
+	}
+	shared.tick++;
+
+	shared.previousTime = shared.time;
 
 	if(!shared.pause)
 	{
-		shared.time += 0.01f;
+		shared.time += 0.01f;   // Samma takt som den gamla timern på 60 Hz
 	}
 }
 
@@ -209,38 +494,52 @@ void timer(int timeout)
 // GLUT-hanterad funktion som anropas en gång för varje bildruta (frame)
 void display()
 {
+	PROFILE_SCOPE("display");
+	profilerGpuBegin();
+
 	glClearColor(0, 0, 0, 1);
 	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);   // Vi vill rensa både skärmbuffert och z-buffert
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	shared.camera.lookAt();   // Skapar vymatris via kameraklassen
+	int halfWidth = shared.screenWidth / 2;
+	int halfHeight = shared.screenHeight / 2;
+
+	updateScene();
+
 	if (!shared.viewports)													// En vanlig vyport
 	{
-		glViewport(0, 0, shared.screenWidth, shared.screenHeight);
-		drawScene();
+		recordView(shared.viewBuffers[0], shared.views[0], 0, 0, shared.screenWidth, shared.screenHeight);
+		shared.viewBuffers[0].execute();
+		PROFILE_COUNT("visibleObjects", shared.views[0].visible.size());
 	}
 	else
 	{
-		glViewport(0, 0, shared.screenWidth / 2, shared.screenHeight / 2);					// fyra vyportar
-		drawScene();
-		glLoadIdentity();
-		shared.cameraBall = true;
-		gluLookAt(50, 5, 0, 0, 0, 0, 0, 1, 0);
-		glViewport(0, shared.screenHeight / 2, shared.screenWidth / 2, shared.screenHeight / 2);
-		drawScene();
-		glLoadIdentity();
-		gluLookAt(0, 50, 0, 0, 0, 0, 0, 0, 1);
-		glViewport(shared.screenWidth / 2, 0, shared.screenWidth / 2, shared.screenHeight / 2);
-		drawScene();
-		glLoadIdentity();
-		gluLookAt(0, 5, 50, 0, 0, 0, 0, 1, 0);
-		glViewport(shared.screenWidth / 2, shared.screenHeight / 2, shared.screenWidth / 2, shared.screenHeight / 2);
-		drawScene();
-		shared.cameraBall = false;
+		// Fyra vyportar: den aktiva kameran och tre fasta kameror som visar kamerabollen.
+		// Varje vy gallras och spelas in på trådpoolen. De fasta vyerna återanvänder sin
+		// gallring av de statiska objekten, så bara det som rör sig testas om.
+		const GLint viewports[4][2] = { { 0, 0 }, { 0, halfHeight }, { halfWidth, 0 }, { halfWidth, halfHeight } };
+
+		// Fasta vyer där inget synligt har ändrats ritas direkt från sin sparade textur.
+		bool reused[4];
+
+		shared.threadPool.parallelFor(4, [&](unsigned i)
+		{
+			reused[i] = recordView(shared.viewBuffers[i], shared.views[i], viewports[i][0], viewports[i][1], halfWidth, halfHeight);
+		});
+
+		// Samla vyportarna i en buffert och spela upp allt i ett svep
+		shared.frameBuffer.clear();
+		for (int i = 0; i < 4; i++)
+		{
+			shared.frameBuffer.append(shared.viewBuffers[i]);
+			PROFILE_COUNT("visibleObjects", shared.views[i].visible.size());
+			PROFILE_COUNT("cachedViews", reused[i] ? 1 : 0);
+		}
+		shared.frameBuffer.execute();
 	}
 
+	profilerGpuEnd();
 	glutSwapBuffers();
+	profilerEndFrame();
 }
 
 
@@ -255,6 +554,33 @@ void reshape(int width, int height)
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluPerspective(45.0f, float(width) / float(height), 0.1f, 100.0f);   // Skapar en projektionsmatris
+
+	// Samma projektion används för gallringen. Vyportarna har samma bildformat som
+	// fönstret, men de fasta vyernas sparade gallring måste göras om.
+	for (int i = 0; i < 4; i++)
+	{
+		shared.views[i].projection = createPerspectiveMatrix(45.0f, float(width) / float(height), 0.1f, 100.0f);
+		shared.views[i].cached = false;
+	}
+	shared.camera.setProjection(shared.views[0].projection);
+
+	// De sparade vyportbilderna har vyportens storlek och måste ritas om. OpenGL 1.1 kräver
+	// sidor som är potenser av två, så bilden kopieras till texturens nedre vänstra hörn.
+	GLsizei textureWidth = 1, textureHeight = 1;
+	while (textureWidth < width / 2)
+		textureWidth *= 2;
+	while (textureHeight < height / 2)
+		textureHeight *= 2;
+	shared.viewTextureExtent[0] = float(width / 2) / textureWidth;
+	shared.viewTextureExtent[1] = float(height / 2) / textureHeight;
+	for (int i = 0; i < 4; i++)
+	{
+		bindTexture(shared.viewTextures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureWidth, textureHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		shared.viewTextureValid[i] = false;
+	}
 }
 
 
@@ -262,6 +588,44 @@ void reshape(int width, int height)
 // GLUT-hanterad funktion som anropas när ingen händelse (tangentbord, utritning etc) sker 
 void idle()
 {
+	if (shared.benchmark)
+	{
+		// Benchmarken går också ett steg per bildruta, med kameran på den skriptade banan
+		if (shared.benchmarkFrame == shared.flythrough.frames())
+			exit(0);
+		update();
+		shared.renderTime = shared.time;
+
+		Vector3f position;
+		Quaternionf orientation;
+		shared.flythrough.evaluate(shared.flythrough.duration() * shared.benchmarkFrame / shared.flythrough.frames(), position, orientation);
+		shared.camera.setPose(position, orientation);
+		shared.benchmarkFrame++;
+
+		glutPostRedisplay();
+		return;
+	}
+
+	if (inputReplaying())
+	{
+		// Uppspelning går i takt med simuleringen, ett steg per bildruta och utan
+		// väntan, så att varje körning ritar exakt samma bildrutor
+		if (inputReplayFinished())
+			exit(0);
+		update();
+		shared.renderTime = shared.time;
+		glutPostRedisplay();
+		return;
+	}
+
+	shared.frameLoop.waitForFrame();
+
+	int steps = shared.frameLoop.beginFrame();   // Simuleringen körs i fasta steg, hur ofta vi än ritar
+	for (int i = 0; i < steps; i++)
+		update();
+
+	shared.renderTime = shared.previousTime + (shared.time - shared.previousTime) * shared.frameLoop.alpha();
+
 	glutPostRedisplay();
 }
 
@@ -270,6 +634,11 @@ void idle()
 // GLUT-hanterad funktion som anropas när muspekaren flyttas
 void passiveMotion(int x, int y)
 {
+	PROFILE_SCOPE("passiveMotion");
+
+	if(scriptedInput())   // Under uppspelning styr bara skriptet
+		return;
+
 	if(shared.mouseWarped)
 	{
 		shared.mouseWarped = false;
@@ -278,30 +647,47 @@ void passiveMotion(int x, int y)
 	{
 		int centerX = glutGet(GLUT_WINDOW_WIDTH) / 2;
 		int centerY = glutGet(GLUT_WINDOW_HEIGHT) / 2;
-		float scale = 0.3f;
-		float deltaX = float(x - centerX) * scale;
-		float deltaY = float(y - centerY) * scale;
 		
 		glutWarpPointer(centerX, centerY);
 		shared.mouseWarped = true;
-		if (!shared.roll)
-		{
-			if (shared.tumble)							// Kontrollerar kamera rörelserna
-			{
-				shared.camera.tumbleYaw(-deltaX);
-				shared.camera.tumblePitch(-deltaY);
-			}
-			else
-			{
-				shared.camera.orbitYaw(-deltaX);
-				shared.camera.orbitPitch(-deltaY);
-			}
-		}
-		else
-		{
-			shared.camera.roll(deltaX);
-		}
+
+		InputEvent event = { shared.tick, InputMotion, 0, short(x - centerX), short(y - centerY) };
+		inputRecord(event);
+		handleMotion(x - centerX, y - centerY);
+	}
+}
+
+
+
+// GLUT-hanterad funktion som anropas när en musknapp trycks ned eller släpps. Vänsterklick
+// väljer objektet under pekaren i den aktiva kamerans vy, med en stråle genom scenens
+// hierarki i stället för att läsa tillbaka något från GPU:n.
+void mouse(int button, int state, int x, int y)
+{
+	if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN || scriptedInput())
+		return;
+
+	// Den aktiva kameran fyller fönstret, eller den nedre vänstra vyporten när vyportarna är på
+	float width = float(shared.screenWidth), height = float(shared.screenHeight);
+	float top = 0;
+	if (shared.viewports)
+	{
+		width /= 2;
+		height /= 2;
+		top = height;
+		if (x >= width || y < top)
+			return;
 	}
+
+	Vector3f origin, direction;
+	shared.camera.unproject(2 * (x + 0.5f) / width - 1, 1 - 2 * (y - top + 0.5f) / height, origin, direction);
+
+	float distance = 1000;
+	unsigned picked = shared.scene.pick(origin, direction, 0, distance);
+	if (picked == Bvh::noHit)
+		printf("Inget objekt under pekaren\n");
+	else
+		printf("Objekt %u, avstånd %.2f\n", picked, distance);
 }
 
 
@@ -309,15 +695,76 @@ void passiveMotion(int x, int y)
 // Startpunkt för programmet
 int main(int argc, char* argv[])
 {
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-mathbench") == 0)						// -mathbench [namn] kör mikrobenchmarkar utan att öppna något fönster
+			return runMathBenchmark(i + 1 < argc ? argv[i + 1] : NULL);
+	}
+
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE|GLUT_DEPTH);   // Vi vill ha dubbelbuffring och z-buffert (depth buffer)
 	glutInitWindowSize(640, 480);
 	glutInitWindowPosition(100, 200);
 	glutCreateWindow("Datorgrafik");
 
+	// Mätningen startas före initialize, annars kommer texturladdningen inte med
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-profile") == 0)						// -profile [fil.json|fil.csv] mäter tider och skriver en rapport vid avslut
+		{
+			profilerStart(i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : NULL);
+			atexit(profilerFinish);
+		}
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)		// -trace fil.json skriver ett Chrome trace (chrome://tracing eller Perfetto)
+		{
+			if (profilerStartTrace(argv[++i]))
+				atexit(profilerFinish);
+		}
+	}
+
 	initialize();
 
-	glutTimerFunc(1000/60, timer, 1000/60);
+	std::vector<const char *> modelFiles;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)				// -fps N sätter ett tak för bildhastigheten, 0 ger okapat benchmarkläge
+			shared.frameLoop.setFrameCap(atof(argv[++i]));
+		else if (strcmp(argv[i], "-profile") == 0)						// Startades redan före initialize
+		{
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				i++;
+		}
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)		// -record fil.inp spelar in tangentbord och mus
+		{
+			if (inputRecordStart(argv[++i]))
+				atexit(inputLogClose);
+		}
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)		// -replay fil.inp spelar upp en inspelning, ett steg per bildruta, och avslutar sedan
+			inputReplayStart(argv[++i]);
+		else if (strcmp(argv[i], "-benchmark") == 0 && i + 1 < argc)	// -benchmark fil.txt åker en skriptad kamerabana och skriver en rapport
+		{
+			if (!shared.flythrough.load(argv[++i]))
+				return 1;
+			shared.benchmark = true;
+			shared.benchmarkFrame = 0;
+			shared.viewports = shared.flythrough.viewports();
+			profilerSetLabel(shared.flythrough.label());
+		}
+		else if (strcmp(argv[i], "-model") == 0 && i + 1 < argc)		// -model fil.obj|fil.ply läser in en modell, via en binär cache bredvid filen. Kan upprepas.
+			modelFiles.push_back(argv[++i]);
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)		// Startades redan före initialize
+			i++;
+	}
+
+	if (!modelFiles.empty() && !addModels(modelFiles))
+		return 1;
+
+	if (shared.benchmark && !profilerReporting())   // Benchmarken skriver alltid en rapport, även utan -profile och med bara -trace
+	{
+		profilerStart(NULL);
+		atexit(profilerFinish);
+	}
+
 	glutDisplayFunc(display);
 	glutReshapeFunc(reshape);
 	glutIdleFunc(idle);
@@ -329,6 +776,7 @@ int main(int argc, char* argv[])
 	CGSetLocalEventsSuppressionInterval(0);
 	#endif
 	glutPassiveMotionFunc(passiveMotion);
+	glutMouseFunc(mouse);
 	
 	glutMainLoop();
 
@@ -0,0 +1,164 @@
+#include "Flythrough.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+
+static const float degrees = float(3.1415926535897932384626433832795 / 180.0);
+
+
+
+bool Flythrough::load(const char *file)
+{
+	FILE *in = fopen(file, "r");
+	if (!in)
+	{
+		fprintf(stderr, "Kunde inte öppna %s\n", file);
+		return false;
+	}
+
+	keys.clear();
+	workload = file;
+	frameCount = 1000;
+	quadView = false;
+
+	char line[256];
+	int lineNumber = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), in))
+	{
+		lineNumber++;
+		char word[64];
+		if (sscanf(line, "%63s", word) != 1 || word[0] == '#')
+			continue;
+
+		char name[128];
+		int version, flag;
+		Key key;
+		float x, y, z, head, pitch, roll;
+		if (strcmp(word, "workload") == 0)
+		{
+			ok = sscanf(line, "%*s %127s %d", name, &version) == 2;
+			if (ok)
+			{
+				char buffer[160];
+				sprintf(buffer, "%s v%d", name, version);
+				workload = buffer;
+			}
+		}
+		else if (strcmp(word, "frames") == 0)
+			ok = sscanf(line, "%*s %u", &frameCount) == 1;
+		else if (strcmp(word, "viewports") == 0)
+		{
+			ok = sscanf(line, "%*s %d", &flag) == 1;
+			quadView = flag != 0;
+		}
+		else if (strcmp(word, "key") == 0)
+		{
+			ok = sscanf(line, "%*s %f %f %f %f %f %f %f", &key.time, &x, &y, &z, &head, &pitch, &roll) == 7
+				&& (keys.empty() || key.time > keys.back().time);
+			key.position = Vector3f(x, y, z);
+			key.orientation = Quaternionf(head * degrees, Vector3f(0, 1, 0))
+				* Quaternionf(pitch * degrees, Vector3f(1, 0, 0))
+				* Quaternionf(roll * degrees, Vector3f(0, 0, 1));
+			keys.push_back(key);
+		}
+		else
+			ok = false;
+	}
+	fclose(in);
+
+	if (!ok)
+	{
+		fprintf(stderr, "%s rad %d: kan inte tolka raden\n", file, lineNumber);
+		return false;
+	}
+	if (keys.size() < 2 || frameCount == 0)
+	{
+		fprintf(stderr, "%s: en kameraåkning behöver minst två nycklar och en bildruta\n", file);
+		return false;
+	}
+
+	// Squad kräver att grannarna ligger på samma halvsfär, annars tar den långa vägen runt
+	for (unsigned i = 1; i < keys.size(); i++)
+	{
+		if (dotProduct(keys[i - 1].orientation, keys[i].orientation) < 0)
+			keys[i].orientation = keys[i].orientation * -1.0f;
+	}
+
+	controls.resize(keys.size());
+	for (unsigned i = 0; i < keys.size(); i++)
+	{
+		unsigned previous = i > 0 ? i - 1 : i;
+		unsigned next = i + 1 < keys.size() ? i + 1 : i;
+		controls[i] = squadControlPoint(keys[previous].orientation, keys[i].orientation, keys[next].orientation);
+	}
+	return true;
+}
+
+
+
+const char *Flythrough::label() const
+{
+	return workload.c_str();
+}
+
+
+
+unsigned Flythrough::frames() const
+{
+	return frameCount;
+}
+
+
+
+bool Flythrough::viewports() const
+{
+	return quadView;
+}
+
+
+
+float Flythrough::duration() const
+{
+	return keys.back().time - keys.front().time;
+}
+
+
+
+void Flythrough::evaluate(float time, Vector3f &position, Quaternionf &orientation) const
+{
+	time += keys.front().time;
+
+	// Hitta segmentet [i, i + 1] som innehåller tiden
+	unsigned i = 0;
+	while (i + 2 < keys.size() && time >= keys[i + 1].time)
+		i++;
+
+	float u = (time - keys[i].time) / (keys[i + 1].time - keys[i].time);
+	u = u < 0 ? 0 : (u > 1 ? 1 : u);
+
+	// Catmull-Rom, där ändpunkterna upprepas i början och slutet
+	const Vector3f &p0 = keys[i > 0 ? i - 1 : i].position;
+	const Vector3f &p1 = keys[i].position;
+	const Vector3f &p2 = keys[i + 1].position;
+	const Vector3f &p3 = keys[i + 2 < keys.size() ? i + 2 : i + 1].position;
+	float weights[4];
+	catmullRomWeights(u, weights);
+	position = madd(madd(madd(p0 * weights[0], p1, weights[1]), p2, weights[2]), p3, weights[3]);
+
+	orientation = squad(keys[i].orientation, keys[i + 1].orientation, controls[i], controls[i + 1], u);
+}
+
+
+
+void catmullRomWeights(float u, float weights[4])
+{
+	float u2 = u * u;
+	float u3 = u2 * u;
+	weights[0] = 0.5f * (-u + 2 * u2 - u3);
+	weights[1] = 0.5f * (2 - 5 * u2 + 3 * u3);
+	weights[2] = 0.5f * (u + 4 * u2 - 3 * u3);
+	weights[3] = 0.5f * (u3 - u2);
+}
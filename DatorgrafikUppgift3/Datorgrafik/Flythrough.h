@@ -0,0 +1,55 @@
+#ifndef FLYTHROUGH_H
+#define FLYTHROUGH_H
+
+
+
+#include "MathUtils.h"
+#include <string>
+#include <vector>
+
+
+
+// En skriptad kameraåkning för benchmarkläget. Positionerna följer en Catmull-Rom-spline
+// och orienteringen interpoleras med squad mellan nycklarna. Filformatet är text:
+//
+//   workload <namn> <version>	Arbetslastens namn och version, skrivs i rapporten
+//   frames <antal>				Hur många bildrutor som ritas
+//   viewports <0|1>			Fyra vyportar eller en
+//   key <tid> <x> <y> <z> <head> <pitch> <roll>	Nyckel, vinklar i grader
+//
+// Rader som börjar med # är kommentarer.
+class Flythrough
+{
+public:
+	bool load(const char *file);
+
+	const char *label() const;		// "namn v<version>"
+	unsigned frames() const;
+	bool viewports() const;
+	float duration() const;
+
+	void evaluate(float time, Vector3f &position, Quaternionf &orientation) const;	// Tiden räknas från första nyckeln
+
+private:
+	struct Key
+	{
+		float time;
+		Vector3f position;
+		Quaternionf orientation;
+	};
+
+	std::vector<Key> keys;
+	std::vector<Quaternionf> controls;	// squads kontrollpunkter, en per nyckel
+	std::string workload;
+	unsigned frameCount;
+	bool quadView;
+};
+
+
+// Vikterna för punkterna p0..p3 i ett Catmull-Rom-segment vid parametern u (0..1).
+// Punkten blir p0 * w[0] + p1 * w[1] + p2 * w[2] + p3 * w[3].
+void catmullRomWeights(float u, float weights[4]);
+
+
+
+#endif
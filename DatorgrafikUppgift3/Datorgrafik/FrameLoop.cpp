@@ -0,0 +1,103 @@
+#include "FrameLoop.h"
+#include <thread>
+
+
+
+// Högst så här mycket tid simuleras per bildruta, annars kan en lång paus
+// (t.ex. när fönstret flyttas) ge en spiral där vi aldrig hinner ikapp.
+static const double maxFrameTime = 0.25;
+
+
+
+FrameLoop::FrameLoop(double step)
+{
+	stepLength = step;
+	minFrameTime = 0;
+	reset();
+}
+
+
+
+void FrameLoop::setFrameCap(double framesPerSecond)
+{
+	minFrameTime = framesPerSecond > 0 ? 1.0 / framesPerSecond : 0;
+}
+
+
+
+void FrameLoop::reset()
+{
+	accumulator = 0;
+	lastFrameTime = 0;
+	started = false;
+}
+
+
+
+double FrameLoop::secondsSince(Clock::time_point point) const
+{
+	return std::chrono::duration<double>(Clock::now() - point).count();
+}
+
+
+
+void FrameLoop::waitForFrame()
+{
+	if (!started || minFrameTime <= 0)
+		return;
+
+	// Sov bort det mesta av väntetiden och snurra sedan den sista biten,
+	// eftersom sleep sällan har bättre upplösning än ett par millisekunder.
+	double remaining = minFrameTime - secondsSince(lastFrame);
+	if (remaining > 0.002)
+		std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.002));
+
+	while (secondsSince(lastFrame) < minFrameTime)
+		std::this_thread::yield();
+}
+
+
+
+int FrameLoop::beginFrame()
+{
+	Clock::time_point now = Clock::now();
+	if (!started)
+	{
+		lastFrame = now;
+		started = true;
+	}
+
+	lastFrameTime = std::chrono::duration<double>(now - lastFrame).count();
+	lastFrame = now;
+
+	accumulator += lastFrameTime < maxFrameTime ? lastFrameTime : maxFrameTime;
+
+	int steps = 0;
+	while (accumulator >= stepLength)
+	{
+		accumulator -= stepLength;
+		steps++;
+	}
+	return steps;
+}
+
+
+
+double FrameLoop::step() const
+{
+	return stepLength;
+}
+
+
+
+float FrameLoop::alpha() const
+{
+	return float(accumulator / stepLength);
+}
+
+
+
+double FrameLoop::frameTime() const
+{
+	return lastFrameTime;
+}
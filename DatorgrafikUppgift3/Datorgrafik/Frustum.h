@@ -0,0 +1,54 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+
+
+#include "MathUtils.h"
+
+
+
+// Vystympens sex plan, med normalerna inåt. Planen plockas direkt ur
+// projektion * vy, så samma kod fungerar för alla kameror.
+struct Frustum
+{
+	Vector4f planes[6];		// Vänster, höger, nedre, övre, när, fjärran
+};
+
+
+
+inline Frustum extractFrustum(const Matrix4x4f &viewProjection)
+{
+	const Matrix4x4f &m = viewProjection;
+	Vector4f rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = Vector4f(m[i], m[4 + i], m[8 + i], m[12 + i]);
+
+	Frustum frustum;
+	for (int i = 0; i < 3; i++)
+	{
+		frustum.planes[i * 2] = rows[3] + rows[i];
+		frustum.planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+	for (int i = 0; i < 6; i++)
+		normalizePlane(frustum.planes[i]);
+
+	return frustum;
+}
+
+
+
+// Sant om sfären ligger helt eller delvis innanför stympen
+inline bool sphereInFrustum(const Frustum &frustum, const Vector3f &center, float radius)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const Vector4f &plane = frustum.planes[i];
+		if (plane.x() * center.x() + plane.y() * center.y() + plane.z() * center.z() + plane.w() < -radius)
+			return false;
+	}
+	return true;
+}
+
+
+
+#endif
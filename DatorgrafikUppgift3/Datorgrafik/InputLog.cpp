@@ -0,0 +1,140 @@
+#include "InputLog.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+
+static const unsigned short logVersion = 1;
+static const unsigned eventSize = 10;
+
+static FILE *recordFile = NULL;
+static std::vector<InputEvent> replayEvents;
+static unsigned replayPosition = 0;
+static bool replaying = false;
+
+
+
+static void putValue(unsigned char *out, unsigned value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		out[i] = (unsigned char)(value >> (i * 8));
+}
+
+
+
+static unsigned getValue(const unsigned char *in, int bytes)
+{
+	unsigned value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= unsigned(in[i]) << (i * 8);
+	return value;
+}
+
+
+
+bool inputRecordStart(const char *file)
+{
+	recordFile = fopen(file, "wb");
+	if (!recordFile)
+	{
+		fprintf(stderr, "Kunde inte skapa %s\n", file);
+		return false;
+	}
+
+	unsigned char header[6] = { 'I', 'N', 'P', 'L' };
+	putValue(header + 4, logVersion, 2);
+	fwrite(header, 1, sizeof(header), recordFile);
+	return true;
+}
+
+
+
+void inputRecord(const InputEvent &event)
+{
+	if (!recordFile)
+		return;
+
+	unsigned char data[eventSize];
+	putValue(data, event.tick, 4);
+	data[4] = event.type;
+	data[5] = event.key;
+	putValue(data + 6, (unsigned short)event.x, 2);
+	putValue(data + 8, (unsigned short)event.y, 2);
+	fwrite(data, 1, eventSize, recordFile);
+}
+
+
+
+bool inputReplayStart(const char *file)
+{
+	FILE *in = fopen(file, "rb");
+	if (!in)
+	{
+		fprintf(stderr, "Kunde inte öppna %s\n", file);
+		return false;
+	}
+
+	unsigned char header[6];
+	if (fread(header, 1, sizeof(header), in) != sizeof(header) || memcmp(header, "INPL", 4) != 0
+		|| getValue(header + 4, 2) != logVersion)
+	{
+		fprintf(stderr, "%s är ingen inspelning av rätt version\n", file);
+		fclose(in);
+		return false;
+	}
+
+	replayEvents.clear();
+	unsigned char data[eventSize];
+	while (fread(data, 1, eventSize, in) == eventSize)
+	{
+		InputEvent event;
+		event.tick = getValue(data, 4);
+		event.type = data[4];
+		event.key = data[5];
+		event.x = (short)getValue(data + 6, 2);
+		event.y = (short)getValue(data + 8, 2);
+		replayEvents.push_back(event);
+	}
+	fclose(in);
+
+	replayPosition = 0;
+	replaying = true;
+	return true;
+}
+
+
+
+bool inputReplaying()
+{
+	return replaying;
+}
+
+
+
+bool inputReplayNext(unsigned tick, InputEvent &event)
+{
+	if (replayPosition >= replayEvents.size() || replayEvents[replayPosition].tick > tick)
+		return false;
+
+	event = replayEvents[replayPosition++];
+	return true;
+}
+
+
+
+bool inputReplayFinished()
+{
+	return replayPosition >= replayEvents.size();
+}
+
+
+
+void inputLogClose()
+{
+	if (recordFile)
+	{
+		fclose(recordFile);
+		recordFile = NULL;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+
+
+// Spelar in tangentbords- och mushändelser tillsammans med simuleringssteget de
+// kom i, och spelar upp dem igen i samma steg. Musen sparas som förflyttning från
+// fönstrets mitt, så en inspelning går att spela upp i ett fönster av annan storlek.
+//
+// Filformat: "INPL", versionsnummer (16 bitar) och sedan 10 byte per händelse:
+// steg (32 bitar), typ, tangent, x och y (16 bitar). Allt är little endian.
+
+
+
+enum InputEventType
+{
+	InputKeyDown,
+	InputKeyUp,
+	InputMotion
+};
+
+struct InputEvent
+{
+	unsigned tick;			// Antal simuleringssteg som tagits när händelsen kom
+	unsigned char type;
+	unsigned char key;
+	short x, y;				// Musens förflyttning från fönstrets mitt
+};
+
+
+
+bool inputRecordStart(const char *file);
+void inputRecord(const InputEvent &event);
+
+bool inputReplayStart(const char *file);
+bool inputReplaying();
+bool inputReplayNext(unsigned tick, InputEvent &event);	// Nästa händelse som hör till steg tick eller tidigare
+bool inputReplayFinished();
+
+void inputLogClose();			// Skriver klart inspelningen. Passar att ge till atexit.
+
+
+
+#endif
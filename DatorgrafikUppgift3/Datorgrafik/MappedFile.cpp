@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+MappedFile::MappedFile()
+{
+	view = NULL;
+	length = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	descriptor = -1;
+#endif
+}
+
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char *name)
+{
+	close();
+
+	file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		close();
+		return false;
+	}
+	length = size_t(fileSize.QuadPart);
+	if (length == 0)
+		return true;
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping)
+		view = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!view)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+
+
+void MappedFile::close()
+{
+	if (view)
+		UnmapViewOfFile(view);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	view = NULL;
+	length = 0;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const char *name)
+{
+	close();
+
+	descriptor = ::open(name, O_RDONLY);
+	if (descriptor < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(descriptor, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	length = size_t(info.st_size);
+	if (length == 0)
+		return true;
+
+	void *address = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (address == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	view = static_cast<const char *>(address);
+	return true;
+}
+
+
+
+void MappedFile::close()
+{
+	if (view)
+		munmap(const_cast<char *>(view), length);
+	if (descriptor >= 0)
+		::close(descriptor);
+	view = NULL;
+	length = 0;
+	descriptor = -1;
+}
+
+#endif
+
+
+
+const char *MappedFile::data() const
+{
+	return view;
+}
+
+
+
+size_t MappedFile::size() const
+{
+	return length;
+}
@@ -0,0 +1,39 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+
+
+#include <stddef.h>
+
+
+
+// En fil som mappas in i minnet och bara läses. Operativsystemet läser in sidorna när
+// de används, så även stora filer öppnas direkt och inget kopieras. En tom fil ger
+// size() 0 och data() NULL.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const char *file);
+	void close();
+
+	const char *data() const;
+	size_t size() const;
+
+private:
+	const char *view;
+	size_t length;
+#ifdef _WIN32
+	void *file, *mapping;		// HANDLE, men utan att dra in windows.h här
+#else
+	int descriptor;
+#endif
+};
+
+
+
+#endif
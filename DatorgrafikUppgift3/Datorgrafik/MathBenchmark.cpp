@@ -0,0 +1,695 @@
+#include "MathBenchmark.h"
+#include "MathUtils.h"
+#include "Bvh.h"
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "Flythrough.h"
+#include "Vector3A.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+
+static const unsigned vectorCount = 1 << 16;
+static const unsigned repeats = 50;
+
+
+
+// Summan skrivs ut efter varje mätning så att kompilatorn inte kan optimera bort arbetet
+static float checksum(const std::vector<Vector3f> &vectors)
+{
+	float sum = 0;
+	for (unsigned i = 0; i < vectors.size(); i += 97)
+		sum += vectors[i].x() + vectors[i].y() + vectors[i].z();
+	return sum;
+}
+
+
+
+// Vector3A måste ligga på 16 bytes gräns, vilket new inte garanterar i 32-bitarsläge
+struct AlignedVectors
+{
+	AlignedVectors(unsigned count)
+		: vectors(static_cast<Vector3Af *>(_mm_malloc(count * sizeof(Vector3Af), 16))), count(count)
+	{
+		for (unsigned i = 0; i < count; i++)
+			vectors[i] = Vector3Af();
+	}
+	~AlignedVectors()
+	{
+		_mm_free(vectors);
+	}
+	AlignedVectors(const AlignedVectors &) = delete;
+	AlignedVectors &operator=(const AlignedVectors &) = delete;
+
+	Vector3Af &operator[](unsigned i)
+	{
+		return vectors[i];
+	}
+
+	Vector3Af *vectors;
+	unsigned count;
+};
+
+
+
+static float checksum(const AlignedVectors &vectors)
+{
+	float sum = 0;
+	for (unsigned i = 0; i < vectors.count; i += 97)
+		sum += vectors.vectors[i].x() + vectors.vectors[i].y() + vectors.vectors[i].z();
+	return sum;
+}
+
+
+
+// Kör funktionen repeats gånger och skriver ut bästa tiden per operation
+template<typename Result, typename Function>
+static void measure(const char *name, unsigned operations, Result &result, Function function)
+{
+	double best = 1e30;
+	for (unsigned r = 0; r < repeats; r++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (seconds < best)
+			best = seconds;
+	}
+	printf("  %-34s %8.2f ns/op   (checksum %g)\n", name, best * 1e9 / operations, checksum(result));
+}
+
+
+
+static std::vector<Vector3f> randomVectors(unsigned count)
+{
+	std::vector<Vector3f> vectors(count);
+	for (unsigned i = 0; i < count; i++)
+		vectors[i] = Vector3f(rand() / float(RAND_MAX) - 0.5f, rand() / float(RAND_MAX) - 0.5f, rand() / float(RAND_MAX) - 0.5f);
+	return vectors;
+}
+
+
+
+// Vridning av vektorer med kvaternion, så som kameran gör. Varje kvaternion vrider
+// två vektorer, precis som i Camera::tumbleYaw och de andra.
+static void benchmarkRotate()
+{
+	printf("rotate: %u vektorer, två per kvaternion\n", vectorCount);
+
+	std::vector<Vector3f> input = randomVectors(vectorCount);
+	std::vector<Vector3f> axes = randomVectors(vectorCount / 2);
+	std::vector<Quaternionf> rotations(vectorCount / 2);
+	for (unsigned i = 0; i < rotations.size(); i++)
+		rotations[i] = Quaternionf(rand() / float(RAND_MAX), axes[i].getNormalized());
+	std::vector<Vector3f> result(vectorCount);
+
+	measure("matrix() per vektor", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = rotations[i / 2].matrix() * input[i];
+	});
+
+	measure("matrix() en gång", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i += 2)
+		{
+			Matrix3x3f matrix = rotations[i / 2].matrix();
+			result[i] = matrix * input[i];
+			result[i + 1] = matrix * input[i + 1];
+		}
+	});
+
+	measure("rotate", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = rotations[i / 2].rotate(input[i]);
+	});
+
+	measure("rotateUnit", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = rotations[i / 2].rotateUnit(input[i]);
+	});
+
+	// Många vektorer med samma kvaternion, t.ex. ett helt objekts hörn
+	measure("rotate, batch med en kvaternion", vectorCount, result, [&]()
+	{
+		rotations[0].rotate(&input[0], &result[0], vectorCount);
+	});
+
+	measure("matrix(), batch med en kvaternion", vectorCount, result, [&]()
+	{
+		Matrix3x3f matrix = rotations[0].matrix();
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = matrix * input[i];
+	});
+}
+
+
+
+// Catmull-Rom-splinen från Flythrough::evaluate, en lång kedja av vektoroperationer per punkt.
+// Varje operator skapar en ny Vector3, men eftersom allt är inline ska kompilatorn kunna lägga
+// hela kedjan i register. Den jämförs med madd på vikterna och med samma kedja skriven komponentvis.
+static void benchmarkChain()
+{
+	printf("chain: %u Catmull-Rom-punkter\n", vectorCount);
+
+	std::vector<Vector3f> points = randomVectors(vectorCount + 3);
+	std::vector<float> parameters(vectorCount);
+	for (unsigned i = 0; i < vectorCount; i++)
+		parameters[i] = rand() / float(RAND_MAX);
+	std::vector<Vector3f> result(vectorCount);
+
+	measure("operatorer", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+		{
+			const Vector3f &p0 = points[i], &p1 = points[i + 1], &p2 = points[i + 2], &p3 = points[i + 3];
+			float u = parameters[i];
+			float u2 = u * u;
+			float u3 = u2 * u;
+			result[i] = (p1 * 2.0f
+				+ (p2 - p0) * u
+				+ (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * u2
+				+ (p1 * 3.0f - p0 - p2 * 3.0f + p3) * u3) * 0.5f;
+		}
+	});
+
+	measure("komponentvis", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+		{
+			const Vector3f &p0 = points[i], &p1 = points[i + 1], &p2 = points[i + 2], &p3 = points[i + 3];
+			float u = parameters[i];
+			float u2 = u * u;
+			float u3 = u2 * u;
+			for (unsigned c = 0; c < 3; c++)
+			{
+				result[i][c] = (p1[c] * 2.0f
+					+ (p2[c] - p0[c]) * u
+					+ (p0[c] * 2.0f - p1[c] * 5.0f + p2[c] * 4.0f - p3[c]) * u2
+					+ (p1[c] * 3.0f - p0[c] - p2[c] * 3.0f + p3[c]) * u3) * 0.5f;
+			}
+		}
+	});
+
+	measure("madd med vikter", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+		{
+			float weights[4];
+			catmullRomWeights(parameters[i], weights);
+			result[i] = madd(madd(madd(points[i] * weights[0], points[i + 1], weights[1]), points[i + 2], weights[2]), points[i + 3], weights[3]);
+		}
+	});
+
+	measure("addScaled med vikter", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+		{
+			float weights[4];
+			catmullRomWeights(parameters[i], weights);
+			Vector3f &position = result[i];
+			position = points[i] * weights[0];
+			position.addScaled(points[i + 1], weights[1]);
+			position.addScaled(points[i + 2], weights[2]);
+			position.addScaled(points[i + 3], weights[3]);
+		}
+	});
+}
+
+
+
+// Vector3 mot den SSE-baserade Vector3A i samma loopar
+static void benchmarkVector3A()
+{
+	printf("vector3a: %u vektorer\n", vectorCount);
+
+	std::vector<Vector3f> input = randomVectors(vectorCount);
+	std::vector<Vector3f> other = randomVectors(vectorCount);
+	AlignedVectors alignedInput(vectorCount), alignedOther(vectorCount);
+	for (unsigned i = 0; i < vectorCount; i++)
+	{
+		alignedInput[i] = Vector3Af(input[i]);
+		alignedOther[i] = Vector3Af(other[i]);
+	}
+	std::vector<Vector3f> result(vectorCount);
+	AlignedVectors alignedResult(vectorCount);
+
+	measure("normalize, Vector3", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = input[i].getNormalized();
+	});
+
+	measure("normalize, Vector3A", vectorCount, alignedResult, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			alignedResult[i] = alignedInput[i].getNormalized();
+	});
+
+	measure("snabb normalize, Vector3A", vectorCount, alignedResult, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			alignedResult[i] = alignedInput[i].getFastNormalized();
+	});
+
+	// Kostnaden för att gå via Vector3A i kod som annars använder Vector3
+	measure("normalize via konvertering", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = Vector3f(Vector3Af(input[i]).getNormalized());
+	});
+
+	measure("kryss och skalär, Vector3", vectorCount, result, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			result[i] = input[i].crossProduct(other[i]) * input[i].dotProduct(other[i]);
+	});
+
+	measure("kryss och skalär, Vector3A", vectorCount, alignedResult, [&]()
+	{
+		for (unsigned i = 0; i < vectorCount; i++)
+			alignedResult[i] = alignedInput[i].crossProduct(alignedOther[i]) * alignedInput[i].dotProduct(alignedOther[i]);
+	});
+}
+
+
+
+// Bästa tiden av några körningar, för mätningar som är för långa för measure
+template<typename Function>
+static double bestMilliseconds(unsigned runs, Function function)
+{
+	double best = 1e30;
+	for (unsigned r = 0; r < runs; r++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+
+
+static bool boxOutsideFrustum(const Frustum &frustum, const BoundingBox &box)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const Vector4f &plane = frustum.planes[i];
+		float x = plane.x() > 0 ? box.maximum.x() : box.minimum.x();
+		float y = plane.y() > 0 ? box.maximum.y() : box.minimum.y();
+		float z = plane.z() > 0 ? box.maximum.z() : box.minimum.z();
+		if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0)
+			return true;
+	}
+	return false;
+}
+
+
+
+// Avståndet dit strålen går in i lådan, eller -1 om den missar
+static float rayBoxDistance(const Vector3f &origin, const Vector3f &inverse, const BoundingBox &box, float maxDistance)
+{
+	float entry = 0, exit = maxDistance;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (box.minimum[axis] - origin[axis]) * inverse[axis];
+		float t1 = (box.maximum[axis] - origin[axis]) * inverse[axis];
+		entry = std::max(entry, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+	}
+	return entry <= exit ? entry : -1;
+}
+
+
+
+// Hierarkin mot att gå igenom alla objekt, för allt fler objekt utspridda i en kub där
+// tätheten är densamma. Gallringen görs med kamerans stympe, strålarna är närmaste träff
+// från slumpade punkter och överlappen små lådor. Antalet träffar skrivs ut för båda, så
+// att det syns att de ger samma svar.
+static void benchmarkBvh()
+{
+	printf("bvh: bygge, refit och frågor mot linjär genomgång\n");
+
+	const unsigned counts[] = { 1000, 10000, 100000, 1000000 };
+	const unsigned queries = 256;
+	for (unsigned c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		unsigned count = counts[c];
+		float side = 10 * cbrtf(float(count));
+
+		std::vector<Vector3f> centers = randomVectors(count);
+		std::vector<BoundingBox> boxes(count), moved(count);
+		for (unsigned i = 0; i < count; i++)
+		{
+			float radius = 0.5f + rand() / float(RAND_MAX);
+			boxes[i] = sphereBounds(centers[i] * side, radius);
+			moved[i] = sphereBounds(centers[i] * side + Vector3f(0.5f, 0, 0), radius);
+		}
+
+		Frustum frustum = extractFrustum(createPerspectiveMatrix(60.0f, 4.0f / 3.0f, 1.0f, side)
+			* createLookAtMatrix(Vector3f(0, 0, side * 0.5f), Vector3f(0, 0, 0), Vector3f(0, 1, 0)));
+		std::vector<Vector3f> rayOrigins = randomVectors(queries), rayDirections = randomVectors(queries);
+		std::vector<BoundingBox> regions(queries);
+		for (unsigned q = 0; q < queries; q++)
+		{
+			rayOrigins[q] = rayOrigins[q] * side;
+			rayDirections[q] = rayDirections[q].getNormalized();
+			regions[q] = sphereBounds(centers[q] * side, 5);
+		}
+
+		printf("  %u objekt\n", count);
+
+		Bvh bvh;
+		double build = bestMilliseconds(3, [&]() { bvh.build(boxes.data(), count); });
+		double refit = bestMilliseconds(3, [&]() { bvh.refit(moved.data()); });
+		bvh.build(boxes.data(), count);
+		printf("    %-32s %10.3f ms   (%u noder)\n", "bygge", build, bvh.nodeCount());
+		printf("    %-32s %10.3f ms\n", "refit", refit);
+
+		std::vector<unsigned> results;
+		unsigned found = 0;
+		double tree = bestMilliseconds(5, [&]() { results.clear(); bvh.queryFrustum(frustum, results); });
+		found = results.size();
+		double linear = bestMilliseconds(5, [&]()
+		{
+			results.clear();
+			for (unsigned i = 0; i < count; i++)
+			{
+				if (!boxOutsideFrustum(frustum, boxes[i]))
+					results.push_back(i);
+			}
+		});
+		printf("    %-32s %10.3f ms   linjärt %10.3f ms   (%u / %u synliga)\n", "stympe", tree, linear, found, unsigned(results.size()));
+
+		unsigned hits[2] = {};
+		tree = bestMilliseconds(5, [&]()
+		{
+			hits[0] = 0;
+			for (unsigned q = 0; q < queries; q++)
+			{
+				Vector3f inverse(1 / rayDirections[q].x(), 1 / rayDirections[q].y(), 1 / rayDirections[q].z());
+				float distance = side;
+				unsigned hit = bvh.raycast(rayOrigins[q], rayDirections[q], distance, [&](unsigned object, float maxDistance)
+				{
+					return rayBoxDistance(rayOrigins[q], inverse, boxes[object], maxDistance);
+				});
+				hits[0] += hit != Bvh::noHit;
+			}
+		});
+		linear = bestMilliseconds(5, [&]()
+		{
+			hits[1] = 0;
+			for (unsigned q = 0; q < queries; q++)
+			{
+				Vector3f inverse(1 / rayDirections[q].x(), 1 / rayDirections[q].y(), 1 / rayDirections[q].z());
+				float distance = side;
+				unsigned closest = Bvh::noHit;
+				for (unsigned i = 0; i < count; i++)
+				{
+					float t = rayBoxDistance(rayOrigins[q], inverse, boxes[i], distance);
+					if (t >= 0)
+					{
+						distance = t;
+						closest = i;
+					}
+				}
+				hits[1] += closest != Bvh::noHit;
+			}
+		});
+		printf("    %-32s %10.3f us   linjärt %10.3f us   (%u / %u träffar)\n", "närmaste träff per stråle",
+			tree * 1000 / queries, linear * 1000 / queries, hits[0], hits[1]);
+
+		tree = bestMilliseconds(5, [&]()
+		{
+			results.clear();
+			for (unsigned q = 0; q < queries; q++)
+				bvh.queryOverlap(regions[q], results);
+		});
+		found = results.size();
+		linear = bestMilliseconds(5, [&]()
+		{
+			results.clear();
+			for (unsigned q = 0; q < queries; q++)
+			{
+				for (unsigned i = 0; i < count; i++)
+				{
+					const BoundingBox &a = regions[q], &b = boxes[i];
+					if (a.minimum.x() <= b.maximum.x() && a.maximum.x() >= b.minimum.x()
+						&& a.minimum.y() <= b.maximum.y() && a.maximum.y() >= b.minimum.y()
+						&& a.minimum.z() <= b.maximum.z() && a.maximum.z() >= b.minimum.z())
+						results.push_back(i);
+				}
+			}
+		});
+		printf("    %-32s %10.3f us   linjärt %10.3f us   (%u / %u överlapp)\n", "överlapp per låda",
+			tree * 1000 / queries, linear * 1000 / queries, found, unsigned(results.size()));
+	}
+}
+
+
+
+// Skriver ett rutnät med v, vt, vn och fyrhörniga ytor tills filen är ungefär bytes stor
+static bool writeBenchmarkObj(const char *file, size_t bytes)
+{
+	FILE *out = fopen(file, "wb");
+	if (!out)
+	{
+		fprintf(stderr, "Kunde inte skapa %s\n", file);
+		return false;
+	}
+
+	const unsigned width = 1000;
+	size_t written = 0;
+	char buffer[512];
+	for (unsigned row = 0; written < bytes; row++)
+	{
+		for (unsigned i = 0; i < width; i++)
+		{
+			float u = i / float(width), v = row * 0.001f, height = sinf(u * 40) * cosf(v * 30);
+			written += fwrite(buffer, 1, sprintf(buffer, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+				u * 100 - 50, height, v * 100 - 50, u, v, -height * 0.2f, 0.98f, 0.1f), out);
+		}
+		if (row == 0)
+			continue;
+		for (unsigned i = 0; i + 1 < width; i++)
+		{
+			unsigned a = (row - 1) * width + i + 1, b = a + 1, c = a + width + 1, d = a + width;
+			written += fwrite(buffer, 1, sprintf(buffer, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d), out);
+		}
+	}
+	fclose(out);
+	return true;
+}
+
+
+
+// Samma tolkning rad för rad med strtof och strtol, som jämförelse
+static unsigned parseObjWithStrtof(const char *text, size_t size, std::vector<float> &values)
+{
+	values.clear();
+	unsigned corners = 0;
+	const char *cursor = text, *end = text + size;
+	std::string line;
+	while (cursor < end)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+		if (!lineEnd)
+			lineEnd = end;
+		line.assign(cursor, lineEnd);
+		cursor = lineEnd + 1;
+
+		const char *p = line.c_str();
+		char *next;
+		if (p[0] == 'v')
+		{
+			p += 2;
+			for (int i = 0; i < (line[1] == 't' ? 2 : 3); i++, p = next)
+				values.push_back(strtof(p, &next));
+		}
+		else if (p[0] == 'f')
+		{
+			for (p += 1; *p; p = next)
+			{
+				strtol(p, &next, 10);
+				if (next == p)
+					break;
+				corners++;
+				while (*next == '/')
+					strtol(next + 1, &next, 10);
+			}
+		}
+	}
+	return corners;
+}
+
+
+
+// OBJ-tolkningen i MB/s på en stor genererad fil: strtof rad för rad, ObjParser på en
+// tråd och ObjParser på hela trådpoolen. Filen läses en gång först, så att alla mätningar
+// läser från filcachen och inte från disken.
+static void benchmarkObjParse()
+{
+	const char *file = "objbench.obj";
+	const size_t bytes = size_t(256) << 20;
+	printf("objparse: skriver %u MB till %s\n", unsigned(bytes >> 20), file);
+	if (!writeBenchmarkObj(file, bytes))
+		return;
+
+	MappedFile source;
+	if (!source.open(file))
+	{
+		fprintf(stderr, "Kunde inte öppna %s\n", file);
+		return;
+	}
+	double megabytes = source.size() / double(1 << 20);
+	volatile unsigned touch = 0;
+	for (size_t i = 0; i < source.size(); i += 4096)
+		touch += source.data()[i];
+
+	std::vector<float> values;
+	unsigned corners = 0;
+	double baseline = bestMilliseconds(3, [&]() { corners = parseObjWithStrtof(source.data(), source.size(), values); });
+	printf("  %-34s %8.1f MB/s   (%u tal, %u hörn)\n", "strtof rad för rad", megabytes * 1000 / baseline, unsigned(values.size()), corners);
+
+	ObjParser parser;
+	double single = bestMilliseconds(3, [&]() { parser.parse(source.data(), source.size(), file); });
+	printf("  %-34s %8.1f MB/s   (%u positioner, %u triangelhörn)\n", "ObjParser, en tråd", megabytes * 1000 / single,
+		parser.positionCount(), unsigned(parser.corners().size()));
+
+	ThreadPool pool;
+	parser.setThreadPool(&pool);
+	double parallel = bestMilliseconds(3, [&]() { parser.parse(source.data(), source.size(), file); });
+	printf("  %-34s %8.1f MB/s   (%u trådar)\n", "ObjParser, trådpoolen", megabytes * 1000 / parallel, pool.size());
+
+	source.close();
+	remove(file);
+}
+
+
+
+static void printCacheStats(const char *name, const std::vector<unsigned> &indices, unsigned vertexCount, double milliseconds)
+{
+	VertexCacheStats stats = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+	printf("  %-34s ACMR %.3f   ATVR %.3f", name, stats.acmr, stats.atvr);
+	if (milliseconds >= 0)
+		printf("   %8.1f ms", milliseconds);
+	printf("\n");
+}
+
+
+
+// Indexoptimeringen på ett rutnät med trianglarna i slumpad ordning, som i en dåligt
+// exporterad modell. Radordningen visas som jämförelse; den är bra men inte bäst, eftersom
+// en rad är längre än cachen.
+static void benchmarkMeshOpt()
+{
+	const unsigned side = 512;
+	printf("meshopt: rutnät med %u trianglar\n", side * side * 2);
+
+	std::vector<MeshVertex> vertices((side + 1) * (side + 1));
+	for (unsigned y = 0; y <= side; y++)
+	{
+		for (unsigned x = 0; x <= side; x++)
+		{
+			MeshVertex &vertex = vertices[y * (side + 1) + x];
+			float position[3] = { float(x), 0, float(y) }, normal[3] = { 0, 1, 0 };
+			memcpy(vertex.position, position, sizeof(position));
+			memcpy(vertex.normal, normal, sizeof(normal));
+			vertex.texCoord[0] = x / float(side);
+			vertex.texCoord[1] = y / float(side);
+		}
+	}
+
+	std::vector<unsigned> rows;
+	for (unsigned y = 0; y < side; y++)
+	{
+		for (unsigned x = 0; x < side; x++)
+		{
+			unsigned corner = y * (side + 1) + x;
+			unsigned quad[6] = { corner, corner + side + 1, corner + 1, corner + 1, corner + side + 1, corner + side + 2 };
+			rows.insert(rows.end(), quad, quad + 6);
+		}
+	}
+	printCacheStats("radordning", rows, vertices.size(), -1);
+
+	std::vector<unsigned> shuffled = rows;
+	unsigned triangleCount = shuffled.size() / 3;
+	for (unsigned t = triangleCount - 1; t > 0; t--)
+	{
+		unsigned other = ((unsigned(rand()) << 15) ^ unsigned(rand())) % (t + 1);
+		std::swap_ranges(&shuffled[t * 3], &shuffled[t * 3] + 3, &shuffled[other * 3]);
+	}
+	printCacheStats("slumpad", shuffled, vertices.size(), -1);
+
+	std::vector<unsigned> indices;
+	double cacheTime = bestMilliseconds(3, [&]()
+	{
+		indices = shuffled;
+		optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+	});
+	printCacheStats("optimizeVertexCache", indices, vertices.size(), cacheTime);
+
+	std::vector<unsigned> cacheOrder = indices;
+	double overdrawTime = bestMilliseconds(3, [&]()
+	{
+		indices = cacheOrder;
+		optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+	});
+	printCacheStats("optimizeOverdraw", indices, vertices.size(), overdrawTime);
+
+	std::vector<MeshVertex> reordered = vertices;
+	unsigned used = 0;
+	double fetchTime = bestMilliseconds(1, [&]() { used = optimizeVertexFetch(reordered.data(), indices.data(), indices.size(), vertices.size()); });
+	printCacheStats("optimizeVertexFetch", indices, used, fetchTime);
+}
+
+
+
+struct MathBenchmark
+{
+	const char *name;
+	void (*run)();
+};
+
+static const MathBenchmark benchmarks[] =
+{
+	{ "rotate", benchmarkRotate },
+	{ "chain", benchmarkChain },
+	{ "vector3a", benchmarkVector3A },
+	{ "bvh", benchmarkBvh },
+	{ "objparse", benchmarkObjParse },
+	{ "meshopt", benchmarkMeshOpt }
+};
+
+
+
+int runMathBenchmark(const char *name)
+{
+	bool found = false;
+	for (unsigned i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+	{
+		if (!name || strcmp(name, benchmarks[i].name) == 0)
+		{
+			srand(1);
+			benchmarks[i].run();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		fprintf(stderr, "Okänd benchmark: %s\n", name);
+		return 1;
+	}
+	return 0;
+}
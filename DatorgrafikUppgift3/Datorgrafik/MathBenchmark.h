@@ -0,0 +1,12 @@
+#ifndef MATHBENCHMARK_H
+#define MATHBENCHMARK_H
+
+
+
+// Mikrobenchmarkar för matematikbiblioteket och geometrikoden. De körs med -mathbench [namn]
+// innan något fönster öppnas, skriver ut sina resultat och avslutar.
+int runMathBenchmark(const char *name);	// NULL kör alla. Returnerar 1 om namnet är okänt.
+
+
+
+#endif
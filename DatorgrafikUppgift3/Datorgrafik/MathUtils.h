@@ -14,7 +14,7 @@
    *@return The result of the operator* is the result of the multiplication.
   */
 template<typename T>
-Vector3<T> operator*(const Matrix3x3<T>& matrix, const Vector3<T>& vector)
+constexpr Vector3<T> operator*(const Matrix3x3<T>& matrix, const Vector3<T>& vector)
 {
   return Vector3<T>(matrix[0]*vector.x()+matrix[3]*vector.y()+matrix[6]*vector.z(),
 		    matrix[1]*vector.x()+matrix[4]*vector.y()+matrix[7]*vector.z(),
@@ -28,7 +28,7 @@ Vector3<T> operator*(const Matrix3x3<T>& matrix, const Vector3<T>& vector)
    *@return The result of the operator* is the result of the multiplication.
   */
 template<typename T>
-Vector4<T> operator*(const Matrix4x4<T>& matrix, const Vector4<T>& vector)
+constexpr Vector4<T> operator*(const Matrix4x4<T>& matrix, const Vector4<T>& vector)
 {
   return Vector4<T>(matrix[0]*vector.x()+matrix[4]*vector.y()+matrix[8]*vector.z()+matrix[12]*vector.w(),
 		    matrix[1]*vector.x()+matrix[5]*vector.y()+matrix[9]*vector.z()+matrix[13]*vector.w(),
@@ -108,13 +108,12 @@ Matrix4x4<T> createRotationMatrix(T head, T pitch, T roll)
    *@return The translation matrix.
   */
 template<typename T>
-Matrix4x4<T> createTranslationMatrix(T x, T y, T z)
+constexpr Matrix4x4<T> createTranslationMatrix(T x, T y, T z)
 {
 	return Matrix4x4<T>(1, 0, 0, x,
                         0, 1, 0, y,
                         0, 0, 1, z,
                         0, 0, 0, 1);
-					
 }
 
 /**
@@ -125,17 +124,168 @@ Matrix4x4<T> createTranslationMatrix(T x, T y, T z)
    *@return The translation matrix.
   */
 template<typename T>
-Matrix4x4<T> createScaleMatrix(T x, T y, T z)
+constexpr Matrix4x4<T> createScaleMatrix(T x, T y, T z)
 {
 	return Matrix4x4<T>(x, 0, 0, 0,
                         0, y, 0, 0,
                         0, 0, z, 0,
                         0, 0, 0, 1);
-					
 }
 
 /**
-   *@brief The interpolate function can be used to perform linear interpolation between matrices.
+   *@brief The constantSqrt function computes a square root with Newton's method, so that it can be
+   *evaluated at compile time. Use sqrt at runtime.
+   *@param x = A non-negative value.
+   *@return The square root of x.
+  */
+template<typename T>
+constexpr T constantSqrtStep(T x, T guess, int steps)
+{
+  return steps == 0 || guess*guess == x ? guess : constantSqrtStep(x, (guess + x/guess)/2, steps - 1);
+}
+
+template<typename T>
+constexpr T constantSqrt(T x)
+{
+  return x <= 0 ? T(0) : constantSqrtStep(x, x < 1 ? T(1) : x, 100);
+}
+
+/**
+   *@brief The constantTan function computes the tangent from the Taylor series of sine and cosine, so that
+   *it can be evaluated at compile time. It is accurate for angles between -pi/2 and pi/2. Use tan at runtime.
+   *@param angle = The angle expressed in radians.
+   *@return The tangent of the angle.
+  */
+template<typename T>
+constexpr T constantTaylorSeries(T angleSquared, T term, int n, int terms)
+{
+  return terms == 0 ? T(0) : term + constantTaylorSeries(angleSquared, -term*angleSquared/T((n + 1)*(n + 2)), n + 2, terms - 1);
+}
+
+template<typename T>
+constexpr T constantTan(T angle)
+{
+  return constantTaylorSeries(angle*angle, angle, 1, 12) / constantTaylorSeries(angle*angle, T(1), 0, 12);
+}
+
+/**
+   *@brief The constantNormalized function returns a normalized copy of a vector and can be evaluated at compile time.
+   *@param vector = The vector to normalize. It must not be the zero vector.
+   *@return The normalized vector.
+  */
+template<typename T>
+constexpr Vector3<T> constantNormalized(const Vector3<T>& vector)
+{
+  return vector / constantSqrt(vector.lengthSquared());
+}
+
+/**
+   *@brief The createViewMatrix function creates a view matrix from the camera's position and orthonormal axes.
+   *@param eye = The position of the camera.
+   *@param forward = The direction the camera looks in.
+   *@param side = The direction to the right of the camera.
+   *@param up = The up direction of the camera.
+   *@return The view matrix.
+  */
+template<typename T>
+constexpr Matrix4x4<T> createViewMatrix(const Vector3<T>& eye, const Vector3<T>& forward, const Vector3<T>& side, const Vector3<T>& up)
+{
+	return Matrix4x4<T>(side.x(), side.y(), side.z(), -side.dotProduct(eye),
+                        up.x(), up.y(), up.z(), -up.dotProduct(eye),
+                        -forward.x(), -forward.y(), -forward.z(), forward.dotProduct(eye),
+                        0, 0, 0, 1);
+}
+
+/**
+   *@brief The createLookAtMatrix function creates a view matrix in the same way as gluLookAt.
+   *@param eye = The position of the camera.
+   *@param center = The point the camera looks at.
+   *@param up = The approximate up direction of the camera.
+   *@return The view matrix.
+  */
+template<typename T>
+Matrix4x4<T> createLookAtMatrix(const Vector3<T>& eye, const Vector3<T>& center, const Vector3<T>& up)
+{
+	Vector3<T> forward = (center - eye).getNormalized();
+	Vector3<T> side = forward.crossProduct(up).getNormalized();
+
+	return createViewMatrix(eye, forward, side, side.crossProduct(forward));
+}
+
+/**
+   *@brief The createConstantViewMatrix function completes the axes for createConstantLookAtMatrix. A constexpr
+   *function may only contain a return statement, so the up vector is computed in this extra step.
+  */
+template<typename T>
+constexpr Matrix4x4<T> createConstantViewMatrix(const Vector3<T>& eye, const Vector3<T>& forward, const Vector3<T>& side)
+{
+	return createViewMatrix(eye, forward, side, side.crossProduct(forward));
+}
+
+/**
+   *@brief The createConstantLookAtMatrix function gives the same result as createLookAtMatrix, but can be
+   *evaluated at compile time, e.g. for cameras that never move.
+   *@param eye = The position of the camera.
+   *@param center = The point the camera looks at.
+   *@param up = The approximate up direction of the camera.
+   *@return The view matrix.
+  */
+template<typename T>
+constexpr Matrix4x4<T> createConstantLookAtMatrix(const Vector3<T>& eye, const Vector3<T>& center, const Vector3<T>& up)
+{
+	return createConstantViewMatrix(eye, constantNormalized(center - eye), constantNormalized(constantNormalized(center - eye).crossProduct(up)));
+}
+
+/**
+   *@brief The createFocalPerspectiveMatrix function creates a projection matrix from the focal length
+   *1/tan(fovy/2) instead of the field of view.
+   *@param focal = The focal length.
+   *@param aspect = The width of the view divided by its height.
+   *@param zNear = The distance to the near clipping plane.
+   *@param zFar = The distance to the far clipping plane.
+   *@return The projection matrix.
+  */
+template<typename T>
+constexpr Matrix4x4<T> createFocalPerspectiveMatrix(T focal, T aspect, T zNear, T zFar)
+{
+	return Matrix4x4<T>(focal / aspect, 0, 0, 0,
+                        0, focal, 0, 0,
+                        0, 0, (zFar + zNear) / (zNear - zFar), 2 * zFar * zNear / (zNear - zFar),
+                        0, 0, -1, 0);
+}
+
+/**
+   *@brief The createPerspectiveMatrix function creates a projection matrix in the same way as gluPerspective.
+   *@param fovy = The vertical field of view in degrees.
+   *@param aspect = The width of the view divided by its height.
+   *@param zNear = The distance to the near clipping plane.
+   *@param zFar = The distance to the far clipping plane.
+   *@return The projection matrix.
+  */
+template<typename T>
+Matrix4x4<T> createPerspectiveMatrix(T fovy, T aspect, T zNear, T zFar)
+{
+	return createFocalPerspectiveMatrix(T(1 / tan(fovy * T(3.14159265358979323846) / T(360))), aspect, zNear, zFar);
+}
+
+/**
+   *@brief The createConstantPerspectiveMatrix function gives the same result as createPerspectiveMatrix, but can
+   *be evaluated at compile time when the view has a fixed aspect ratio.
+   *@param fovy = The vertical field of view in degrees.
+   *@param aspect = The width of the view divided by its height.
+   *@param zNear = The distance to the near clipping plane.
+   *@param zFar = The distance to the far clipping plane.
+   *@return The projection matrix.
+  */
+template<typename T>
+constexpr Matrix4x4<T> createConstantPerspectiveMatrix(T fovy, T aspect, T zNear, T zFar)
+{
+	return createFocalPerspectiveMatrix(T(1) / constantTan(fovy * T(3.14159265358979323846) / T(360)), aspect, zNear, zFar);
+}
+
+/**
+   *@brief The interpolate function can be used to perform spherical interpolation between rotation matrices.
+   *Interpolating many rotations is cheaper when they are kept as quaternions, see slerp and QuaternionBatch.h.
    *@param start = The start matrix.
    *@param finish = The end matrix.
    *@param t = A interpolation value (0 = start, 1 = end).
@@ -144,9 +294,7 @@ Matrix4x4<T> createScaleMatrix(T x, T y, T z)
 template<typename T>
 Matrix3x3<T> interpolate(const Matrix3x3<T>& start, const Matrix3x3<T>& finish, float t)
 {
-  Matrix3x3<T> matrix = start.theTranspose()*finish;
-  Quaternion<T> quat(start.theTranspose()*finish);
-  return buildRotationMatrix(quat.axis(), quat.angle()*t);
+  return slerp(Quaternion<T>(start), Quaternion<T>(finish), T(t)).matrix();
 }
 
 /**
@@ -156,7 +304,7 @@ Matrix3x3<T> interpolate(const Matrix3x3<T>& start, const Matrix3x3<T>& finish,
    *@return The result of the componentvise multiplication of the operands.
 */
 template<typename T>
-Vector3<T> operator*(const Vector3<T>& left, const Vector3<T>& right)
+constexpr Vector3<T> operator*(const Vector3<T>& left, const Vector3<T>& right)
 {
 	return Vector3<T>(left.x() * right.x(), left.y() * right.y(), left.z() * right.z());
 }
@@ -168,7 +316,7 @@ Vector3<T> operator*(const Vector3<T>& left, const Vector3<T>& right)
    *@return The result of the componentvise multiplication of the operands.
 */
 template<typename T>
-Vector4<T> operator*(const Vector4<T>& left, const Vector4<T>& right)
+constexpr Vector4<T> operator*(const Vector4<T>& left, const Vector4<T>& right)
 {
 	return Vector4<T>(left.x() * right.x(), left.y() * right.y(), left.z() * right.z(), left.w() * right.w());
 }
@@ -20,7 +20,7 @@ class Matrix3x3
 	/**
 	*\brief This is the Matrix3x3 class default constructor. The constructor will create an identity matrix
 	*/
-	Matrix3x3();
+	constexpr Matrix3x3();
 
 	/**
 	*\brief This constructor enables a instance of Matrix3x3 to be initialized using the values pointed to by matrix.
@@ -32,7 +32,7 @@ class Matrix3x3
 	*\brief This constructor enables a instance of Matrix3x3 to be initialize using 9 parameters.
 	*\param m1-m9 = The values to initialize the matrix with.
 	*/
-	Matrix3x3(T m1, T m4, T m7,
+	constexpr Matrix3x3(T m1, T m4, T m7,
 			T m2, T m5, T m8,
 			T m3, T m6, T m9);
 	
@@ -48,14 +48,14 @@ class Matrix3x3
 	*can be used to pass the matrix to APIs such as OpenGL
 	 *\return A pointer to the matrix data.
 	*/
-	const T* data() const;
+	constexpr const T* data() const;
   
 	/**
 	*\brief The theTranspose member function returns the tranpose of the matrix.
 	*\return The member function returns a new matrix that is the transpose of the matrix that 
 	*recieved the message.
 	*/
-	Matrix3x3 theTranspose() const;
+	constexpr Matrix3x3 theTranspose() const;
   
 	/**
 	*\brief The transpose member function can be called in order to transpose the matrix.
@@ -92,14 +92,14 @@ class Matrix3x3
 	*\param matrix = the right hand side operand.
 	*\return The result is a new matrix containing the sum of two matrices.
 	*/
-	Matrix3x3 operator+(const Matrix3x3& matrix) const;
+	constexpr Matrix3x3 operator+(const Matrix3x3& matrix) const;
 	
 	/**
 	*\brief The operator- enables matrix-matrix subtraction.
 	*\param matrix = the right hand side operand.
 	*\return The result is a new matrix containing the difference between to matrices.
 	*/
-	Matrix3x3 operator-(const Matrix3x3& matrix) const;
+	constexpr Matrix3x3 operator-(const Matrix3x3& matrix) const;
 
 	/**
 	*\brief The operator+= enables matrix-matrix addition.
@@ -145,7 +145,7 @@ class Matrix3x3
 	*\param i = the index of the matrix element
 	*return The operator[] returns a reference to the i'th matrix element.
 	*/
-	inline const T& operator[](unsigned int i) const;
+	constexpr const T& operator[](unsigned int i) const;
 
 	/**
 	 *\brief The assign member function can be used in order to set the entires of a matrix.
@@ -174,7 +174,7 @@ typedef Matrix3x3<double> Matrix3x3d;
     *\param matrix = The matrix to multiply.
 */
 template<typename T>
-Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix);
+constexpr Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix);
 
 /**
 	*\brief The operator* makes it possible to multiply 3x3 matrices.
@@ -182,7 +182,7 @@ Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix);
     *\param right = The right operand.
 */
 template<typename T>
-Matrix3x3<T> operator*(const Matrix3x3<T>& left, const Matrix3x3<T>& right);
+constexpr Matrix3x3<T> operator*(const Matrix3x3<T>& left, const Matrix3x3<T>& right);
 
 
 
@@ -190,7 +190,7 @@ template<typename T>
 const Matrix3x3<T> Matrix3x3<T>::identity;
 
 template<typename T>
-Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix)
+constexpr Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix)
 {
   return Matrix3x3<T>(matrix[0]*factor, matrix[3]*factor, matrix[6]*factor,
 		      matrix[1]*factor, matrix[4]*factor, matrix[7]*factor,
@@ -198,18 +198,15 @@ Matrix3x3<T> operator*(T factor, const Matrix3x3<T>& matrix)
 }
 
 template<typename T>
-Matrix3x3<T> operator*(const Matrix3x3<T>& matrix, T factor)
+constexpr Matrix3x3<T> operator*(const Matrix3x3<T>& matrix, T factor)
 {
   return factor*matrix;
 }
 
 template<typename T>
-Matrix3x3<T>::Matrix3x3()
+constexpr Matrix3x3<T>::Matrix3x3()
+  : m_matrix{1, 0, 0, 0, 1, 0, 0, 0, 1}
 {
-  memset(m_matrix, 0, 9*sizeof(T));
-  m_matrix[0] = 1.0;
-  m_matrix[4] = 1.0;
-  m_matrix[8] = 1.0;
 }
 
 template<typename T>
@@ -219,20 +216,11 @@ Matrix3x3<T>::Matrix3x3(T *matrix)
 }
 
 template<typename T>
-Matrix3x3<T>::Matrix3x3(T m1, T m4, T m7,
+constexpr Matrix3x3<T>::Matrix3x3(T m1, T m4, T m7,
 			T m2, T m5, T m8,
 			T m3, T m6, T m9)
+  : m_matrix{m1, m2, m3, m4, m5, m6, m7, m8, m9}
 {
-  m_matrix[0] = m1;
-  m_matrix[1] = m2;
-  m_matrix[2] = m3;
-  m_matrix[3] = m4;  
-  m_matrix[4] = m5;
-  m_matrix[5] = m6;  
-  m_matrix[6] = m7;
-  m_matrix[7] = m8;
-  m_matrix[8] = m9;
-
 }
 
 template<typename T>
@@ -242,22 +230,21 @@ T* Matrix3x3<T>::data()
 }
 
 template<typename T>
-const T* Matrix3x3<T>::data() const
+constexpr const T* Matrix3x3<T>::data() const
 {
   return m_matrix;
 }
 
 template<typename T>
-Matrix3x3<T> Matrix3x3<T>::operator+(const Matrix3x3& mat) const
+constexpr Matrix3x3<T> Matrix3x3<T>::operator+(const Matrix3x3& mat) const
 {
   return Matrix3x3<T>(m_matrix[0]+mat.m_matrix[0], m_matrix[3]+mat.m_matrix[3], m_matrix[6]+mat.m_matrix[6],
 		      m_matrix[1]+mat.m_matrix[1], m_matrix[4]+mat.m_matrix[4], m_matrix[7]+mat.m_matrix[7],
 		      m_matrix[2]+mat.m_matrix[2], m_matrix[5]+mat.m_matrix[5], m_matrix[8]+mat.m_matrix[8]);
- 
-    }
+}
 
 template<typename T>
-Matrix3x3<T> Matrix3x3<T>::operator-(const Matrix3x3& mat) const
+constexpr Matrix3x3<T> Matrix3x3<T>::operator-(const Matrix3x3& mat) const
 {
   return Matrix3x3<T>(m_matrix[0]-mat.m_matrix[0], m_matrix[3]-mat.m_matrix[3], m_matrix[6]-mat.m_matrix[6],
 		      m_matrix[1]-mat.m_matrix[1], m_matrix[4]-mat.m_matrix[4], m_matrix[7]-mat.m_matrix[7],
@@ -266,7 +253,7 @@ Matrix3x3<T> Matrix3x3<T>::operator-(const Matrix3x3& mat) const
 
 
 template<typename T>
-Matrix3x3<T> operator*(const Matrix3x3<T>& left,  const Matrix3x3<T>& right)
+constexpr Matrix3x3<T> operator*(const Matrix3x3<T>& left,  const Matrix3x3<T>& right)
 {
   return Matrix3x3<T>(left[0]*right[0]+left[3]*right[1]+left[6]*right[2], left[0]*right[3]+left[3]*right[4]+left[6]*right[5], left[0]*right[6]+left[3]*right[7]+left[6]*right[8],
 		   left[1]*right[0]+left[4]*right[1]+left[7]*right[2], left[1]*right[3]+left[4]*right[4]+left[7]*right[5], left[1]*right[6]+left[4]*right[7]+left[7]*right[8],
@@ -324,7 +311,7 @@ T Matrix3x3<T>::determinant() const
 }
 
 template<typename T>
-Matrix3x3<T> Matrix3x3<T>::theTranspose() const
+constexpr Matrix3x3<T> Matrix3x3<T>::theTranspose() const
 {
   return Matrix3x3<T>(m_matrix[0], m_matrix[1], m_matrix[2],
 		      m_matrix[3], m_matrix[4], m_matrix[5],
@@ -404,7 +391,7 @@ inline T& Matrix3x3<T>::operator[](unsigned int i)
 }
 
 template<typename T>
-inline const T& Matrix3x3<T>::operator[](unsigned int i) const
+constexpr const T& Matrix3x3<T>::operator[](unsigned int i) const
 {
   return m_matrix[i];
 }
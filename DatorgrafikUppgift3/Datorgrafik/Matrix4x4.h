@@ -19,7 +19,7 @@ public:
   /**
    *@brief This is the Matrix4x4 class default constructor.
   */
-  Matrix4x4();
+  constexpr Matrix4x4();
 
   /**
    *@brief This constructor enables a instance of Matrix4x4 to be initialized using the values pointed to by matrix.
@@ -31,7 +31,7 @@ public:
    *@brief This constructor enables a instance of Matrix4x4 to be initialize using 16 parameters.
    *@param m1-m16 = The values to initialize the matrix with.
   */
-  Matrix4x4(T m1, T m5, T m9,  T m13, 
+  constexpr Matrix4x4(T m1, T m5, T m9,  T m13, 
             T m2, T m6, T m10, T m14,
             T m3, T m7, T m11, T m15,
             T m4, T m8, T m12, T m16);
@@ -40,14 +40,14 @@ public:
    *@brief This constructor enables a instance of Matrix4x4 to be initialize using a 3x3 matrix.
    *@param matrix = The values to initialize the upper left submatrix with.
   */
-  explicit Matrix4x4(const Matrix3x3<T>& matrix);
+  constexpr explicit Matrix4x4(const Matrix3x3<T>& matrix);
 
   /**
    *@brief The data member function returns a pointer to the matrix data. The member function
    *can be used to pass the matrix to APIs such as OpenGL
    *@return A pointer to the matrix data.
   */
-  inline const T* data() const;
+  constexpr const T* data() const;
 
    /**
    *@brief The data member function returns a pointer to the matrix data. The member function
@@ -61,7 +61,7 @@ public:
    *@return The member function returns a new matrix that is the transpose of the matrix that 
    *recieved the message.
   */
-  Matrix4x4 theTranspose() const;
+  constexpr Matrix4x4 theTranspose() const;
   
   /**
    *@brief The transpose member function can be called in order to transpose the matrix.
@@ -98,14 +98,14 @@ public:
    *@param matrix = the right hand side operand.
    *@return The result is a new matrix containing the sum of two matrices.
    */
-  Matrix4x4 operator+(const Matrix4x4<T>& matrix) const;
+  constexpr Matrix4x4 operator+(const Matrix4x4<T>& matrix) const;
 
   /**
    *@brief The operator- enables matrix-matrix subtraction.
    *@param matrix = the right hand side operand.
    *@return The result is a new matrix containing the difference between to matrices.
    */
-  Matrix4x4 operator-(const Matrix4x4<T>& matrix) const;
+  constexpr Matrix4x4 operator-(const Matrix4x4<T>& matrix) const;
   
   /**
    *@brief The operator+= enables matrix-matrix addition.
@@ -160,7 +160,7 @@ public:
    *@param i = the index of the matrix element
    *return The operator[] returns a reference to the i'th matrix element.
   */
-  inline const T& operator[](unsigned int i) const;
+  constexpr const T& operator[](unsigned int i) const;
 
   /**
    *@brief The assign member function can be used in order to set the entires of a matrix.
@@ -189,7 +189,7 @@ template <typename T>
 const Matrix4x4<T> Matrix4x4<T>::identity;
 
 template <typename T>
-Matrix4x4<T> operator*(T factor, const Matrix4x4<T>& matrix)
+constexpr Matrix4x4<T> operator*(T factor, const Matrix4x4<T>& matrix)
 {
   return Matrix4x4<T>(matrix[0]*factor, matrix[4]*factor, matrix[8]*factor, matrix[12]*factor, 
 		      matrix[1]*factor, matrix[5]*factor, matrix[9]*factor, matrix[13]*factor, 
@@ -198,13 +198,13 @@ Matrix4x4<T> operator*(T factor, const Matrix4x4<T>& matrix)
 }
 
 template <typename T>
-Matrix4x4<T> operator*(const Matrix4x4<T>& matrix, T factor)
+constexpr Matrix4x4<T> operator*(const Matrix4x4<T>& matrix, T factor)
 {
   return factor*matrix;
 }
 
 template <typename T>
-Matrix4x4<T> operator*(const Matrix4x4<T>& left, const Matrix4x4<T>& right)
+constexpr Matrix4x4<T> operator*(const Matrix4x4<T>& left, const Matrix4x4<T>& right)
 {
   return Matrix4x4<T>(left[0]*right[0]+left[4]*right[1]+left[8]*right[2]+left[12]*right[3],
 		      left[0]*right[4]+left[4]*right[5]+left[8]*right[6]+left[12]*right[7],
@@ -229,10 +229,9 @@ Matrix4x4<T> operator*(const Matrix4x4<T>& left, const Matrix4x4<T>& right)
 }
 
 template <typename T>
-Matrix4x4<T>::Matrix4x4()
+constexpr Matrix4x4<T>::Matrix4x4()
+  : m_matrix{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}
 {
-  memset(m_matrix, 0, 16*sizeof(T));
-  m_matrix[0] = m_matrix[5] = m_matrix[10] = m_matrix[15] = 1.0f;
 }
 
 template <typename T>
@@ -242,37 +241,25 @@ Matrix4x4<T>::Matrix4x4(T* matrix)
 }
 
 template <typename T>
-Matrix4x4<T>::Matrix4x4(T m1, T m5, T m9,  T m13, 
+constexpr Matrix4x4<T>::Matrix4x4(T m1, T m5, T m9,  T m13, 
 	  T m2, T m6, T m10, T m14,
 	  T m3, T m7, T m11, T m15,
 	  T m4, T m8, T m12, T m16)
+  : m_matrix{m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16}
 {
-  m_matrix[0] = m1;
-  m_matrix[1] = m2;
-  m_matrix[2] = m3;
-  m_matrix[3] = m4;
-  m_matrix[4] = m5;
-  m_matrix[5] = m6;
-  m_matrix[6] = m7;
-  m_matrix[7] = m8;
-  m_matrix[8] = m9;
-  m_matrix[9] = m10;
-  m_matrix[10] = m11;
-  m_matrix[11] = m12;
-  m_matrix[12] = m13;
-  m_matrix[13] = m14;
-  m_matrix[14] = m15;
-  m_matrix[15] = m16;
 }
 
 template <typename T>
-Matrix4x4<T>::Matrix4x4(const Matrix3x3<T>& matrix)
+constexpr Matrix4x4<T>::Matrix4x4(const Matrix3x3<T>& matrix)
+  : m_matrix{matrix[0], matrix[1], matrix[2], static_cast<T>(0),
+	     matrix[3], matrix[4], matrix[5], static_cast<T>(0),
+	     matrix[6], matrix[7], matrix[8], static_cast<T>(0),
+	     static_cast<T>(0), static_cast<T>(0), static_cast<T>(0), static_cast<T>(1)}
 {
-    *this = matrix;
 }
 
 template <typename T>
-inline const T* Matrix4x4<T>::data() const
+constexpr const T* Matrix4x4<T>::data() const
 {
   return m_matrix;
 }
@@ -284,7 +271,7 @@ inline T* Matrix4x4<T>::data()
 }
 
 template <typename T>
-Matrix4x4<T> Matrix4x4<T>::theTranspose() const
+constexpr Matrix4x4<T> Matrix4x4<T>::theTranspose() const
 {
   return Matrix4x4<T>(m_matrix[0], m_matrix[1], m_matrix[2], m_matrix[3],
 		      m_matrix[4], m_matrix[5], m_matrix[6], m_matrix[7], 
@@ -583,7 +570,7 @@ T Matrix4x4<T>::determinant() const
 }
 
 template<typename T>
-Matrix4x4<T> Matrix4x4<T>::operator+(const Matrix4x4<T>& matrix) const
+constexpr Matrix4x4<T> Matrix4x4<T>::operator+(const Matrix4x4<T>& matrix) const
 {
   return Matrix4x4<T>(m_matrix[0]+matrix[0], m_matrix[4]+matrix[4], m_matrix[8]+matrix[8], m_matrix[12]+matrix[12],
 		      m_matrix[1]+matrix[1], m_matrix[5]+matrix[5], m_matrix[9]+matrix[9], m_matrix[13]+matrix[13],
@@ -593,7 +580,7 @@ Matrix4x4<T> Matrix4x4<T>::operator+(const Matrix4x4<T>& matrix) const
 }
 
 template<typename T>
-Matrix4x4<T> Matrix4x4<T>::operator-(const Matrix4x4<T>& matrix) const
+constexpr Matrix4x4<T> Matrix4x4<T>::operator-(const Matrix4x4<T>& matrix) const
 {
   return Matrix4x4<T>(m_matrix[0]-matrix[0], m_matrix[4]-matrix[4], m_matrix[8]-matrix[8], m_matrix[12]-matrix[12],
 		      m_matrix[1]-matrix[1], m_matrix[5]-matrix[5], m_matrix[9]-matrix[9], m_matrix[13]-matrix[13],
@@ -704,7 +691,7 @@ inline T& Matrix4x4<T>::operator[](unsigned int i)
 }
 
 template <typename T>
-inline const T& Matrix4x4<T>::operator[](unsigned int i) const
+constexpr const T& Matrix4x4<T>::operator[](unsigned int i) const
 {
   return m_matrix[i];
 }
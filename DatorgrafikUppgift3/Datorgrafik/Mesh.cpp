@@ -0,0 +1,793 @@
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+#include "RenderState.h"
+#include "Profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+#include <sys/stat.h>
+
+
+
+static const unsigned cacheVersion = 3;
+
+
+
+Mesh::Mesh()
+{
+	threadPool = NULL;
+	clear();
+}
+
+
+
+void Mesh::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+}
+
+
+
+void Mesh::clear()
+{
+	ownedVertices.clear();
+	ownedIndices.clear();
+	cache.close();
+	vertexData = NULL;
+	indexData = NULL;
+	vertexTotal = indexTotal = 0;
+	memset(levels, 0, sizeof(levels));
+	levelTotal = 1;
+	center = Vector3f(0, 0, 0);
+	radius = 0;
+	before.acmr = before.atvr = 0;
+	after = before;
+}
+
+
+
+const MeshVertex *Mesh::vertices() const
+{
+	return vertexData;
+}
+
+
+
+unsigned Mesh::vertexCount() const
+{
+	return vertexTotal;
+}
+
+
+
+const unsigned *Mesh::indices(unsigned level) const
+{
+	return indexData + levels[level].indexOffset;
+}
+
+
+
+unsigned Mesh::indexCount(unsigned level) const
+{
+	return levels[level].indexCount;
+}
+
+
+
+unsigned Mesh::levelCount() const
+{
+	return levelTotal;
+}
+
+
+
+float Mesh::levelError(unsigned level) const
+{
+	return levels[level].error;
+}
+
+
+
+unsigned Mesh::selectLevel(float scale, float tolerance) const
+{
+	unsigned level = levelTotal - 1;
+	while (level > 0 && levels[level].error * scale > tolerance)
+		level--;
+	return level;
+}
+
+
+
+bool Mesh::fromCache() const
+{
+	return cache.data() != NULL;
+}
+
+
+
+const Vector3f &Mesh::boundCenter() const
+{
+	return center;
+}
+
+
+
+float Mesh::boundRadius() const
+{
+	return radius;
+}
+
+
+
+const VertexCacheStats &Mesh::importedStats() const
+{
+	return before;
+}
+
+
+
+const VertexCacheStats &Mesh::optimizedStats() const
+{
+	return after;
+}
+
+
+
+static bool hasExtension(const char *file, const char *extension)
+{
+	size_t length = strlen(file), extensionLength = strlen(extension);
+	if (length < extensionLength)
+		return false;
+	for (size_t i = 0; i < extensionLength; i++)
+	{
+		if (tolower(file[length - extensionLength + i]) != extension[i])
+			return false;
+	}
+	return true;
+}
+
+
+
+static bool sourceStamp(const char *file, unsigned long long &size, long long &time)
+{
+	struct stat info;
+	if (stat(file, &info) != 0)
+		return false;
+	size = info.st_size;
+	time = info.st_mtime;
+	return true;
+}
+
+
+
+bool Mesh::load(const char *file)
+{
+	PROFILE_SCOPE("Mesh::load");
+
+	CacheHeader expected;
+	memset(&expected, 0, sizeof(expected));
+	memcpy(expected.magic, "MSHC", 4);
+	expected.version = cacheVersion;
+	bool sourceExists = sourceStamp(file, expected.sourceSize, expected.sourceTime);
+
+	// Utan källfil duger vilken cache som helst med rätt format
+	std::string cacheFile = std::string(file) + ".cache";
+	if (readCache(cacheFile.c_str(), sourceExists ? expected : CacheHeader()))
+		return true;
+
+	if (!import(file))
+		return false;
+	writeCache(file);
+	return true;
+}
+
+
+
+bool Mesh::import(const char *file)
+{
+	PROFILE_SCOPE("Mesh::import");
+
+	clear();
+	bool ok;
+	if (hasExtension(file, ".obj"))
+		ok = importObj(file);
+	else if (hasExtension(file, ".ply"))
+		ok = importPly(file);
+	else
+	{
+		fprintf(stderr, "%s: okänt modellformat, bara .obj och .ply går att läsa\n", file);
+		ok = false;
+	}
+
+	if (!ok)
+	{
+		clear();
+		return false;
+	}
+	optimize();
+	buildLevels();
+	computeBounds();
+	return true;
+}
+
+
+
+void Mesh::optimize()
+{
+	PROFILE_SCOPE("Mesh::optimize");
+
+	before = analyzeVertexCache(ownedIndices.data(), ownedIndices.size(), ownedVertices.size());
+	optimizeVertexCache(ownedIndices.data(), ownedIndices.size(), ownedVertices.size());
+	optimizeOverdraw(ownedIndices.data(), ownedIndices.size(), ownedVertices.data(), ownedVertices.size());
+	ownedVertices.resize(optimizeVertexFetch(ownedVertices.data(), ownedIndices.data(), ownedIndices.size(), ownedVertices.size()));
+	after = analyzeVertexCache(ownedIndices.data(), ownedIndices.size(), ownedVertices.size());
+	useOwned();
+}
+
+
+
+// Varje nivå förenklas från den förra till hälften så många trianglar. Det slutar när
+// modellen är för liten för att vara värd en nivå till, eller när låsta sömmar och kanter
+// gör att det inte går att komma ned tillräckligt. Felen läggs ihop, eftersom varje nivå
+// bara vet hur långt den ligger från den förra.
+void Mesh::buildLevels()
+{
+	PROFILE_SCOPE("Mesh::buildLevels");
+
+	const unsigned minTriangles = 256;
+	levels[0].indexOffset = 0;
+	levels[0].indexCount = ownedIndices.size();
+	levels[0].error = 0;
+	levelTotal = 1;
+
+	std::vector<unsigned> previous(ownedIndices), simplified(ownedIndices.size());
+	while (levelTotal < maxLevels && previous.size() / 3 >= minTriangles)
+	{
+		float error;
+		unsigned target = previous.size() / 6 * 3;
+		unsigned count = simplifyMesh(simplified.data(), previous.data(), previous.size(), ownedVertices.data(), ownedVertices.size(), target, error);
+		if (count > previous.size() * 3 / 4)
+			break;
+		optimizeVertexCache(simplified.data(), count, ownedVertices.size());
+
+		Level &level = levels[levelTotal];
+		level.indexOffset = ownedIndices.size();
+		level.indexCount = count;
+		level.error = levels[levelTotal - 1].error + error;
+		ownedIndices.insert(ownedIndices.end(), simplified.begin(), simplified.begin() + count);
+		previous.assign(simplified.begin(), simplified.begin() + count);
+		levelTotal++;
+	}
+	useOwned();
+}
+
+
+
+bool Mesh::readCache(const char *file, const CacheHeader &expected)
+{
+	if (!cache.open(file))
+		return false;
+
+	CacheHeader header;
+	bool valid = cache.size() >= sizeof(header);
+	if (valid)
+	{
+		memcpy(&header, cache.data(), sizeof(header));
+		valid = memcmp(header.magic, "MSHC", 4) == 0 && header.version == cacheVersion
+			&& cache.size() == sizeof(header) + (unsigned long long)header.vertexCount * sizeof(MeshVertex)
+				+ (unsigned long long)header.indexCount * sizeof(unsigned)
+			&& header.levelCount >= 1 && header.levelCount <= maxLevels;
+	}
+	for (unsigned level = 0; valid && level < header.levelCount; level++)
+	{
+		const Level &range = header.levels[level];
+		valid = range.indexOffset <= header.indexCount && range.indexCount <= header.indexCount - range.indexOffset;
+	}
+	if (valid && expected.version != 0)
+		valid = header.sourceSize == expected.sourceSize && header.sourceTime == expected.sourceTime;
+
+	// Indexen går direkt till glDrawElements, så en trasig cache får inte peka utanför hörnen.
+	// Utan källfil tas vilken välformad cache som helst, så det kontrolleras alltid.
+	if (valid)
+	{
+		const unsigned *indices = reinterpret_cast<const unsigned *>(cache.data() + sizeof(header) + header.vertexCount * sizeof(MeshVertex));
+		for (unsigned i = 0; valid && i < header.indexCount; i++)
+			valid = indices[i] < header.vertexCount;
+		if (!valid)
+			fprintf(stderr, "%s: index utanför hörnen, cachen läses inte\n", file);
+	}
+	if (!valid)
+	{
+		cache.close();
+		return false;
+	}
+
+	// Hörnen och indexen används direkt ur mappningen, headern är en multipel av 8 byte
+	ownedVertices.clear();
+	ownedIndices.clear();
+	vertexTotal = header.vertexCount;
+	indexTotal = header.indexCount;
+	vertexData = reinterpret_cast<const MeshVertex *>(cache.data() + sizeof(header));
+	indexData = reinterpret_cast<const unsigned *>(cache.data() + sizeof(header) + vertexTotal * sizeof(MeshVertex));
+	center = Vector3f(header.center[0], header.center[1], header.center[2]);
+	radius = header.radius;
+	levelTotal = header.levelCount;
+	memcpy(levels, header.levels, sizeof(levels));
+	return true;
+}
+
+
+
+bool Mesh::writeCache(const char *file) const
+{
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "MSHC", 4);
+	header.version = cacheVersion;
+	if (!sourceStamp(file, header.sourceSize, header.sourceTime))
+		return false;
+	header.vertexCount = vertexTotal;
+	header.indexCount = indexTotal;
+	header.center[0] = center.x();
+	header.center[1] = center.y();
+	header.center[2] = center.z();
+	header.radius = radius;
+	header.levelCount = levelTotal;
+	memcpy(header.levels, levels, sizeof(levels));
+
+	std::string cacheFile = std::string(file) + ".cache";
+	FILE *out = fopen(cacheFile.c_str(), "wb");
+	if (!out)
+	{
+		fprintf(stderr, "Kunde inte skapa %s\n", cacheFile.c_str());
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		&& fwrite(vertexData, sizeof(MeshVertex), vertexTotal, out) == vertexTotal
+		&& fwrite(indexData, sizeof(unsigned), indexTotal, out) == indexTotal;
+	ok = fclose(out) == 0 && ok;
+	if (!ok)
+	{
+		fprintf(stderr, "Kunde inte skriva %s\n", cacheFile.c_str());
+		remove(cacheFile.c_str());
+	}
+	return ok;
+}
+
+
+
+void Mesh::useOwned()
+{
+	vertexData = ownedVertices.data();
+	indexData = ownedIndices.data();
+	vertexTotal = ownedVertices.size();
+	indexTotal = ownedIndices.size();
+}
+
+
+
+// Hashen räknas på hörnets bitar. -0 och +0 görs lika innan, annars är det exakt likhet.
+static unsigned hashVertex(const MeshVertex &vertex)
+{
+	unsigned words[8];
+	memcpy(words, &vertex, sizeof(words));
+	unsigned hash = 2166136261u;
+	for (int i = 0; i < 8; i++)
+	{
+		hash = (hash ^ words[i]) * 16777619u;
+		hash ^= hash >> 15;
+	}
+	return hash;
+}
+
+
+
+// Öppen adressering med linjär sondering i en tabell som är minst dubbelt så stor som antalet hörn
+void Mesh::weld(const std::vector<MeshVertex> &corners, bool hasNormals)
+{
+	PROFILE_SCOPE("Mesh::weld");
+
+	unsigned tableSize = 1;
+	while (tableSize < corners.size() * 2)
+		tableSize *= 2;
+	std::vector<unsigned> table(tableSize, ~0u);
+
+	ownedVertices.clear();
+	ownedVertices.reserve(corners.size() / 2);
+	ownedIndices.resize(corners.size());
+	for (unsigned i = 0; i < corners.size(); i++)
+	{
+		// Via en egen array, position[3] får inte indexeras förbi sina tre element
+		MeshVertex vertex;
+		float values[8];
+		memcpy(values, &corners[i], sizeof(values));
+		for (int j = 0; j < 8; j++)
+			values[j] += 0.0f;
+		memcpy(&vertex, values, sizeof(vertex));
+
+		unsigned slot = hashVertex(vertex) & (tableSize - 1);
+		while (table[slot] != ~0u && memcmp(&ownedVertices[table[slot]], &vertex, sizeof(vertex)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == ~0u)
+		{
+			table[slot] = ownedVertices.size();
+			ownedVertices.push_back(vertex);
+		}
+		ownedIndices[i] = table[slot];
+	}
+
+	if (!hasNormals)
+		computeNormals();
+	useOwned();
+}
+
+
+
+// Kryssprodukten är dubbla triangelarean, så större trianglar väger mer
+void Mesh::computeNormals()
+{
+	std::vector<Vector3f> sums(ownedVertices.size(), Vector3f(0, 0, 0));
+	for (unsigned i = 0; i + 2 < ownedIndices.size(); i += 3)
+	{
+		Vector3f a(ownedVertices[ownedIndices[i]].position);
+		Vector3f b(ownedVertices[ownedIndices[i + 1]].position);
+		Vector3f c(ownedVertices[ownedIndices[i + 2]].position);
+		Vector3f normal = (b - a).crossProduct(c - a);
+		for (int corner = 0; corner < 3; corner++)
+			sums[ownedIndices[i + corner]] += normal;
+	}
+
+	for (unsigned i = 0; i < ownedVertices.size(); i++)
+	{
+		float length = sums[i].length();
+		Vector3f normal = length > 0 ? sums[i] / length : Vector3f(0, 1, 0);
+		ownedVertices[i].normal[0] = normal.x();
+		ownedVertices[i].normal[1] = normal.y();
+		ownedVertices[i].normal[2] = normal.z();
+	}
+}
+
+
+
+void Mesh::computeBounds()
+{
+	if (vertexTotal == 0)
+		return;
+
+	Vector3f low(vertexData[0].position), high(vertexData[0].position);
+	for (unsigned i = 1; i < vertexTotal; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			low[axis] = std::min(low[axis], vertexData[i].position[axis]);
+			high[axis] = std::max(high[axis], vertexData[i].position[axis]);
+		}
+	}
+
+	center = (low + high) * 0.5f;
+	float squared = 0;
+	for (unsigned i = 0; i < vertexTotal; i++)
+	{
+		Vector3f offset = Vector3f(vertexData[i].position) - center;
+		squared = std::max(squared, offset.dotProduct(offset));
+	}
+	radius = sqrt(squared);
+}
+
+
+
+bool Mesh::importObj(const char *file)
+{
+	ObjParser parser;
+	parser.setThreadPool(threadPool);
+	if (!parser.parse(file))
+		return false;
+
+	weld(parser.corners(), parser.hasNormals());
+	return true;
+}
+
+
+
+enum PlyType
+{
+	PlyChar, PlyUchar, PlyShort, PlyUshort, PlyInt, PlyUint, PlyFloat, PlyDouble, PlyUnknown
+};
+
+struct PlyProperty
+{
+	PlyType type;
+	PlyType countType;			// PlyUnknown om egenskapen inte är en lista
+	int target;					// Vilket flyttal i MeshVertex värdet hamnar i, -1 för inget
+	bool indices;				// Listan med hörnindex i en yta
+};
+
+struct PlyElement
+{
+	std::string name;
+	unsigned count;
+	std::vector<PlyProperty> properties;
+};
+
+
+
+static PlyType plyType(const char *name)
+{
+	static const struct
+	{
+		const char *name;
+		PlyType type;
+	} types[] =
+	{
+		{ "char", PlyChar }, { "int8", PlyChar }, { "uchar", PlyUchar }, { "uint8", PlyUchar },
+		{ "short", PlyShort }, { "int16", PlyShort }, { "ushort", PlyUshort }, { "uint16", PlyUshort },
+		{ "int", PlyInt }, { "int32", PlyInt }, { "uint", PlyUint }, { "uint32", PlyUint },
+		{ "float", PlyFloat }, { "float32", PlyFloat }, { "double", PlyDouble }, { "float64", PlyDouble }
+	};
+	for (unsigned i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+	{
+		if (strcmp(name, types[i].name) == 0)
+			return types[i].type;
+	}
+	return PlyUnknown;
+}
+
+
+
+// Namnen på hörnens egenskaper i den ordning de ligger i MeshVertex
+static int plyTarget(const char *name)
+{
+	static const char *const names[][3] =
+	{
+		{ "x", "", "" }, { "y", "", "" }, { "z", "", "" },
+		{ "nx", "", "" }, { "ny", "", "" }, { "nz", "", "" },
+		{ "u", "s", "texture_u" }, { "v", "t", "texture_v" }
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			if (names[i][j][0] && strcmp(name, names[i][j]) == 0)
+				return i;
+		}
+	}
+	return -1;
+}
+
+
+
+// Fältet i hörnet som plyTarget pekar ut
+static float &plyField(MeshVertex &vertex, int target)
+{
+	if (target < 3)
+		return vertex.position[target];
+	if (target < 6)
+		return vertex.normal[target - 3];
+	return vertex.texCoord[target - 6];
+}
+
+
+
+// Läser ett värde ur datadelen, som text eller binärt i någon byteordning
+struct PlyReader
+{
+	const char *cursor, *end;
+	bool ascii, swap;
+
+	bool read(PlyType type, double &value)
+	{
+		if (ascii)
+		{
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n'))
+				cursor++;
+			char token[64];
+			unsigned length = 0;
+			while (cursor < end && length < sizeof(token) - 1 && !(*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n'))
+				token[length++] = *cursor++;
+			token[length] = 0;
+			char *tokenEnd;
+			value = strtod(token, &tokenEnd);
+			return length > 0 && *tokenEnd == 0;
+		}
+
+		static const unsigned sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+		unsigned size = sizes[type];
+		if (unsigned(end - cursor) < size)
+			return false;
+		unsigned char bytes[8];
+		for (unsigned i = 0; i < size; i++)
+			bytes[i] = cursor[swap ? size - 1 - i : i];
+		cursor += size;
+
+		switch (type)
+		{
+		case PlyChar: { signed char v; memcpy(&v, bytes, 1); value = v; break; }
+		case PlyUchar: value = bytes[0]; break;
+		case PlyShort: { short v; memcpy(&v, bytes, 2); value = v; break; }
+		case PlyUshort: { unsigned short v; memcpy(&v, bytes, 2); value = v; break; }
+		case PlyInt: { int v; memcpy(&v, bytes, 4); value = v; break; }
+		case PlyUint: { unsigned v; memcpy(&v, bytes, 4); value = v; break; }
+		case PlyFloat: { float v; memcpy(&v, bytes, 4); value = v; break; }
+		default: { double v; memcpy(&v, bytes, 8); value = v; break; }
+		}
+		return true;
+	}
+};
+
+
+
+bool Mesh::importPly(const char *file)
+{
+	MappedFile source;
+	if (!source.open(file))
+	{
+		fprintf(stderr, "Kunde inte öppna %s\n", file);
+		return false;
+	}
+
+	// Headern är text fram till end_header, oavsett format på datadelen
+	const char *cursor = source.data(), *end = cursor + source.size();
+	std::vector<PlyElement> elements;
+	PlyReader reader = { NULL, end, true, false };
+	bool ok = source.size() >= 3 && memcmp(cursor, "ply", 3) == 0, headerDone = false;
+	std::string line;
+	while (ok && !headerDone && cursor < end)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+		if (!lineEnd)
+			lineEnd = end;
+		line.assign(cursor, lineEnd);
+		cursor = lineEnd + 1;
+
+		char word[32], a[32], b[32], c[32], d[64];
+		int words = sscanf(line.c_str(), "%31s %31s %31s %31s %63s", word, a, b, c, d);
+		if (words < 1 || strcmp(word, "ply") == 0 || strcmp(word, "comment") == 0 || strcmp(word, "obj_info") == 0)
+			continue;
+
+		if (strcmp(word, "format") == 0 && words >= 2)
+		{
+			reader.ascii = strcmp(a, "ascii") == 0;
+			reader.swap = strcmp(a, "binary_big_endian") == 0;
+			ok = reader.ascii || reader.swap || strcmp(a, "binary_little_endian") == 0;
+		}
+		else if (strcmp(word, "element") == 0 && words >= 3)
+		{
+			PlyElement element;
+			element.name = a;
+			element.count = strtoul(b, NULL, 10);
+			elements.push_back(element);
+		}
+		else if (strcmp(word, "property") == 0 && words >= 3 && !elements.empty())
+		{
+			PlyProperty property;
+			property.countType = PlyUnknown;
+			property.indices = false;
+			property.target = -1;
+			if (strcmp(a, "list") == 0 && words >= 5)
+			{
+				property.countType = plyType(b);
+				property.type = plyType(c);
+				property.indices = elements.back().name == "face" && (strcmp(d, "vertex_indices") == 0 || strcmp(d, "vertex_index") == 0);
+				ok = property.countType != PlyUnknown;
+			}
+			else
+			{
+				property.type = plyType(a);
+				if (elements.back().name == "vertex")
+					property.target = plyTarget(b);
+			}
+			ok = ok && property.type != PlyUnknown;
+			elements.back().properties.push_back(property);
+		}
+		else if (strcmp(word, "end_header") == 0)
+			headerDone = true;
+		else
+			ok = false;
+	}
+	if (!ok || !headerDone)
+	{
+		fprintf(stderr, "%s: ingen giltig PLY-header\n", file);
+		return false;
+	}
+
+	reader.cursor = cursor;
+	std::vector<MeshVertex> vertices, corners;
+	std::vector<unsigned> polygon;
+	bool hasNormals = false;
+	for (unsigned e = 0; ok && e < elements.size(); e++)
+	{
+		const PlyElement &element = elements[e];
+		bool isVertex = element.name == "vertex";
+		if (isVertex)
+		{
+			vertices.assign(element.count, MeshVertex());
+			for (unsigned p = 0; p < element.properties.size(); p++)
+				hasNormals = hasNormals || element.properties[p].target == 3;
+		}
+
+		for (unsigned i = 0; ok && i < element.count; i++)
+		{
+			for (unsigned p = 0; ok && p < element.properties.size(); p++)
+			{
+				const PlyProperty &property = element.properties[p];
+				double value;
+				if (property.countType == PlyUnknown)
+				{
+					ok = reader.read(property.type, value);
+					if (ok && isVertex && property.target >= 0)
+						plyField(vertices[i], property.target) = float(value);
+					continue;
+				}
+
+				ok = reader.read(property.countType, value);
+				unsigned count = unsigned(value);
+				polygon.clear();
+				for (unsigned k = 0; ok && k < count; k++)
+				{
+					ok = reader.read(property.type, value);
+					polygon.push_back(unsigned(value));
+				}
+				if (!ok || !property.indices)
+					continue;
+
+				for (unsigned k = 0; ok && k < count; k++)
+					ok = polygon[k] < vertices.size();
+				for (unsigned k = 1; ok && k + 1 < count; k++)
+				{
+					corners.push_back(vertices[polygon[0]]);
+					corners.push_back(vertices[polygon[k]]);
+					corners.push_back(vertices[polygon[k + 1]]);
+				}
+			}
+		}
+	}
+	if (!ok)
+	{
+		fprintf(stderr, "%s: PLY-datan tar slut eller har ogiltiga index\n", file);
+		return false;
+	}
+
+	weld(corners, hasNormals);
+	return true;
+}
+
+
+
+// Modellen har ingen egen textur eller färg, så den lyses upp av ett ljus som följer kameran
+void Mesh::draw(unsigned level) const
+{
+	if (levels[level].indexCount == 0)
+		return;
+
+	enableState(GL_LIGHTING);
+	enableState(GL_LIGHT0);
+	enableState(GL_COLOR_MATERIAL);
+	enableState(GL_NORMALIZE);
+	glColor3f(0.8f, 0.8f, 0.8f);
+
+	enableClientArray(GL_VERTEX_ARRAY);
+	enableClientArray(GL_NORMAL_ARRAY);
+	enableClientArray(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), vertexData->position);
+	glNormalPointer(GL_FLOAT, sizeof(MeshVertex), vertexData->normal);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), vertexData->texCoord);
+	glDrawElements(GL_TRIANGLES, levels[level].indexCount, GL_UNSIGNED_INT, indexData + levels[level].indexOffset);
+	disableClientArray(GL_TEXTURE_COORD_ARRAY);
+	disableClientArray(GL_NORMAL_ARRAY);
+	disableClientArray(GL_VERTEX_ARRAY);
+
+	disableState(GL_NORMALIZE);
+	disableState(GL_COLOR_MATERIAL);
+	disableState(GL_LIGHT0);
+	disableState(GL_LIGHTING);
+
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", levels[level].indexCount);
+}
@@ -0,0 +1,124 @@
+#ifndef MESH_H
+#define MESH_H
+
+
+
+#include "MappedFile.h"
+#include "MathUtils.h"
+#include "ThreadPool.h"
+#include <vector>
+
+
+
+struct MeshVertex
+{
+	float position[3];
+	float normal[3];
+	float texCoord[2];
+};
+
+
+
+// Hur väl en indexlista använder hörncachen. ACMR är transformerade hörn per triangel
+// (0.5 är bästa möjliga för ett stort rutnät, 3 sämsta), ATVR transformerade hörn per
+// unikt hörn (1 är bästa möjliga).
+struct VertexCacheStats
+{
+	float acmr, atvr;
+};
+
+
+
+// Indexerad triangelmodell inläst från OBJ eller PLY.
+//
+// OBJ tolkas av ObjParser, PLY här. Filerna läses hörn för hörn, och hörn med exakt samma
+// position, normal och texturkoordinat slås ihop med en hashtabell, så varje unikt hörn
+// bara finns en gång. Saknar filen normaler räknas de ut efter sammanslagningen, viktade
+// med trianglarnas area.
+//
+// Resultatet skrivs till en binär cache bredvid källfilen (modell.obj.cache). Nästa gång
+// mappas cachen direkt in i minnet, så inget behöver tolkas eller kopieras. Cachen gäller
+// så länge källfilens storlek och ändringstid är desamma som när den skrevs.
+//
+// Vid import sorteras trianglarna för hörncachen och överritning, och hörnen numreras om
+// i den ordning de används (se MeshOptimizer.h). Sedan förenklas modellen i några steg till
+// enklare detaljnivåer (se MeshSimplifier.h). Alla nivåer delar hörnarrayen och ligger efter
+// varandra i indexarrayen, och cachen innehåller dem alla.
+class Mesh
+{
+public:
+	static const unsigned maxLevels = 4;
+
+	Mesh();
+
+	void setThreadPool(ThreadPool *pool);	// OBJ-filer tolkas parallellt, NULL tolkar på den anropande tråden
+
+	bool load(const char *file);		// Från cachen om den är giltig, annars import och ny cache
+	bool import(const char *file);		// Läser alltid källfilen, efter filändelsen .obj eller .ply
+	bool writeCache(const char *file) const;
+	void clear();
+
+	const MeshVertex *vertices() const;
+	unsigned vertexCount() const;
+	const unsigned *indices(unsigned level = 0) const;
+	unsigned indexCount(unsigned level = 0) const;
+	unsigned levelCount() const;
+	float levelError(unsigned level) const;		// Största avståndet från den fulla modellen, i modellens enheter
+	bool fromCache() const;
+	const Vector3f &boundCenter() const;
+	float boundRadius() const;
+	const VertexCacheStats &importedStats() const;	// Före optimeringen, nollor när modellen kommer från cachen
+	const VertexCacheStats &optimizedStats() const;
+
+	// Den enklaste nivån vars fel syns som högst tolerance, när scale räknar om modellens
+	// enheter till bildens (projektionens skala delad med avståndet)
+	unsigned selectLevel(float scale, float tolerance) const;
+
+	void draw(unsigned level = 0) const;
+
+private:
+	struct Level
+	{
+		unsigned indexOffset, indexCount;
+		float error;
+	};
+
+	struct CacheHeader
+	{
+		char magic[4];
+		unsigned version;
+		unsigned long long sourceSize;
+		long long sourceTime;
+		unsigned vertexCount, indexCount;
+		float center[3], radius;
+		unsigned levelCount, padding;
+		Level levels[maxLevels];
+	};
+
+	bool importObj(const char *file);
+	bool importPly(const char *file);
+	bool readCache(const char *file, const CacheHeader &expected);
+	void weld(const std::vector<MeshVertex> &corners, bool hasNormals);
+	void computeNormals();
+	void computeBounds();
+	void optimize();
+	void buildLevels();
+	void useOwned();
+
+	std::vector<MeshVertex> ownedVertices;	// Tomma när modellen kommer från cachen
+	std::vector<unsigned> ownedIndices;
+	MappedFile cache;
+	const MeshVertex *vertexData;
+	const unsigned *indexData;
+	unsigned vertexTotal, indexTotal;		// indexTotal räknar alla nivåer
+	Level levels[maxLevels];
+	unsigned levelTotal;
+	Vector3f center;
+	float radius;
+	VertexCacheStats before, after;
+	ThreadPool *threadPool;
+};
+
+
+
+#endif
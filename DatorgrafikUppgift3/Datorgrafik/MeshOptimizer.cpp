@@ -0,0 +1,319 @@
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+
+
+// En FIFO-cache simuleras med en tidsstämpel per hörn: hörnet finns kvar så länge färre
+// än cacheSize andra hörn har lagts in efter det.
+VertexCacheStats analyzeVertexCache(const unsigned *indices, unsigned indexCount, unsigned vertexCount, unsigned cacheSize)
+{
+	std::vector<unsigned> stamps(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	unsigned misses = 0, unique = 0;
+	for (unsigned i = 0; i < indexCount; i++)
+	{
+		unsigned vertex = indices[i];
+		if (!used[vertex])
+		{
+			used[vertex] = true;
+			unique++;
+		}
+		else if (misses - stamps[vertex] < cacheSize)
+			continue;
+		misses++;
+		stamps[vertex] = misses;
+	}
+
+	VertexCacheStats stats;
+	stats.acmr = indexCount ? misses / float(indexCount / 3) : 0;
+	stats.atvr = unique ? misses / float(unique) : 0;
+	return stats;
+}
+
+
+
+static const unsigned forsythCacheSize = 32;
+
+
+
+// Poängen från Forsyths artikel: de tre senaste hörnen får en fast poäng, sedan faller den
+// med platsen i cachen. Hörn med få trianglar kvar får extra poäng, så att ensamma
+// trianglar tas innan de blir kvar till slutet.
+static float forsythScore(int cachePosition, unsigned liveTriangles)
+{
+	if (liveTriangles == 0)
+		return -1;
+
+	float score = 0;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = powf(1 - (cachePosition - 3) / float(forsythCacheSize - 3), 1.5f);
+	}
+	return score + 2 / sqrtf(float(liveTriangles));
+}
+
+
+
+void optimizeVertexCache(unsigned *indices, unsigned indexCount, unsigned vertexCount)
+{
+	PROFILE_SCOPE("optimizeVertexCache");
+
+	unsigned triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Trianglarna kring varje hörn. De levande ligger först i hörnets del av listan.
+	std::vector<unsigned> offsets(vertexCount + 1, 0), live(vertexCount, 0);
+	for (unsigned i = 0; i < indexCount; i++)
+		live[indices[i]]++;
+	for (unsigned v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<unsigned> adjacency(indexCount), filled(offsets.begin(), offsets.end() - 1);
+	for (unsigned i = 0; i < indexCount; i++)
+		adjacency[filled[indices[i]]++] = i / 3;
+
+	std::vector<float> vertexScores(vertexCount), triangleScores(triangleCount, 0);
+	for (unsigned v = 0; v < vertexCount; v++)
+		vertexScores[v] = forsythScore(-1, live[v]);
+	for (unsigned i = 0; i < indexCount; i++)
+		triangleScores[i / 3] += vertexScores[indices[i]];
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned> output(indexCount);
+	unsigned cache[forsythCacheSize + 3], cacheCount = 0;
+	unsigned best = unsigned(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+	unsigned cursor = 0;
+
+	for (unsigned written = 0; written < triangleCount; written++)
+	{
+		const unsigned *corners = indices + best * 3;
+		output[written * 3] = corners[0];
+		output[written * 3 + 1] = corners[1];
+		output[written * 3 + 2] = corners[2];
+		emitted[best] = true;
+
+		// Triangeln tas bort ur sina hörns levande listor
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned vertex = corners[c];
+			unsigned *list = &adjacency[offsets[vertex]];
+			for (unsigned k = 0; k < live[vertex]; k++)
+			{
+				if (list[k] == best)
+				{
+					std::swap(list[k], list[live[vertex] - 1]);
+					live[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// Triangelns hörn först i cachen, sedan de gamla hörnen i sin ordning
+		unsigned next[forsythCacheSize + 3], nextCount = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			if (std::find(next, next + nextCount, corners[c]) == next + nextCount)
+				next[nextCount++] = corners[c];
+		}
+		for (unsigned k = 0; k < cacheCount; k++)
+		{
+			if (std::find(next, next + nextCount, cache[k]) == next + nextCount)
+				next[nextCount++] = cache[k];
+		}
+
+		// Hörnen som flyttats eller fallit ur cachen får ny poäng, och deras trianglar ändras lika mycket
+		best = ~0u;
+		float bestScore = -1e30f;
+		for (unsigned k = 0; k < nextCount; k++)
+		{
+			unsigned vertex = next[k];
+			int position = k < forsythCacheSize ? int(k) : -1;
+			float score = forsythScore(position, live[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const unsigned *list = &adjacency[offsets[vertex]];
+			for (unsigned t = 0; t < live[vertex]; t++)
+				triangleScores[list[t]] += delta;
+		}
+		for (unsigned k = 0; k < nextCount && k < forsythCacheSize; k++)
+		{
+			const unsigned *list = &adjacency[offsets[next[k]]];
+			for (unsigned t = 0; t < live[next[k]]; t++)
+			{
+				if (triangleScores[list[t]] > bestScore)
+				{
+					bestScore = triangleScores[list[t]];
+					best = list[t];
+				}
+			}
+		}
+
+		cacheCount = std::min(nextCount, forsythCacheSize);
+		std::copy(next, next + cacheCount, cache);
+
+		// Inga trianglar kvar kring cachen, ta nästa oanvända i ursprunglig ordning
+		if (best == ~0u)
+		{
+			while (cursor < triangleCount && emitted[cursor])
+				cursor++;
+			best = cursor;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+
+
+struct OverdrawCluster
+{
+	unsigned begin, end;			// Trianglar
+	float sortKey;
+};
+
+
+
+void optimizeOverdraw(unsigned *indices, unsigned indexCount, const MeshVertex *vertices, unsigned vertexCount, float threshold)
+{
+	PROFILE_SCOPE("optimizeOverdraw");
+
+	unsigned triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Hårda gränser där alla tre hörnen missar i cachen. Där börjar cachen ändå om,
+	// så ett kluster som börjar där kostar lika mycket var det än hamnar i ordningen.
+	const unsigned cacheSize = 16;
+	std::vector<unsigned> stamps(vertexCount, 0);
+	std::vector<bool> seen(vertexCount, false);
+	std::vector<bool> hardBoundary(triangleCount, false);
+	unsigned misses = 0;
+	for (unsigned t = 0; t < triangleCount; t++)
+	{
+		unsigned triangleMisses = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned vertex = indices[t * 3 + c];
+			if (seen[vertex] && misses - stamps[vertex] < cacheSize)
+				continue;
+			seen[vertex] = true;
+			stamps[vertex] = ++misses;
+			triangleMisses++;
+		}
+		hardBoundary[t] = t == 0 || triangleMisses == 3;
+	}
+	float limit = misses / float(triangleCount) * threshold;
+
+	// Mjuka gränser inom de hårda: klustret avslutas när dess egen ACMR, räknad med en tom
+	// cache från klustrets början, har kommit ned under gränsen
+	std::vector<OverdrawCluster> clusters;
+	unsigned clusterStart = 0, clusterMisses = 0;
+	std::vector<unsigned> clusterStamps(vertexCount, 0);
+	unsigned generation = 0;
+	std::vector<unsigned> generations(vertexCount, ~0u);
+	for (unsigned t = 0; t < triangleCount; t++)
+	{
+		if (t > clusterStart && hardBoundary[t])
+		{
+			OverdrawCluster cluster = { clusterStart, t, 0 };
+			clusters.push_back(cluster);
+			clusterStart = t;
+			clusterMisses = 0;
+			generation++;
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned vertex = indices[t * 3 + c];
+			if (generations[vertex] == generation && clusterMisses - clusterStamps[vertex] < cacheSize)
+				continue;
+			generations[vertex] = generation;
+			clusterStamps[vertex] = ++clusterMisses;
+		}
+
+		bool nextIsHard = t + 1 == triangleCount || hardBoundary[t + 1];
+		if (!nextIsHard && clusterMisses <= limit * (t + 1 - clusterStart))
+		{
+			OverdrawCluster cluster = { clusterStart, t + 1, 0 };
+			clusters.push_back(cluster);
+			clusterStart = t + 1;
+			clusterMisses = 0;
+			generation++;
+		}
+	}
+	OverdrawCluster last = { clusterStart, triangleCount, 0 };
+	clusters.push_back(last);
+
+	// Areaviktad mitt och normal för varje kluster och för hela modellen
+	std::vector<Vector3f> centroids(clusters.size()), normals(clusters.size());
+	Vector3f meshCentroid(0, 0, 0);
+	float meshArea = 0;
+	for (unsigned k = 0; k < clusters.size(); k++)
+	{
+		Vector3f centroid(0, 0, 0), normal(0, 0, 0);
+		float area = 0;
+		for (unsigned t = clusters[k].begin; t < clusters[k].end; t++)
+		{
+			Vector3f a(vertices[indices[t * 3]].position);
+			Vector3f b(vertices[indices[t * 3 + 1]].position);
+			Vector3f c(vertices[indices[t * 3 + 2]].position);
+			Vector3f cross = (b - a).crossProduct(c - a);
+			float triangleArea = cross.length();
+			centroid += (a + b + c) * (triangleArea / 3);
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids[k] = area > 0 ? centroid / area : centroid;
+		normals[k] = normal;
+	}
+	if (meshArea > 0)
+		meshCentroid = meshCentroid / meshArea;
+
+	for (unsigned k = 0; k < clusters.size(); k++)
+	{
+		float length = normals[k].length();
+		clusters[k].sortKey = length > 0 ? (centroids[k] - meshCentroid).dotProduct(normals[k]) / length : 0;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const OverdrawCluster &a, const OverdrawCluster &b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<unsigned> output;
+	output.reserve(indexCount);
+	for (unsigned k = 0; k < clusters.size(); k++)
+		output.insert(output.end(), indices + clusters[k].begin * 3, indices + clusters[k].end * 3);
+	std::copy(output.begin(), output.end(), indices);
+}
+
+
+
+unsigned optimizeVertexFetch(MeshVertex *vertices, unsigned *indices, unsigned indexCount, unsigned vertexCount)
+{
+	PROFILE_SCOPE("optimizeVertexFetch");
+
+	std::vector<unsigned> remap(vertexCount, ~0u);
+	std::vector<MeshVertex> reordered;
+	reordered.reserve(vertexCount);
+	for (unsigned i = 0; i < indexCount; i++)
+	{
+		unsigned &target = remap[indices[i]];
+		if (target == ~0u)
+		{
+			target = reordered.size();
+			reordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = target;
+	}
+
+	std::copy(reordered.begin(), reordered.end(), vertices);
+	return reordered.size();
+}
@@ -0,0 +1,35 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+
+
+#include "Mesh.h"
+
+
+
+// Mäter indexlistan mot en FIFO-cache av given storlek, som i de flesta grafikkort.
+VertexCacheStats analyzeVertexCache(const unsigned *indices, unsigned indexCount, unsigned vertexCount, unsigned cacheSize = 16);
+
+
+
+// Optimeringarna körs i den här ordningen när en modell importeras, och resultatet sparas i cachen.
+
+// Tom Forsyths linjära algoritm: varje hörn får poäng efter sin plats i en simulerad
+// LRU-cache och efter hur många trianglar det har kvar, och triangeln med högst summa
+// tas härnäst. Bara trianglar kring hörnen i cachen behöver räknas om efter varje steg.
+void optimizeVertexCache(unsigned *indices, unsigned indexCount, unsigned vertexCount);
+
+// Delar den cacheoptimerade listan i kluster där cachen ändå börjar om, och där ACMR
+// hittills i klustret inte är mer än threshold gånger hela listans. Klustren sorteras
+// sedan så att de som vetter utåt från modellens mitt ritas först; de skymmer ofta
+// resten, så färre pixlar ritas över. Trianglarna inom ett kluster behåller sin ordning.
+void optimizeOverdraw(unsigned *indices, unsigned indexCount, const MeshVertex *vertices, unsigned vertexCount, float threshold = 1.05f);
+
+// Numrerar om hörnen i den ordning indexlistan använder dem första gången, så att hörnen
+// läses i stort sett i följd. Hörn som ingen triangel använder tas bort. Returnerar det
+// nya antalet hörn.
+unsigned optimizeVertexFetch(MeshVertex *vertices, unsigned *indices, unsigned indexCount, unsigned vertexCount);
+
+
+
+#endif
@@ -0,0 +1,277 @@
+#include "MeshSimplifier.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+
+
+// Symmetrisk 4x4-matris som summa av plan, räknad i double eftersom termerna tar ut varandra
+struct Quadric
+{
+	double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+	double weight;
+};
+
+
+
+static void addPlane(Quadric &q, const Vector3f &normal, float distance, float weight)
+{
+	double x = normal.x(), y = normal.y(), z = normal.z(), d = distance;
+	q.a00 += weight * x * x;
+	q.a01 += weight * x * y;
+	q.a02 += weight * x * z;
+	q.a03 += weight * x * d;
+	q.a11 += weight * y * y;
+	q.a12 += weight * y * z;
+	q.a13 += weight * y * d;
+	q.a22 += weight * z * z;
+	q.a23 += weight * z * d;
+	q.a33 += weight * d * d;
+	q.weight += weight;
+}
+
+
+
+static void addQuadric(Quadric &q, const Quadric &other)
+{
+	q.a00 += other.a00;
+	q.a01 += other.a01;
+	q.a02 += other.a02;
+	q.a03 += other.a03;
+	q.a11 += other.a11;
+	q.a12 += other.a12;
+	q.a13 += other.a13;
+	q.a22 += other.a22;
+	q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+
+
+// Summan av två hörns felmått i punkten, delad med vikten så att den blir ett medelavstånd i kvadrat
+static float collapseCost(const Quadric &a, const Quadric &b, const float *position)
+{
+	Quadric q = a;
+	addQuadric(q, b);
+	double x = position[0], y = position[1], z = position[2];
+	double cost = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+		+ 2 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+		+ 2 * (q.a03 * x + q.a13 * y + q.a23 * z) + q.a33;
+	return q.weight > 0 ? float(std::max(cost, 0.0) / q.weight) : 0;
+}
+
+
+
+static Vector3f triangleNormal(const float *a, const float *b, const float *c)
+{
+	Vector3f p0(a), p1(b), p2(c);
+	return (p1 - p0).crossProduct(p2 - p0);
+}
+
+
+
+// Hörn med samma position får samma representant. Hörn i en söm, och hörn på en kant
+// som bara en triangel använder, låses.
+static void findLockedVertices(const unsigned *indices, unsigned indexCount, const MeshVertex *vertices, unsigned vertexCount,
+	std::vector<unsigned> &positionGroup, std::vector<bool> &locked)
+{
+	std::vector<unsigned> order(vertexCount);
+	for (unsigned v = 0; v < vertexCount; v++)
+		order[v] = v;
+	std::sort(order.begin(), order.end(), [vertices](unsigned a, unsigned b)
+	{
+		return memcmp(vertices[a].position, vertices[b].position, sizeof(vertices[a].position)) < 0;
+	});
+
+	positionGroup.resize(vertexCount);
+	locked.assign(vertexCount, false);
+	for (unsigned i = 0; i < vertexCount; )
+	{
+		unsigned end = i + 1;
+		while (end < vertexCount && memcmp(vertices[order[i]].position, vertices[order[end]].position, sizeof(vertices[0].position)) == 0)
+			end++;
+		for (unsigned k = i; k < end; k++)
+		{
+			positionGroup[order[k]] = order[i];
+			locked[order[k]] = end - i > 1;
+		}
+		i = end;
+	}
+
+	// Kanterna räknas mellan positioner, så att en söm inte ser ut som två hål. En kant utan
+	// motsatt kant ligger på ett hål, och en kant som finns två gånger åt samma håll är inte
+	// mångfaldig.
+	std::vector<unsigned long long> edges(indexCount);
+	for (unsigned i = 0; i < indexCount; i++)
+	{
+		unsigned from = positionGroup[indices[i]];
+		unsigned to = positionGroup[indices[i - i % 3 + (i % 3 + 1) % 3]];
+		edges[i] = (unsigned long long)from << 32 | to;
+	}
+	std::sort(edges.begin(), edges.end());
+	for (unsigned i = 0; i < indexCount; i++)
+	{
+		unsigned from = unsigned(edges[i] >> 32), to = unsigned(edges[i]);
+		bool repeated = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < indexCount && edges[i + 1] == edges[i]);
+		bool opposite = std::binary_search(edges.begin(), edges.end(), (unsigned long long)to << 32 | from);
+		if (repeated || !opposite)
+			locked[from] = locked[to] = true;
+	}
+	for (unsigned v = 0; v < vertexCount; v++)
+	{
+		if (locked[positionGroup[v]])
+			locked[v] = true;
+	}
+}
+
+
+
+struct Collapse
+{
+	unsigned from, to;
+	float cost;
+};
+
+
+
+unsigned simplifyMesh(unsigned *destination, const unsigned *indices, unsigned indexCount, const MeshVertex *vertices, unsigned vertexCount,
+	unsigned targetIndexCount, float &error)
+{
+	PROFILE_SCOPE("simplifyMesh");
+
+	std::vector<unsigned> positionGroup;
+	std::vector<bool> locked;
+	findLockedVertices(indices, indexCount, vertices, vertexCount, positionGroup, locked);
+
+	Quadric zero;
+	memset(&zero, 0, sizeof(zero));
+	std::vector<Quadric> quadrics(vertexCount, zero);
+	for (unsigned i = 0; i < indexCount; i += 3)
+	{
+		const float *p0 = vertices[indices[i]].position;
+		Vector3f normal = triangleNormal(p0, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+		float length = normal.length();
+		if (length == 0)
+			continue;
+		normal /= length;
+		float distance = -normal.dotProduct(Vector3f(p0));
+		for (int c = 0; c < 3; c++)
+			addPlane(quadrics[indices[i + c]], normal, distance, length / 2);
+	}
+
+	std::vector<unsigned> current(indices, indices + indexCount);
+	std::vector<unsigned> remap(vertexCount), offsets(vertexCount + 1), adjacency, filled;
+	std::vector<unsigned> touched(vertexCount, 0);
+	std::vector<Collapse> collapses;
+	float maxCost = 0;
+
+	for (unsigned pass = 1; current.size() > targetIndexCount; pass++)
+	{
+		// Trianglarna kring varje hörn
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (unsigned i = 0; i < current.size(); i++)
+			offsets[current[i] + 1]++;
+		for (unsigned v = 0; v < vertexCount; v++)
+			offsets[v + 1] += offsets[v];
+		adjacency.resize(current.size());
+		filled.assign(offsets.begin(), offsets.end() - 1);
+		for (unsigned i = 0; i < current.size(); i++)
+			adjacency[filled[current[i]]++] = i / 3;
+
+		// Varje inre kant en gång, åt det håll som är billigast av dem som är tillåtna
+		collapses.clear();
+		for (unsigned i = 0; i < current.size(); i++)
+		{
+			unsigned a = current[i], b = current[i - i % 3 + (i % 3 + 1) % 3];
+			if (a > b || (locked[a] && locked[b]))
+				continue;
+			Collapse collapse = { a, b, collapseCost(quadrics[a], quadrics[b], vertices[b].position) };
+			float reverse = collapseCost(quadrics[a], quadrics[b], vertices[a].position);
+			if (locked[a] || (!locked[b] && reverse < collapse.cost))
+			{
+				std::swap(collapse.from, collapse.to);
+				collapse.cost = reverse;
+			}
+			collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b)
+		{
+			return a.cost < b.cost;
+		});
+
+		for (unsigned v = 0; v < vertexCount; v++)
+			remap[v] = v;
+		unsigned triangles = current.size() / 3, targetTriangles = targetIndexCount / 3;
+		unsigned performed = 0;
+		for (unsigned c = 0; c < collapses.size() && triangles > targetTriangles; c++)
+		{
+			const Collapse &collapse = collapses[c];
+			if (touched[collapse.from] == pass || touched[collapse.to] == pass)
+				continue;
+
+			// Trianglarna kring hörnet som tas bort får inte vända sig eller få två hörn
+			// på samma position, och de som har båda hörnen försvinner
+			const float *to = vertices[collapse.to].position;
+			unsigned removed = 0;
+			bool allowed = true;
+			for (unsigned k = offsets[collapse.from]; k < offsets[collapse.from + 1] && allowed; k++)
+			{
+				const unsigned *triangle = &current[adjacency[k] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					removed++;
+					continue;
+				}
+
+				const float *before[3], *after[3];
+				for (int j = 0; j < 3; j++)
+				{
+					if (triangle[j] != collapse.from && positionGroup[triangle[j]] == positionGroup[collapse.to])
+						allowed = false;
+					before[j] = vertices[triangle[j]].position;
+					after[j] = triangle[j] == collapse.from ? to : before[j];
+				}
+				Vector3f normalBefore = triangleNormal(before[0], before[1], before[2]);
+				Vector3f normalAfter = triangleNormal(after[0], after[1], after[2]);
+				if (normalBefore.dotProduct(normalAfter) <= 0)
+					allowed = false;
+			}
+			if (!allowed)
+				continue;
+
+			// Hela grannskapet låses för resten av omgången, annars kan vändtestet bli inaktuellt
+			for (unsigned k = offsets[collapse.from]; k < offsets[collapse.from + 1]; k++)
+			{
+				const unsigned *triangle = &current[adjacency[k] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = pass;
+			}
+			touched[collapse.to] = pass;
+
+			remap[collapse.from] = collapse.to;
+			addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			maxCost = std::max(maxCost, collapse.cost);
+			triangles -= std::min(removed, triangles);
+			performed++;
+		}
+		if (performed == 0)
+			break;
+
+		unsigned written = 0;
+		for (unsigned i = 0; i < current.size(); i += 3)
+		{
+			unsigned a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			current[written++] = a;
+			current[written++] = b;
+			current[written++] = c;
+		}
+		current.resize(written);
+	}
+
+	std::copy(current.begin(), current.end(), destination);
+	error = sqrtf(maxCost);
+	return current.size();
+}
@@ -0,0 +1,29 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+
+
+#include "Mesh.h"
+
+
+
+// Förenklar en indexlista med kantkollaps efter Garland och Heckberts kvadratiska felmått.
+//
+// Varje hörn får summan av planen för sina trianglar, viktade med area, och en kant kostar
+// avståndet i kvadrat från planen om ena änden flyttas till den andra. Kanterna kollapsas
+// billigast först i omgångar där inget hörn berörs två gånger, tills indexlistan är nere i
+// targetIndexCount eller inget mer går att ta bort. Hörnen flyttas aldrig, en kant kollapsar
+// alltid till ett befintligt hörn, så alla nivåer kan dela samma hörnarray.
+//
+// Hörn på kanten av ett hål och hörn i sömmar, där flera hörn har samma position men olika
+// normal eller texturkoordinat, tas aldrig bort. Kollapser som skulle vända en triangel
+// hoppas över.
+//
+// Resultatet skrivs till destination, som måste rymma indexCount index. error blir det
+// största felet hittills som ett avstånd i modellens enheter. Returnerar antalet index.
+unsigned simplifyMesh(unsigned *destination, const unsigned *indices, unsigned indexCount, const MeshVertex *vertices, unsigned vertexCount,
+	unsigned targetIndexCount, float &error);
+
+
+
+#endif
@@ -0,0 +1,419 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+
+
+
+static const int noIndex = INT_MIN;
+static const size_t minimumChunkSize = 1 << 20;
+
+
+
+ObjParser::ObjParser()
+{
+	threadPool = NULL;
+	normalsComplete = false;
+}
+
+
+
+void ObjParser::setThreadPool(ThreadPool *pool)
+{
+	threadPool = pool;
+}
+
+
+
+const std::vector<MeshVertex> &ObjParser::corners() const
+{
+	return output;
+}
+
+
+
+bool ObjParser::hasNormals() const
+{
+	return normalsComplete;
+}
+
+
+
+unsigned ObjParser::positionCount() const
+{
+	return positions.size() / 3;
+}
+
+
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+
+static const char *skipSpaces(const char *p, const char *end)
+{
+	while (p < end && isSpace(*p))
+		p++;
+	return p;
+}
+
+
+
+// Decimaltal med valfritt tecken, decimaler och exponent. Upp till 19 siffror samlas i ett
+// 64-bitars heltal som sedan skalas med en tiopotens i double. Under 10^22 är tiopotensen
+// exakt, så för vanliga OBJ-tal blir resultatet korrekt avrundat till float.
+// Returnerar NULL om det inte står något tal vid p.
+static const char *parseFloat(const char *p, const char *end, float &value)
+{
+	static const double powers[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	unsigned long long mantissa = 0;
+	int digits = 0, exponent = 0;
+	const char *start = p;
+	for (; p < end && unsigned(*p - '0') < 10; p++)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;			// Inledande nollor räknas inte
+		}
+		else
+			exponent++;
+	}
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && unsigned(*p - '0') < 10; p++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if (p == start || (p == start + 1 && *start == '.'))
+		return NULL;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char *q = p + 1;
+		bool negativeExponent = false;
+		if (q < end && (*q == '-' || *q == '+'))
+			negativeExponent = *q++ == '-';
+		if (q < end && unsigned(*q - '0') < 10)
+		{
+			int e = 0;
+			for (; q < end && unsigned(*q - '0') < 10; q++)
+				e = e < 10000 ? e * 10 + (*q - '0') : e;
+			exponent += negativeExponent ? -e : e;
+			p = q;
+		}
+	}
+
+	double result = double(mantissa);
+	while (exponent > 22)
+	{
+		result *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22)
+	{
+		result /= 1e22;
+		exponent += 22;
+	}
+	result = exponent >= 0 ? result * powers[exponent] : result / powers[-exponent];
+
+	value = float(negative ? -result : result);
+	return p;
+}
+
+
+
+static const char *parseInt(const char *p, const char *end, int &value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	const char *start = p;
+	long long result = 0;
+	for (; p < end && unsigned(*p - '0') < 10; p++)
+		result = result < INT_MAX ? result * 10 + (*p - '0') : result;
+	if (p == start || result > INT_MAX)
+		return NULL;
+
+	value = int(negative ? -result : result);
+	return p;
+}
+
+
+
+// Läser count tal efter nyckelordet. Ett extra tal, som w i v x y z w, hoppas över.
+static bool parseFloats(const char *p, const char *end, std::vector<float> &values, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		p = skipSpaces(p, end);
+		float value;
+		p = parseFloat(p, end, value);
+		if (!p)
+			return false;
+		values.push_back(value);
+	}
+	return true;
+}
+
+
+
+// Positiva index börjar på 1 och gäller hela filen. Negativa räknas bakåt från antalet
+// hittills i biten och märks så att bitens startposition läggs till vid sammanslagningen.
+static bool resolveIndex(int value, unsigned localCount, int &index, bool &relative)
+{
+	if (value == 0)
+		return false;
+	relative = value < 0;
+	index = relative ? int(localCount) + value : value - 1;
+	return true;
+}
+
+
+
+void ObjParser::parseChunk(Chunk &chunk)
+{
+	const char *p = chunk.begin, *end = chunk.end;
+	std::vector<int> polygon;
+	std::vector<unsigned char> polygonRelative;
+
+	while (p < end && !chunk.errorLine)
+	{
+		const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+		if (!lineEnd)
+			lineEnd = end;
+		chunk.lines++;
+
+		p = skipSpaces(p, lineEnd);
+		bool ok = true;
+		if (lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1]))
+			ok = parseFloats(p + 2, lineEnd, chunk.positions, 3);
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+			ok = parseFloats(p + 3, lineEnd, chunk.texCoords, 2);
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+			ok = parseFloats(p + 3, lineEnd, chunk.normals, 3);
+		else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1]))
+		{
+			// v, v/vt, v//vn eller v/vt/vn per hörn
+			polygon.clear();
+			polygonRelative.clear();
+			const char *q = skipSpaces(p + 2, lineEnd);
+			unsigned counts[3] = { unsigned(chunk.positions.size() / 3), unsigned(chunk.texCoords.size() / 2), unsigned(chunk.normals.size() / 3) };
+			while (ok && q < lineEnd)
+			{
+				int references[3] = { noIndex, noIndex, noIndex };
+				unsigned char relativeBits = 0;
+				for (int k = 0; ok && k < 3; k++)
+				{
+					if (k > 0)
+					{
+						if (q >= lineEnd || *q != '/')
+							break;
+						q++;
+						if (k == 1 && q < lineEnd && *q == '/')
+							continue;					// v//vn
+					}
+					int value;
+					bool relative;
+					q = parseInt(q, lineEnd, value);
+					ok = q && resolveIndex(value, counts[k], references[k], relative);
+					relativeBits |= ok && relative ? 1 << k : 0;
+				}
+				if (!ok)
+					break;
+				if (references[2] == noIndex)
+					chunk.missingNormals = true;
+				polygon.insert(polygon.end(), references, references + 3);
+				polygonRelative.push_back(relativeBits);
+				q = skipSpaces(q, lineEnd);
+			}
+
+			unsigned cornerCount = polygonRelative.size();
+			ok = ok && cornerCount >= 3;
+			for (unsigned i = 1; ok && i + 1 < cornerCount; i++)
+			{
+				const unsigned fan[3] = { 0, i, i + 1 };
+				for (int c = 0; c < 3; c++)
+				{
+					chunk.references.insert(chunk.references.end(), &polygon[fan[c] * 3], &polygon[fan[c] * 3] + 3);
+					chunk.relative.push_back(polygonRelative[fan[c]]);
+				}
+			}
+		}
+		// Kommentarer, grupper, material och allt annat påverkar inte geometrin
+
+		if (!ok)
+			chunk.errorLine = chunk.lines;
+		p = lineEnd + 1;
+	}
+}
+
+
+
+// Bitens v, vt och vn kopieras till sin plats i de sammanslagna arrayerna
+void ObjParser::mergeChunk(Chunk &chunk)
+{
+	memcpy(&positions[0] + chunk.positionStart * 3, chunk.positions.data(), chunk.positions.size() * sizeof(float));
+	memcpy(&texCoords[0] + chunk.texCoordStart * 2, chunk.texCoords.data(), chunk.texCoords.size() * sizeof(float));
+	memcpy(&normals[0] + chunk.normalStart * 3, chunk.normals.data(), chunk.normals.size() * sizeof(float));
+}
+
+
+
+// Bitens hörn hämtar sina värden ur de sammanslagna arrayerna. Index utanför ger nollor
+// och markerar biten, så att parse kan rapportera felet efteråt.
+void ObjParser::resolveChunk(Chunk &chunk)
+{
+	const std::vector<float> *arrays[3] = { &positions, &texCoords, &normals };
+	const unsigned sizes[3] = { 3, 2, 3 };
+	const unsigned starts[3] = { chunk.positionStart, chunk.texCoordStart, chunk.normalStart };
+	long long totals[3];
+	for (int k = 0; k < 3; k++)
+		totals[k] = arrays[k]->size() / sizes[k];
+
+	for (unsigned i = 0; i < chunk.relative.size(); i++)
+	{
+		MeshVertex &vertex = output[chunk.cornerStart + i];
+		float *targets[3] = { vertex.position, vertex.texCoord, vertex.normal };
+		for (int k = 0; k < 3; k++)
+		{
+			int index = chunk.references[i * 3 + k];
+			long long absolute = (long long)index + (chunk.relative[i] & (1 << k) ? starts[k] : 0);
+			if (index == noIndex || absolute < 0 || absolute >= totals[k])
+			{
+				chunk.invalidReference = chunk.invalidReference || index != noIndex;
+				memset(targets[k], 0, sizes[k] * sizeof(float));
+			}
+			else
+				memcpy(targets[k], arrays[k]->data() + absolute * sizes[k], sizes[k] * sizeof(float));
+		}
+	}
+}
+
+
+
+void ObjParser::forEachChunk(void (ObjParser::*function)(Chunk &))
+{
+	if (threadPool)
+		threadPool->parallelFor(chunks.size(), [&](unsigned i) { (this->*function)(chunks[i]); });
+	else
+	{
+		for (unsigned i = 0; i < chunks.size(); i++)
+			(this->*function)(chunks[i]);
+	}
+}
+
+
+
+bool ObjParser::parse(const char *file)
+{
+	MappedFile source;
+	if (!source.open(file))
+	{
+		fprintf(stderr, "Kunde inte öppna %s\n", file);
+		return false;
+	}
+	return parse(source.data(), source.size(), file);
+}
+
+
+
+bool ObjParser::parse(const char *text, size_t size, const char *name)
+{
+	PROFILE_SCOPE("ObjParser::parse");
+
+	// Bitarna slutar alltid efter ett radslut, så ingen rad delas
+	unsigned threads = threadPool ? threadPool->size() : 1;
+	size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads * 4, size / minimumChunkSize));
+	chunks.assign(chunkCount, Chunk());
+	const char *begin = text, *end = text + size;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		// Produkten räknas i 64 bitar, size_t är bara 32 bitar i Win32-bygget
+		const char *chunkEnd = i + 1 == chunkCount ? end : text + size_t((unsigned long long)size * (i + 1) / chunkCount);
+		if (chunkEnd < begin)
+			chunkEnd = begin;
+		const char *newline = chunkEnd < end ? static_cast<const char *>(memchr(chunkEnd, '\n', end - chunkEnd)) : NULL;
+		chunkEnd = newline ? newline + 1 : end;
+
+		Chunk &chunk = chunks[i];
+		chunk.begin = begin;
+		chunk.end = chunkEnd;
+		chunk.lines = 0;
+		chunk.errorLine = 0;
+		chunk.missingNormals = false;
+		chunk.invalidReference = false;
+		begin = chunkEnd;
+	}
+
+	forEachChunk(&ObjParser::parseChunk);
+
+	unsigned lines = 0, positionTotal = 0, texCoordTotal = 0, normalTotal = 0, cornerTotal = 0;
+	normalsComplete = true;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		Chunk &chunk = chunks[i];
+		if (chunk.errorLine)
+		{
+			fprintf(stderr, "%s rad %u: kan inte tolka raden\n", name, lines + chunk.errorLine);
+			chunks.clear();
+			return false;
+		}
+		lines += chunk.lines;
+		chunk.positionStart = positionTotal;
+		chunk.texCoordStart = texCoordTotal;
+		chunk.normalStart = normalTotal;
+		chunk.cornerStart = cornerTotal;
+		positionTotal += chunk.positions.size() / 3;
+		texCoordTotal += chunk.texCoords.size() / 2;
+		normalTotal += chunk.normals.size() / 3;
+		cornerTotal += chunk.relative.size();
+		normalsComplete = normalsComplete && !chunk.missingNormals;
+	}
+
+	positions.resize(positionTotal * 3 + 3);		// Ett extra element, så att &positions[0] går även när filen saknar v
+	texCoords.resize(texCoordTotal * 2 + 2);
+	normals.resize(normalTotal * 3 + 3);
+	forEachChunk(&ObjParser::mergeChunk);
+	positions.resize(positionTotal * 3);
+	texCoords.resize(texCoordTotal * 2);
+	normals.resize(normalTotal * 3);
+
+	// Hörnen kan slås upp först när alla bitar har kopierat sina arrayer
+	output.resize(cornerTotal);
+	forEachChunk(&ObjParser::resolveChunk);
+
+	bool valid = true;
+	for (size_t i = 0; i < chunkCount; i++)
+		valid = valid && !chunks[i].invalidReference;
+	chunks.clear();
+	if (!valid)
+	{
+		fprintf(stderr, "%s: en yta pekar på ett hörn som inte finns\n", name);
+		output.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+#include <vector>
+
+
+
+// Snabb tolkning av Wavefront OBJ-text.
+//
+// Filen mappas in och delas i bitar vid radslut, en bit per uppgift i trådpoolen. Varje
+// bit tolkar sina rader för sig med egna flyttals- och heltalsparsers (strtod och
+// iostreams är både långsamma och beroende av locale) och samlar sina v, vt, vn och
+// trianglar i egna arrayer. Sedan räknas varje bits plats i de sammanslagna arrayerna
+// ut, och bitarna kopierar dit och slår upp sina hörn parallellt. Negativa index, som
+// räknas bakåt från den rad där de står, flyttas med bitens startposition.
+//
+// Resultatet är ett hörn per triangelhörn, i filens ordning, redo för Mesh att slå ihop.
+class ObjParser
+{
+public:
+	ObjParser();
+
+	void setThreadPool(ThreadPool *pool);	// NULL tolkar allt på den anropande tråden
+
+	bool parse(const char *file);
+	bool parse(const char *text, size_t size, const char *name);	// name används bara i felmeddelanden
+
+	const std::vector<MeshVertex> &corners() const;
+	bool hasNormals() const;				// Alla hörn hade en normal i filen
+	unsigned positionCount() const;
+
+private:
+	struct Chunk
+	{
+		const char *begin, *end;
+		std::vector<float> positions, texCoords, normals;
+		std::vector<int> references;		// v, vt och vn per hörn, noIndex om det saknas
+		std::vector<unsigned char> relative;	// En bit per index som ska flyttas med bitens start
+		unsigned lines;
+		int errorLine;						// Rad i biten som inte gick att tolka, 0 om allt gick bra
+		bool missingNormals;
+		bool invalidReference;				// Något index pekade utanför filens arrayer
+		unsigned positionStart, texCoordStart, normalStart, cornerStart;
+	};
+
+	void parseChunk(Chunk &chunk);
+	void mergeChunk(Chunk &chunk);
+	void resolveChunk(Chunk &chunk);
+	void forEachChunk(void (ObjParser::*function)(Chunk &));
+
+	ThreadPool *threadPool;
+	std::vector<Chunk> chunks;
+	std::vector<float> positions, texCoords, normals;
+	std::vector<MeshVertex> output;
+	bool normalsComplete;
+};
+
+
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+
+// Lättviktig instrumentering av var bildrutetiden tar vägen. PROFILE_SCOPE mäter
+// tiden fram till slutet av det omgivande blocket. Varje tråd skriver sina mätningar
+// till en egen ringbuffert utan lås, och profilerEndFrame() samlar ihop dem en gång
+// per bildruta. Definiera DISABLE_PROFILER för att kompilera bort alla mätpunkter.
+
+
+
+struct ProfileSample
+{
+	const char *name;
+	double start, end;		// Mikrosekunder sedan programstart
+	unsigned short thread;
+	unsigned short depth;	// Nästlingsdjup inom tråden
+};
+
+
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char *name);
+	~ProfileScope();
+
+private:
+	const char *name;
+	double start;
+};
+
+
+
+void profilerStart(const char *outputFile);	// Aktiverar mätningen. Filen (.json eller .csv) skrivs av profilerFinish, NULL ger bara utskrift.
+bool profilerStartTrace(const char *traceFile);	// Strömmar alla zoner till en Chrome trace-fil (chrome://tracing, Perfetto).
+bool profilerEnabled();
+bool profilerReporting();			// profilerStart har anropats, så profilerFinish skriver en rapport
+void profilerSetLabel(const char *text);	// Skrivs först i rapporten, t.ex. namn och version på en benchmark
+double profilerNow();
+
+void profilerCount(const char *name, double value);	// Räknare per bildruta, t.ex. ritanrop och hörn
+void profilerEndFrame();		// Anropas efter glutSwapBuffers
+void profilerGpuBegin();		// GPU-tid via timer queries, om drivrutinen stöder det
+void profilerGpuEnd();
+
+void profilerFinish();			// Skriver ut p50/p95/p99 per zon och sparar till filen. Passar att ge till atexit.
+
+
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(name, value) profilerCount(name, value)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, value)
+#endif
+
+
+
+#endif
@@ -104,6 +104,33 @@ public:
     *@return The quaternion as a 4x4 matrix.
   */ 
   Matrix4x4<T> matrix4x4() const;
+
+  /**
+	*@brief The rotate member function rotates a vector by the quaternion without building a matrix.
+	*It uses v + w*t + img x t with t = 2*(img x v)/norm, which is 15 multiplications and one division.
+	*The quaternion does not have to be normalized.
+    *@param vector = The vector to rotate.
+    *@return The rotated vector, the same as matrix()*vector.
+    */
+  Vector3<T> rotate(const Vector3<T>& vector) const;
+
+  /**
+	*@brief The rotateUnit member function is the same as rotate but assumes that the quaternion is
+	*normalized, which saves the division. A quaternion that is not normalized will also scale the vector.
+    *@param vector = The vector to rotate.
+    *@return The rotated vector.
+    */
+  Vector3<T> rotateUnit(const Vector3<T>& vector) const;
+
+  /**
+	*@brief This version of rotate rotates many vectors by the same quaternion. For more than a few
+	*vectors it is cheaper to build the rotation matrix once (9 multiplications per vector) than to use
+	*the 15 multiplication formula for each vector, so that is done from four vectors and up.
+    *@param vectors = The vectors to rotate.
+    *@param result = Receives the rotated vectors. It may be the same array as vectors.
+    *@param count = The number of vectors.
+    */
+  void rotate(const Vector3<T>* vectors, Vector3<T>* result, unsigned count) const;
   
     /**
 	*@brief The assingIdentity will convert the quaternion to an identity quaternion(0-vector, 1)
@@ -184,6 +211,165 @@ Quaternion<T> operator-(const Quaternion<T>& left, const Quaternion<T>& right)
   return Quaternion<T>(left.img()-right.img(), left.real()-right.real());
 }
 
+/**
+   *@brief The dotProduct function computes the four dimensional dot product of two quaternions.
+   *@param left = The left hand side operand.
+   *@param right = The right hand side operand.
+   *@return The dot product. For unit quaternions it is the cosine of half the angle between the rotations.
+  */
+template<typename T>
+T dotProduct(const Quaternion<T>& left, const Quaternion<T>& right)
+{
+  return left.img().dotProduct(right.img()) + left.real()*right.real();
+}
+
+/**
+   *@brief The slerp function performs spherical linear interpolation between two unit quaternions
+   *along the shortest arc.
+   *@param start = The start rotation.
+   *@param finish = The end rotation.
+   *@param t = A interpolation value (0 = start, 1 = end).
+   *@param shortestPath = If true the finish quaternion is negated when needed so that the shortest arc is used.
+   *@return The intermediate rotation.
+  */
+template<typename T>
+Quaternion<T> slerp(const Quaternion<T>& start, const Quaternion<T>& finish, T t, bool shortestPath = true)
+{
+  T cosAngle = dotProduct(start, finish);
+  T sign = 1;
+  if(shortestPath && cosAngle < 0)
+  {
+    cosAngle = -cosAngle;
+    sign = -1;
+  }
+
+  // Nearly parallel rotations: sin(angle) goes to zero, so fall back to a normalized lerp
+  if(cosAngle > T(0.9995))
+  {
+    Quaternion<T> result = start*(1-t) + finish*(sign*t);
+    return result.normalize();
+  }
+
+  T angle = T(acos(cosAngle));
+  T invSin = T(1/sin(angle));
+  return start*(T(sin((1-t)*angle))*invSin) + finish*(sign*T(sin(t*angle))*invSin);
+}
+
+/**
+   *@brief The nlerp function performs normalized linear interpolation between two unit quaternions.
+   *It follows the same path as slerp but not at constant angular speed, and costs no trigonometry.
+   *@param start = The start rotation.
+   *@param finish = The end rotation.
+   *@param t = A interpolation value (0 = start, 1 = end).
+   *@return The intermediate rotation.
+  */
+template<typename T>
+Quaternion<T> nlerp(const Quaternion<T>& start, const Quaternion<T>& finish, T t)
+{
+  T sign = dotProduct(start, finish) < 0 ? T(-1) : T(1);
+  Quaternion<T> result = start*(1-t) + finish*(sign*t);
+  return result.normalize();
+}
+
+/**
+   *@brief The fastSlerpFactor function corrects an interpolation value so that nlerp with the
+   *corrected value follows slerp. The correction is a polynomial fit in t and in the cosine of the
+   *angle between the rotations, so no acos or sin is needed. The largest angular error against slerp
+   *is about 0.001 radians, for rotations that are 180 degrees apart.
+   *@param cosAngle = The absolute value of the dot product of the two unit quaternions.
+   *@param t = A interpolation value (0 = start, 1 = end).
+   *@return The corrected interpolation value.
+  */
+template<typename T>
+T fastSlerpFactor(T cosAngle, T t)
+{
+  T a = T(1.0904) + cosAngle*(T(-3.2452) + cosAngle*(T(3.55645) - cosAngle*T(1.43519)));
+  T b = T(0.848013) + cosAngle*(T(-1.06021) + cosAngle*T(0.215638));
+  T k = a*(t - T(0.5))*(t - T(0.5)) + b;
+  return t + t*(t - T(0.5))*(t - 1)*k;
+}
+
+/**
+   *@brief The fastSlerp function approximates slerp along the shortest arc with nlerp and a corrected
+   *interpolation value, see fastSlerpFactor.
+   *@param start = The start rotation.
+   *@param finish = The end rotation.
+   *@param t = A interpolation value (0 = start, 1 = end).
+   *@return The intermediate rotation.
+  */
+template<typename T>
+Quaternion<T> fastSlerp(const Quaternion<T>& start, const Quaternion<T>& finish, T t)
+{
+  T cosAngle = dotProduct(start, finish);
+  T sign = cosAngle < 0 ? T(-1) : T(1);
+  T u = fastSlerpFactor(cosAngle*sign, t);
+  Quaternion<T> result = start*(1-u) + finish*(sign*u);
+  return result.normalize();
+}
+
+/**
+   *@brief The quaternionLog function computes the logarithm of a unit quaternion.
+   *@param quat = The unit quaternion.
+   *@return A pure quaternion (real part 0) whose imaginary part is the rotation axis times half the angle.
+  */
+template<typename T>
+Quaternion<T> quaternionLog(const Quaternion<T>& quat)
+{
+  T sinHalf = quat.img().length();
+  if(sinHalf < T(0.00001))
+    return Quaternion<T>(quat.img(), 0);
+
+  T halfAngle = T(atan2(sinHalf, quat.real()));
+  return Quaternion<T>(quat.img()*(halfAngle/sinHalf), 0);
+}
+
+/**
+   *@brief The quaternionExp function computes the exponential of a pure quaternion. It is the inverse of quaternionLog.
+   *@param quat = The pure quaternion.
+   *@return The unit quaternion.
+  */
+template<typename T>
+Quaternion<T> quaternionExp(const Quaternion<T>& quat)
+{
+  T halfAngle = quat.img().length();
+  if(halfAngle < T(0.00001))
+    return Quaternion<T>(quat.img(), T(cos(halfAngle)));
+
+  return Quaternion<T>(quat.img()*(T(sin(halfAngle))/halfAngle), T(cos(halfAngle)));
+}
+
+/**
+   *@brief The squadControlPoint function computes the inner control point used by squad for a key.
+   *@param previous = The key before the current key.
+   *@param current = The current key.
+   *@param next = The key after the current key.
+   *@return The control point. Neighbouring keys should be in the same hemisphere (positive dot product).
+  */
+template<typename T>
+Quaternion<T> squadControlPoint(const Quaternion<T>& previous, const Quaternion<T>& current, const Quaternion<T>& next)
+{
+  Quaternion<T> inverse = current.conjugate();
+  Quaternion<T> sum = quaternionLog(inverse*next) + quaternionLog(inverse*previous);
+  return current*quaternionExp(sum*T(-0.25));
+}
+
+/**
+   *@brief The squad function performs spherical quadrangle interpolation, which gives a smooth
+   *rotation through a sequence of keys.
+   *@param start = The key at the start of the segment.
+   *@param finish = The key at the end of the segment.
+   *@param startControl = The control point of the start key, see squadControlPoint.
+   *@param finishControl = The control point of the end key, see squadControlPoint.
+   *@param t = A interpolation value (0 = start, 1 = end).
+   *@return The intermediate rotation.
+  */
+template<typename T>
+Quaternion<T> squad(const Quaternion<T>& start, const Quaternion<T>& finish,
+		    const Quaternion<T>& startControl, const Quaternion<T>& finishControl, T t)
+{
+  return slerp(slerp(start, finish, t, false), slerp(startControl, finishControl, t, false), 2*t*(1-t), false);
+}
+
 template<typename T>
 Quaternion<T>::Quaternion()
 {
@@ -365,6 +551,39 @@ Matrix4x4<T> Quaternion<T>::matrix4x4() const
   return Matrix4x4<T>(matrix);
 }
 
+template<typename T>
+inline Vector3<T> Quaternion<T>::rotateUnit(const Vector3<T>& vector) const
+{
+  Vector3<T> t = m_img.crossProduct(vector)*T(2);
+  return vector + t*m_real + m_img.crossProduct(t);
+}
+
+template<typename T>
+inline Vector3<T> Quaternion<T>::rotate(const Vector3<T>& vector) const
+{
+  Vector3<T> t = m_img.crossProduct(vector)*(2/norm());
+  return vector + t*m_real + m_img.crossProduct(t);
+}
+
+template<typename T>
+void Quaternion<T>::rotate(const Vector3<T>* vectors, Vector3<T>* result, unsigned count) const
+{
+  if(count >= 4)
+  {
+    Matrix3x3<T> rotation = matrix();
+    for(unsigned i = 0; i < count; i++)
+      result[i] = Vector3<T>(rotation[0]*vectors[i].x()+rotation[3]*vectors[i].y()+rotation[6]*vectors[i].z(),
+			     rotation[1]*vectors[i].x()+rotation[4]*vectors[i].y()+rotation[7]*vectors[i].z(),
+			     rotation[2]*vectors[i].x()+rotation[5]*vectors[i].y()+rotation[8]*vectors[i].z());
+    return;
+  }
+
+  Quaternion<T> unit = *this;
+  unit.normalize();
+  for(unsigned i = 0; i < count; i++)
+    result[i] = unit.rotateUnit(vectors[i]);
+}
+
 template<typename T>
 Vector3<T> Quaternion<T>::axis() const
 {
@@ -0,0 +1,105 @@
+#ifndef INCLUDED_QUATERNIONBATCH
+#define INCLUDED_QUATERNIONBATCH
+
+#include "Quaternion.h"
+#include <math.h>
+
+/**
+ *@brief The QuaternionSoA struct points to quaternions stored as a structure of arrays, one array per
+ *component. The batch functions below loop over the arrays without branches in the loop body, so the
+ *compiler can vectorize them. The result may be the same arrays as one of the inputs.
+ */
+template<typename T>
+struct QuaternionSoA
+{
+  T* x;
+  T* y;
+  T* z;
+  T* w;
+};
+
+/**
+   *@brief The nlerpBatch function performs nlerp on count pairs of unit quaternions.
+   *@param start = The start rotations.
+   *@param finish = The end rotations.
+   *@param t = The interpolation value for each pair.
+   *@param result = Receives the intermediate rotations.
+   *@param count = The number of quaternions in each array.
+  */
+template<typename T>
+void nlerpBatch(const QuaternionSoA<T>& start, const QuaternionSoA<T>& finish, const T* t, const QuaternionSoA<T>& result, unsigned count)
+{
+  for(unsigned i = 0; i < count; i++)
+  {
+    T dot = start.x[i]*finish.x[i] + start.y[i]*finish.y[i] + start.z[i]*finish.z[i] + start.w[i]*finish.w[i];
+    T a = 1 - t[i];
+    T b = dot < 0 ? -t[i] : t[i];
+
+    T x = start.x[i]*a + finish.x[i]*b;
+    T y = start.y[i]*a + finish.y[i]*b;
+    T z = start.z[i]*a + finish.z[i]*b;
+    T w = start.w[i]*a + finish.w[i]*b;
+    T invLength = 1/sqrt(x*x + y*y + z*z + w*w);
+
+    result.x[i] = x*invLength;
+    result.y[i] = y*invLength;
+    result.z[i] = z*invLength;
+    result.w[i] = w*invLength;
+  }
+}
+
+/**
+   *@brief The fastSlerpBatch function performs fastSlerp on count pairs of unit quaternions.
+   *@param start = The start rotations.
+   *@param finish = The end rotations.
+   *@param t = The interpolation value for each pair.
+   *@param result = Receives the intermediate rotations.
+   *@param count = The number of quaternions in each array.
+  */
+template<typename T>
+void fastSlerpBatch(const QuaternionSoA<T>& start, const QuaternionSoA<T>& finish, const T* t, const QuaternionSoA<T>& result, unsigned count)
+{
+  for(unsigned i = 0; i < count; i++)
+  {
+    T dot = start.x[i]*finish.x[i] + start.y[i]*finish.y[i] + start.z[i]*finish.z[i] + start.w[i]*finish.w[i];
+    T u = fastSlerpFactor(fabs(dot), t[i]);
+    T a = 1 - u;
+    T b = dot < 0 ? -u : u;
+
+    T x = start.x[i]*a + finish.x[i]*b;
+    T y = start.y[i]*a + finish.y[i]*b;
+    T z = start.z[i]*a + finish.z[i]*b;
+    T w = start.w[i]*a + finish.w[i]*b;
+    T invLength = 1/sqrt(x*x + y*y + z*z + w*w);
+
+    result.x[i] = x*invLength;
+    result.y[i] = y*invLength;
+    result.z[i] = z*invLength;
+    result.w[i] = w*invLength;
+  }
+}
+
+/**
+   *@brief The slerpBatch function performs exact slerp along the shortest arc on count pairs of unit
+   *quaternions. It calls acos and sin for every pair; prefer fastSlerpBatch when 0.001 radians of error is acceptable.
+   *@param start = The start rotations.
+   *@param finish = The end rotations.
+   *@param t = The interpolation value for each pair.
+   *@param result = Receives the intermediate rotations.
+   *@param count = The number of quaternions in each array.
+  */
+template<typename T>
+void slerpBatch(const QuaternionSoA<T>& start, const QuaternionSoA<T>& finish, const T* t, const QuaternionSoA<T>& result, unsigned count)
+{
+  for(unsigned i = 0; i < count; i++)
+  {
+    Quaternion<T> q = slerp(Quaternion<T>(start.x[i], start.y[i], start.z[i], start.w[i]),
+			    Quaternion<T>(finish.x[i], finish.y[i], finish.z[i], finish.w[i]), t[i]);
+    result.x[i] = q.img().x();
+    result.y[i] = q.img().y();
+    result.z[i] = q.img().z();
+    result.w[i] = q.real();
+  }
+}
+
+#endif
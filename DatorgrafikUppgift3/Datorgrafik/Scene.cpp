@@ -0,0 +1,340 @@
+#include "Scene.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+
+
+// Största fel en detaljnivå får ha i bild, i normaliserade koordinater där bildens
+// halva höjd är 1. Det motsvarar ungefär en pixel i ett fönster som är 600 pixlar högt.
+static const float levelTolerance = 0.0035f;
+
+
+
+unsigned Scene::add(const SceneObject &object)
+{
+	objects.push_back(object);
+	objects.back().revision = 0;
+	return objects.size() - 1;
+}
+
+
+
+SceneObject &Scene::object(unsigned index)
+{
+	return objects[index];
+}
+
+
+
+const SceneObject &Scene::object(unsigned index) const
+{
+	return objects[index];
+}
+
+
+
+unsigned Scene::size() const
+{
+	return objects.size();
+}
+
+
+
+void Scene::setModel(unsigned index, const Matrix4x4f &model)
+{
+	SceneObject &object = objects[index];
+	if (memcmp(object.model.data(), model.data(), sizeof(float) * 16) != 0)
+	{
+		object.model = model;
+		object.revision++;
+
+		if (hierarchyValid())
+		{
+			Vector3f center;
+			float radius;
+			worldSphere(object, center, radius);
+			hierarchy.update(index, sphereBounds(center, radius));
+		}
+	}
+}
+
+
+
+// Objekt som lagts till efter bygget saknas i hierarkin
+bool Scene::hierarchyValid() const
+{
+	return hierarchy.size() == objects.size();
+}
+
+
+
+void Scene::buildHierarchy()
+{
+	if (hierarchyValid())
+		return;
+
+	std::vector<BoundingBox> boxes(objects.size());
+	for (unsigned i = 0; i < objects.size(); i++)
+	{
+		Vector3f center;
+		float radius;
+		worldSphere(objects[i], center, radius);
+		boxes[i] = sphereBounds(center, radius);
+	}
+	hierarchy.build(boxes.data(), boxes.size());
+}
+
+
+
+// Flytta sfären till världsrummet. Radien skalas med den största axelskalningen.
+void Scene::worldSphere(const SceneObject &object, Vector3f &center, float &radius) const
+{
+	const Matrix4x4f &m = object.model;
+	Vector4f world = m * Vector4f(object.boundCenter, 1.0f);
+	float scale = 0;
+	for (int column = 0; column < 3; column++)
+	{
+		float length = m[column * 4] * m[column * 4] + m[column * 4 + 1] * m[column * 4 + 1] + m[column * 4 + 2] * m[column * 4 + 2];
+		scale = std::max(scale, length);
+	}
+
+	center = Vector3f(world.x(), world.y(), world.z());
+	radius = object.boundRadius * sqrt(scale);
+}
+
+
+
+// Hierarkin ger de objekt vars lådor skär stympen, sfärtestet sorterar bort hörnen.
+// Utan hierarki testas alla objekt.
+void Scene::cull(const SceneView &view, bool dynamic, std::vector<unsigned> &visible) const
+{
+	std::vector<unsigned> candidates;
+	if (hierarchyValid())
+	{
+		hierarchy.queryFrustum(view.frustum, candidates);
+		std::sort(candidates.begin(), candidates.end());
+	}
+	else
+	{
+		candidates.resize(objects.size());
+		for (unsigned i = 0; i < objects.size(); i++)
+			candidates[i] = i;
+	}
+
+	visible.clear();
+	for (unsigned c = 0; c < candidates.size(); c++)
+	{
+		unsigned i = candidates[c];
+		const SceneObject &object = objects[i];
+		if (object.dynamic != dynamic || !(object.viewMask & (1u << view.index)))
+			continue;
+
+		Vector3f center;
+		float radius;
+		worldSphere(object, center, radius);
+		if (sphereInFrustum(view.frustum, center, radius))
+			visible.push_back(i);
+	}
+}
+
+
+
+// Möller–Trumbore: avståndet till träffen med triangeln, eller -1. Båda sidorna träffas.
+static float rayTriangle(const Vector3f &origin, const Vector3f &direction, const Vector3f &a, const Vector3f &b, const Vector3f &c)
+{
+	Vector3f edge1 = b - a, edge2 = c - a;
+	Vector3f p = direction.crossProduct(edge2);
+	float determinant = edge1.dotProduct(p);
+	if (fabs(determinant) < 1e-12f)
+		return -1;
+
+	float inverse = 1 / determinant;
+	Vector3f s = origin - a;
+	float u = s.dotProduct(p) * inverse;
+	if (u < 0 || u > 1)
+		return -1;
+
+	Vector3f q = s.crossProduct(edge1);
+	float v = direction.dotProduct(q) * inverse;
+	if (v < 0 || u + v > 1)
+		return -1;
+
+	return edge2.dotProduct(q) * inverse;
+}
+
+
+
+// Närmaste skärningen med sfären framför strålens start, eller -1. Startar strålen inne i sfären räknas utgången.
+static float raySphere(const Vector3f &origin, const Vector3f &direction, const Vector3f &center, float radius)
+{
+	Vector3f offset = origin - center;
+	float a = direction.dotProduct(direction);
+	float b = offset.dotProduct(direction);
+	float c = offset.dotProduct(offset) - radius * radius;
+	float discriminant = b * b - a * c;
+	if (discriminant < 0)
+		return -1;
+
+	float root = sqrt(discriminant);
+	float t = (-b - root) / a;
+	if (t < 0)
+		t = (-b + root) / a;
+	return t;
+}
+
+
+
+unsigned Scene::pick(const Vector3f &origin, const Vector3f &direction, unsigned viewIndex, float &distance) const
+{
+	PROFILE_SCOPE("Scene::pick");
+
+	if (!hierarchyValid())
+		return Bvh::noHit;
+
+	return hierarchy.raycast(origin, direction, distance, [&](unsigned index, float maxDistance) -> float
+	{
+		const SceneObject &object = objects[index];
+		if (!(object.viewMask & (1u << viewIndex)))
+			return -1;
+
+		if (!object.triangles)
+		{
+			Vector3f center;
+			float radius;
+			worldSphere(object, center, radius);
+			return raySphere(origin, direction, center, radius);
+		}
+
+		// Strålen flyttas in i objektets rum. Riktningen normaliseras inte, så avståndet
+		// längs strålen blir detsamma där som i världen.
+		Matrix4x4f inverse = object.model.inverse();
+		Vector4f localOrigin = inverse * Vector4f(origin, 1.0f);
+		Vector4f localDirection = inverse * Vector4f(direction, 0.0f);
+		Vector3f o(localOrigin.x(), localOrigin.y(), localOrigin.z());
+		Vector3f d(localDirection.x(), localDirection.y(), localDirection.z());
+
+		const TriangleMesh &mesh = *object.triangles;
+		float closest = -1;
+		for (unsigned i = 0; i < mesh.triangles; i++)
+		{
+			const GLubyte *corner = mesh.indices + i * 3;
+			float t = rayTriangle(o, d,
+				Vector3f(mesh.vertices + corner[0] * 3), Vector3f(mesh.vertices + corner[1] * 3), Vector3f(mesh.vertices + corner[2] * 3));
+			if (t >= 0 && t <= maxDistance && (closest < 0 || t < closest))
+				closest = t;
+		}
+		return closest;
+	});
+}
+
+
+
+void Scene::buildVisibleSet(SceneView &view) const
+{
+	PROFILE_SCOPE("Scene::buildVisibleSet");
+
+	if (!view.cached)
+	{
+		view.frustum = extractFrustum(view.projection * view.view);
+		cull(view, false, view.staticVisible);
+		view.cached = view.fixed;
+	}
+	cull(view, true, view.dynamicVisible);
+
+	// Båda listorna är sorterade, så en sammanslagning ger scenordningen tillbaka
+	view.visible.resize(view.staticVisible.size() + view.dynamicVisible.size());
+	std::merge(view.staticVisible.begin(), view.staticVisible.end(),
+		view.dynamicVisible.begin(), view.dynamicVisible.end(), view.visible.begin());
+}
+
+
+
+void Scene::record(CommandBuffer &buffer, const SceneView &view) const
+{
+	PROFILE_SCOPE("Scene::record");
+
+	buffer.depthMask(GL_TRUE);
+	buffer.disable(GL_BLEND);
+	buffer.polygonMode(GL_FRONT, GL_FILL);
+	buffer.polygonMode(GL_BACK, GL_FILL);
+
+	// Tillståndet spelas in för varje objekt, tillståndscachen filtrerar bort upprepningarna
+	for (unsigned i = 0; i < view.visible.size(); i++)
+	{
+		const SceneObject &object = objects[view.visible[i]];
+
+		if (object.cullFace)
+			buffer.enable(GL_CULL_FACE);
+		else
+			buffer.disable(GL_CULL_FACE);
+
+		if (object.depthTest)
+			buffer.enable(GL_DEPTH_TEST);
+		else
+			buffer.disable(GL_DEPTH_TEST);
+
+		if (object.texture)
+		{
+			buffer.enable(GL_TEXTURE_2D);
+			buffer.bindTexture(object.texture);
+		}
+		else
+			buffer.disable(GL_TEXTURE_2D);
+
+		if (object.colored)
+			buffer.color(object.color[0], object.color[1], object.color[2]);
+
+		buffer.loadMatrix(view.view * object.model);
+		if (object.levels)
+			buffer.drawMesh(object.levels, selectLevel(object, view));
+		else
+			buffer.draw(object.mesh);
+	}
+}
+
+
+
+// Projektionens skala i y delad med avståndet räknar om världsenheter till bildens, och
+// objektets skala räknar om modellens enheter till världens. Står kameran inuti sfären
+// ritas den fulla modellen.
+unsigned Scene::selectLevel(const SceneObject &object, const SceneView &view) const
+{
+	Vector3f center;
+	float radius;
+	worldSphere(object, center, radius);
+	Vector4f eye = view.view * Vector4f(center, 1.0f);
+	float distance = -eye.z();
+	if (distance <= radius || object.boundRadius <= 0)
+		return 0;
+
+	float scale = radius / object.boundRadius * view.projection[5] / distance;
+	return object.levels->selectLevel(scale, levelTolerance);
+}
+
+
+
+bool Scene::changedSince(const SceneView &view) const
+{
+	if (view.visible != view.drawn)
+		return true;
+
+	for (unsigned i = 0; i < view.drawn.size(); i++)
+	{
+		if (objects[view.drawn[i]].revision != view.drawnRevisions[i])
+			return true;
+	}
+	return false;
+}
+
+
+
+void Scene::markDrawn(SceneView &view) const
+{
+	view.drawn = view.visible;
+	view.drawnRevisions.resize(view.drawn.size());
+	for (unsigned i = 0; i < view.drawn.size(); i++)
+		view.drawnRevisions[i] = objects[view.drawn[i]].revision;
+}
@@ -0,0 +1,93 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+
+
+#include "Bvh.h"
+#include "CommandBuffer.h"
+#include <vector>
+
+
+
+// Ett objekt i scenen med allt som behövs för att gallra och spela in det.
+// Transformen är vyoberoende och sätts en gång per bildruta, sedan delas den
+// av alla vyer som ritar objektet.
+struct SceneObject
+{
+	Matrix4x4f model;
+	Vector3f boundCenter;		// Omslutande sfär i objektets eget rum
+	float boundRadius;
+	MeshFunction mesh;
+	const Mesh *levels;			// Om satt ritas den detaljnivå av modellen som passar storleken i bild, i stället för mesh
+	const TriangleMesh *triangles;	// För strålträffar. NULL träffar den omslutande sfären.
+	GLuint texture;				// 0 betyder otexturerad
+	bool depthTest, cullFace;
+	bool colored;				// Sätt color innan objektet ritas
+	float color[3];
+	bool dynamic;				// Rör sig, och gallras därför om varje bildruta
+	unsigned viewMask;			// En bit per vy som objektet syns i
+	unsigned revision;			// Räknas upp av Scene::setModel när transformen ändras
+};
+
+
+
+// En vy av scenen. Fasta vyer sparar sin gallring av de statiska objekten och
+// testar bara om de dynamiska varje bildruta.
+struct SceneView
+{
+	Matrix4x4f view;
+	Matrix4x4f projection;
+	unsigned index;				// Vilken bit i viewMask som gäller för vyn
+	bool fixed;					// Vymatrisen ändras aldrig
+	bool cached;				// staticVisible och frustum är giltiga
+	Frustum frustum;
+	std::vector<unsigned> staticVisible;
+	std::vector<unsigned> dynamicVisible;
+	std::vector<unsigned> visible;	// Synliga objekt i scenordning
+	std::vector<unsigned> drawn;	// visible och revisionerna när vyn senast ritades
+	std::vector<unsigned> drawnRevisions;
+};
+
+
+
+class Scene
+{
+public:
+	unsigned add(const SceneObject &object);
+	SceneObject &object(unsigned index);
+	const SceneObject &object(unsigned index) const;
+	unsigned size() const;
+	void setModel(unsigned index, const Matrix4x4f &model);
+
+	// Bygger om hierarkin över objektens omslutande sfärer om objekt lagts till sedan
+	// förra gången. Flyttade objekt justeras redan i setModel. Anropas innan vyerna gallras.
+	void buildHierarchy();
+
+	// Närmaste objekt som syns i vyn längs strålen, eller Bvh::noHit. Hierarkin sorterar
+	// fram kandidaterna och varje kandidat testas exakt mot sina trianglar eller sin sfär.
+	// distance är strålens längd in och avståndet till träffen ut.
+	unsigned pick(const Vector3f &origin, const Vector3f &direction, unsigned viewIndex, float &distance) const;
+
+	// Bygger view.visible. Anropas parallellt för olika vyer, scenen läses bara.
+	void buildVisibleSet(SceneView &view) const;
+	void record(CommandBuffer &buffer, const SceneView &view) const;
+
+	// Smutsmarkering för vyer som sparar sin bild: en vy behöver bara ritas om
+	// när något objekt den ser har flyttats, eller när ett objekt kommit in eller
+	// försvunnit ur bilden.
+	bool changedSince(const SceneView &view) const;
+	void markDrawn(SceneView &view) const;
+
+private:
+	void cull(const SceneView &view, bool dynamic, std::vector<unsigned> &visible) const;
+	void worldSphere(const SceneObject &object, Vector3f &center, float &radius) const;
+	unsigned selectLevel(const SceneObject &object, const SceneView &view) const;
+	bool hierarchyValid() const;
+
+	std::vector<SceneObject> objects;
+	Bvh hierarchy;				// Ett löv per objekt, med samma index som i objects
+};
+
+
+
+#endif
@@ -1,4 +1,6 @@
 #include "Support.h"
+#include "Profiler.h"
+#include "RenderState.h"
 #include <stdlib.h>
 #include <iostream>
 #ifdef __APPLE__
@@ -12,6 +14,8 @@
 #ifdef __APPLE__
 void loadTexture(const char *file, GLuint *image)
 {
+	PROFILE_SCOPE("loadTexture");
+
 	glGenTextures(1, image);
 
 	CFBundleRef mainBundle = CFBundleGetMainBundle();
@@ -48,6 +52,8 @@ void loadTexture(const char *file, GLuint *image)
 #else
 void loadTexture(const char *file, GLuint *image)
 {
+	PROFILE_SCOPE("loadTexture");
+
 	ilInit();
 
 	ILuint ilImage;
@@ -81,14 +87,37 @@ void loadTexture(const char *file, GLuint *image)
 
 
 
-void drawFloor(GLuint texture)
+// Golvet och pelarna ritas direkt med glBegin, de hr arrayerna anvnds bara fr strltrffar
+static const GLfloat floorVertices[] =
+{
+	25, -10, 25,
+	25, -10, -25,
+	-25, -10, -25,
+	-25, -10, 25
+};
+static const GLubyte floorIndices[] =
+{
+	0, 1, 2,  0, 2, 3
+};
+const TriangleMesh floorMesh = { floorVertices, floorIndices, 2 };
+
+// Pelaren r en utstrckt kub, hrnen ligger i samma ordning som i boxVertices
+static const GLfloat pillarVertices[] =
+{
+	1, -10, 1,
+	1, 6, 1,
+	1, 6, -1,
+	1, -10, -1,
+	-1, -10, -1,
+	-1, 6, -1,
+	-1, 6, 1,
+	-1, -10, 1,
+};
+
+
+
+void drawFloor()
 {	
-	glPolygonMode(GL_FRONT, GL_FILL);
-	glPolygonMode(GL_BACK, GL_FILL);
-	
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture); 
-	
 	glColor3f(1, 1, 1);
 	
 	glBegin(GL_QUADS);
@@ -104,21 +133,14 @@ void drawFloor(GLuint texture)
 	glTexCoord2f(0.0, 8);
 	glVertex3f(-25,-10,25);
 	glEnd();
-	
-	glDisable(GL_TEXTURE_2D);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 4);
 }
 
 
 
-void drawPillar(GLuint texture)
+void drawPillar()
 {
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
-	glPolygonMode(GL_FRONT, GL_FILL);
-	
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	
 	glColor3f(1, 1, 1);
 	
 	glBegin(GL_QUADS);
@@ -202,39 +224,14 @@ void drawPillar(GLuint texture)
 	glTexCoord2f(0.0, 1.0);
 	glVertex3f(1,6,-1);
 	glEnd();
-	
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 24);
 }
 
 
 
-void drawPillars(GLuint texture)
-{
-	glPushMatrix();
-	glTranslatef(-7, 0, -7);
-	drawPillar(texture);
-	glPopMatrix();
-	
-	glPushMatrix();
-	glTranslatef(7, 0, 7);
-	drawPillar(texture);
-	glPopMatrix();
-	
-	glPushMatrix();
-	glTranslatef(-7, 0, 7);
-	drawPillar(texture);
-	glPopMatrix();
-	
-	glPushMatrix();
-	glTranslatef(7, 0, -7);
-	drawPillar(texture);
-	glPopMatrix();
-}
-
 // Arrayer som jag anvnder till diamantobjektet
-GLfloat diamondVertices[] =
+static const GLfloat diamondVertices[] =
 {
 	0, -1, 0,
 	1, 0, 0,
@@ -243,12 +240,12 @@ GLfloat diamondVertices[] =
 	0, 0, -1,
 	0, 1, 0,
 };
-GLubyte diamondIndices[] =
+static const GLubyte diamondIndices[] =
 {
 	0, 1, 4,  0, 4, 2,  0, 2, 3,  0, 3, 1,
 	5, 4, 1,  5, 2, 4,  5, 3, 2,  5, 1, 3
 };
-GLfloat diamondColors[] =
+static const GLfloat diamondColors[] =
 {
 	0, 0, 0,
 	1, 0, 0,
@@ -258,21 +255,25 @@ GLfloat diamondColors[] =
 	0, 0, 0
 };
 
+const TriangleMesh diamondMesh = { diamondVertices, diamondIndices, 8 };
+
 void drawDiamond()
 {
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	enableClientArray(GL_VERTEX_ARRAY);
+	enableClientArray(GL_COLOR_ARRAY);
 	glColorPointer(3, GL_FLOAT, 0, diamondColors);
 	glVertexPointer(3, GL_FLOAT, 0, diamondVertices);
 
 	glDrawElements(GL_TRIANGLES, 24, GL_UNSIGNED_BYTE, diamondIndices);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 24);
 
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
+	disableClientArray(GL_VERTEX_ARRAY);
+	disableClientArray(GL_COLOR_ARRAY);
 }
 
 // Arrayer som jag anvnder till kubobjektet
-GLfloat boxVertices[] =
+static const GLfloat boxVertices[] =
 {
 	1, -1, 1,
 	1, 1, 1,
@@ -283,7 +284,7 @@ GLfloat boxVertices[] =
 	-1, 1, 1,
 	-1, -1, 1,
 };
-GLubyte boxIndices[] =
+static const GLubyte boxIndices[] =
 {
 	2, 0, 1, 3, 0, 2,
 	5, 3, 2, 4, 3, 5,
@@ -292,7 +293,7 @@ GLubyte boxIndices[] =
 	0, 3, 4, 0, 4, 7,
 	1, 2, 6, 2, 6, 5
 };
-GLfloat boxColors[] =
+static const GLfloat boxColors[] =
 {
 	1, 1, 0,
 	1, 0, 0,
@@ -304,15 +305,20 @@ GLfloat boxColors[] =
 	0, 1, 0
 };
 
+const TriangleMesh boxMesh = { boxVertices, boxIndices, 12 };
+const TriangleMesh pillarMesh = { pillarVertices, boxIndices, 12 };
+
 void drawBox()
 {
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	enableClientArray(GL_VERTEX_ARRAY);
+	enableClientArray(GL_COLOR_ARRAY);
 	glColorPointer(3, GL_FLOAT, 0, boxColors);
 	glVertexPointer(3, GL_FLOAT, 0, boxVertices);
 
 	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, boxIndices);
+	PROFILE_COUNT("drawCalls", 1);
+	PROFILE_COUNT("vertices", 36);
 
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
+	disableClientArray(GL_VERTEX_ARRAY);
+	disableClientArray(GL_COLOR_ARRAY);
 }
\ No newline at end of file
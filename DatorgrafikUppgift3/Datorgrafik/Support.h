@@ -12,9 +12,21 @@
 
 
 
+// Trianglarna i ett objekts eget rum, fr exakta strltrffar utan att lsa ngot frn GPU:n
+struct TriangleMesh
+{
+	const GLfloat *vertices;
+	const GLubyte *indices;
+	unsigned triangles;
+};
+
+extern const TriangleMesh floorMesh, pillarMesh, diamondMesh, boxMesh;
+
+
+
 void loadTexture(const char *file, GLuint *image);
-void drawFloor(GLuint texture);
-void drawPillars(GLuint texture);
+void drawFloor();			// Funktionerna ritar bara geometrin, tillstnd och textur stts av den som anropar
+void drawPillar();
 void drawDiamond();
 void drawBox();
 
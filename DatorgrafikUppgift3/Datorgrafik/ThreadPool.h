@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// En enkel trådpool med ett fast antal arbetartrådar som startas en gång.
+// parallelFor delar ut index 0..count-1 till trådarna (och den anropande
+// tråden) och returnerar först när alla är klara.
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned threads = 0);	// 0 betyder en tråd per kärna, minus den anropande
+	~ThreadPool();
+
+	void parallelFor(unsigned count, const std::function<void(unsigned)> &task);
+	unsigned size() const;				// Antal trådar som delar på arbetet, inklusive den anropande
+
+private:
+	void workerLoop();
+	void runTasks();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	const std::function<void(unsigned)> *task;
+	unsigned taskCount;
+	std::atomic<unsigned> nextTask;
+	unsigned busyWorkers;
+	unsigned generation;
+	bool quit;
+};
+
+
+
+#endif
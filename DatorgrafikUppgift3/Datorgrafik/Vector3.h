@@ -20,8 +20,8 @@
 template <typename T>
 class Vector3 {
  public:
-  Vector3();
-  Vector3(T newX, T newY, T newZ);
+  constexpr Vector3();
+  constexpr Vector3(T newX, T newY, T newZ);
   
   /**
    *  \brief Initializes this vector from an array of 3 values.
@@ -82,50 +82,54 @@ class Vector3 {
   T& x();
   T& y();
   T& z();
-  const T& x() const;
-  const T& y() const;
-  const T& z() const;
+  constexpr const T& x() const;
+  constexpr const T& y() const;
+  constexpr const T& z() const;
   
   T* data();
-  const T* data() const;
+  constexpr const T* data() const;
   
   T& operator[](unsigned int i);
-  const T& operator[](unsigned int i) const;
+  constexpr const T& operator[](unsigned int i) const;
   
   void normalize();
   Vector3<T> getNormalized() const;
   
-  Vector3<T> operator+() const;
-  Vector3<T> operator-() const;
+  constexpr Vector3<T> operator+() const;
+  constexpr Vector3<T> operator-() const;
   void operator/=(const T s);
   void operator*=(const T s);
   void operator+=(const Vector3<T>& v);
   void operator-=(const Vector3<T>& v);
+  void addScaled(const Vector3<T>& v, T s);
   
   T length() const;
-  T lengthSquared() const;
+  constexpr T lengthSquared() const;
   
-  T dotProduct(const Vector3<T>& v) const;
-  Vector3<T> crossProduct(const Vector3<T>& v) const;
+  constexpr T dotProduct(const Vector3<T>& v) const;
+  constexpr Vector3<T> crossProduct(const Vector3<T>& v) const;
   
  private:
   T m_vec[3];
 };
 
 template <typename T>
-const Vector3<T> operator/(const Vector3<T>& v, T s);
+constexpr Vector3<T> operator/(const Vector3<T>& v, T s);
 
 template <typename T>
-const Vector3<T> operator*(const Vector3<T>& v, T s);
+constexpr Vector3<T> operator*(const Vector3<T>& v, T s);
 
 template <typename T>
-const Vector3<T> operator*(T s, const Vector3<T>& v);
+constexpr Vector3<T> operator*(T s, const Vector3<T>& v);
 
 template <typename T>
-const Vector3<T> operator+(const Vector3<T>& v1, const Vector3<T>& v2);
+constexpr Vector3<T> operator+(const Vector3<T>& v1, const Vector3<T>& v2);
 
 template <typename T>
-const Vector3<T> operator-(const Vector3<T>& v1, const Vector3<T>& v2);
+constexpr Vector3<T> operator-(const Vector3<T>& v1, const Vector3<T>& v2);
+
+template <typename T>
+constexpr Vector3<T> madd(const Vector3<T>& v1, const Vector3<T>& v2, T s);
 
 
 typedef Vector3<float> Vector3f;
@@ -139,12 +143,9 @@ typedef Vector3<double> Vector3d;
  *  \brief Constructs a non-initialized vector.
  */
 template <typename T>
-inline 
-Vector3<T>::Vector3()
+constexpr Vector3<T>::Vector3()
+  : m_vec{static_cast<T>(0.0), static_cast<T>(0.0), static_cast<T>(0.0)}
 {
-  x() = static_cast<T>(0.0);
-  y() = static_cast<T>(0.0);
-  z() = static_cast<T>(0.0);
 }
 
 /**
@@ -154,12 +155,9 @@ Vector3<T>::Vector3()
  *  \param  newZ  The vector's third element.
  */
 template <typename T>
-inline 
-Vector3<T>::Vector3(T newX, T newY, T newZ)
+constexpr Vector3<T>::Vector3(T newX, T newY, T newZ)
+  : m_vec{newX, newY, newZ}
 {
-  x() = newX;
-  y() = newY;
-  z() = newZ;
 }
 
 /**
@@ -222,7 +220,7 @@ inline T& Vector3<T>::z()
  *  For a vector \a v, \a v.x() is equivalent to \a v[0].
  */
 template <typename T>
-inline const T& Vector3<T>::x() const
+constexpr const T& Vector3<T>::x() const
 {
   return m_vec[0];
 }
@@ -234,7 +232,7 @@ inline const T& Vector3<T>::x() const
  *  For a vector \a v, \a v.y() is equivalent to \a v[1].
  */
 template <typename T>
-inline const T& Vector3<T>::y() const
+constexpr const T& Vector3<T>::y() const
 {
   return m_vec[1];
 }
@@ -246,7 +244,7 @@ inline const T& Vector3<T>::y() const
  *  For a vector \a v, \a v.z() is equivalent to \a v[2].
  */
 template <typename T>
-inline const T& Vector3<T>::z() const
+constexpr const T& Vector3<T>::z() const
 {
   return m_vec[2];
 }
@@ -266,7 +264,7 @@ inline T* Vector3<T>::data()
  *  \return A constant pointer to the vector's array of elements.
  */
 template <typename T>
-inline const T* Vector3<T>::data() const
+constexpr const T* Vector3<T>::data() const
 {
   return m_vec;
 }
@@ -320,7 +318,7 @@ inline T& Vector3<T>::operator[](unsigned int i)
  *  \return A constant reference to the vector's element.
  */
 template <typename T>
-inline const T& Vector3<T>::operator[](unsigned int i) const
+constexpr const T& Vector3<T>::operator[](unsigned int i) const
 {
   return m_vec[i];
 }
@@ -345,7 +343,7 @@ inline T Vector3<T>::length() const
  * usually more efficient.
  */
 template <typename T>
-inline T Vector3<T>::lengthSquared() const
+constexpr T Vector3<T>::lengthSquared() const
 {
   return (x()*x() + y()*y() + z()*z());
 }
@@ -355,7 +353,7 @@ inline T Vector3<T>::lengthSquared() const
  *  \return A copy of this vector.
  */
 template <typename T>
-inline Vector3<T> Vector3<T>::operator+() const
+constexpr Vector3<T> Vector3<T>::operator+() const
 {
   return (*this);
 }
@@ -369,7 +367,7 @@ inline Vector3<T> Vector3<T>::operator+() const
  *  calculated as \f$ -v = (-x, -y, -z) \f$.
  */
 template <typename T>
-inline Vector3<T> Vector3<T>::operator-() const
+constexpr Vector3<T> Vector3<T>::operator-() const
 {
   return Vector3<T>(-x(), -y(), -z());
 }
@@ -422,6 +420,19 @@ inline void Vector3<T>::operator-=(const Vector3<T>& v)
   z() -= v.z();
 }
 
+/**
+ *  \brief Adds a scaled vector to this vector, i.e. \a v * \a s is added without creating a temporary vector.
+ *  \param  v  The vector to add to this vector.
+ *  \param  s  The scalar value \a v is multiplied with.
+ */
+template <typename T>
+inline void Vector3<T>::addScaled(const Vector3<T>& v, T s)
+{
+  x() += v.x() * s;
+  y() += v.y() * s;
+  z() += v.z() * s;
+}
+
 /**
  *  \brief Calculates the dot product of this and another vector.
  *  \param  v  The second vector.
@@ -435,7 +446,7 @@ inline void Vector3<T>::operator-=(const Vector3<T>& v)
  *  the dot product is \f$ \bar{u} \cdot \bar{v} = (u_1 v_1, u_2 v_2, u_3 v_3) \f$.
  */
 template <typename T>
-inline T Vector3<T>::dotProduct(const Vector3<T>& v) const
+constexpr T Vector3<T>::dotProduct(const Vector3<T>& v) const
 {
   return x() * v.x() + y() * v.y() + z() * v.z();
 }
@@ -455,7 +466,7 @@ inline T Vector3<T>::dotProduct(const Vector3<T>& v) const
  *  then \f$ \bar{u} \times \bar{v} \f$ is equal to the zero vector \f$ (0, 0, 0) \f$.
  */
 template <typename T>
-inline Vector3<T> Vector3<T>::crossProduct(const Vector3<T>& v) const
+constexpr Vector3<T> Vector3<T>::crossProduct(const Vector3<T>& v) const
 {
   return Vector3<T>(y() * v.z() - z() * v.y(), 
 		    z() * v.x() - x() * v.z(), 
@@ -476,7 +487,7 @@ inline Vector3<T> Vector3<T>::crossProduct(const Vector3<T>& v) const
  *  \return The result of dividing the vector with the scalar value.
  */
 template <typename T>
-inline const Vector3<T> operator/(const Vector3<T>& v, T s)
+constexpr Vector3<T> operator/(const Vector3<T>& v, T s)
 {
   return Vector3<T>(v.x() / s, v.y() / s, v.z() / s);
 }
@@ -488,7 +499,7 @@ inline const Vector3<T> operator/(const Vector3<T>& v, T s)
  *  \return The result of multiplying the vector with the scalar value.
  */
 template <typename T>
-inline const Vector3<T> operator*(const Vector3<T>& v, T s)
+constexpr Vector3<T> operator*(const Vector3<T>& v, T s)
 {
   return Vector3<T>(v.x() * s, v.y() * s, v.z() * s);
 }
@@ -500,7 +511,7 @@ inline const Vector3<T> operator*(const Vector3<T>& v, T s)
  *  \return The result of multiplying the scalar value with the vector.
  */
 template <typename T>
-inline const Vector3<T> operator*(T s, const Vector3<T>& v)
+constexpr Vector3<T> operator*(T s, const Vector3<T>& v)
 {
   return Vector3<T>(v.x() * s, v.y() * s, v.z() * s);
 }
@@ -512,7 +523,7 @@ inline const Vector3<T> operator*(T s, const Vector3<T>& v)
  *  \return The sum of the two vectors.
  */
 template <typename T>
-inline const Vector3<T> operator+(const Vector3<T>& v1, const Vector3<T>& v2)
+constexpr Vector3<T> operator+(const Vector3<T>& v1, const Vector3<T>& v2)
 {
   return Vector3<T>(v1.x() + v2.x(), v1.y() + v2.y(), v1.z() + v2.z());
 }
@@ -524,9 +535,23 @@ inline const Vector3<T> operator+(const Vector3<T>& v1, const Vector3<T>& v2)
  *  \return The result of subtracting the two vectors.
  */
 template <typename T>
-inline const Vector3<T> operator-(const Vector3<T>& v1, const Vector3<T>& v2)
+constexpr Vector3<T> operator-(const Vector3<T>& v1, const Vector3<T>& v2)
 {
   return Vector3<T>(v1.x() - v2.x(), v1.y() - v2.y(), v1.z() - v2.z());
 }
 
+/**
+ *  \brief Multiplies a vector with a scalar value and adds the result to another vector. This is the
+ *  same as \a v1 + \a v2 * \a s, but computed in one step without a temporary vector.
+ *  \param  v1  The vector to add to.
+ *  \param  v2  The vector to multiply.
+ *  \param  s  The scalar value.
+ *  \return The result of \a v1 + \a v2 * \a s.
+ */
+template <typename T>
+constexpr Vector3<T> madd(const Vector3<T>& v1, const Vector3<T>& v2, T s)
+{
+  return Vector3<T>(v1.x() + v2.x() * s, v1.y() + v2.y() * s, v1.z() + v2.z() * s);
+}
+
 #endif // VECTOR3_H
@@ -20,8 +20,8 @@ template <typename T>
 class Vector4 
 {
  public:
-  Vector4();
-  Vector4(T newX, T newY, T newZ, T newW);
+  constexpr Vector4();
+  constexpr Vector4(T newX, T newY, T newZ, T newW);
   /**
    *  \brief Initializes this vector from an array of 3 values.
    *  \param  v  A pointer to an array of 3 values of some arbitrary type \a U, which
@@ -35,7 +35,7 @@ class Vector4
       x() = v[0];
       y() = v[1];
       z() = v[2];
-      w() = v[4];
+      w() = v[3];
     }
   
   /**
@@ -53,12 +53,9 @@ class Vector4
       w() = v.w();
     }
 	template <typename U>
-	Vector4(const Vector3<U>& v, U newW)
+	constexpr Vector4(const Vector3<U>& v, U newW)
+		: m_vec{static_cast<T>(v.x()), static_cast<T>(v.y()), static_cast<T>(v.z()), static_cast<T>(newW)}
 	{
-		x() = v.x();
-		y() = v.y();
-		z() = v.z();
-		w() = newW;
 	}
   
   void assign(T newX, T newY, T newZ, T newW);
@@ -96,31 +93,32 @@ class Vector4
   T& y();
   T& z();
   T& w();
-  const T& x() const;
-  const T& y() const;
-  const T& z() const;
-  const T& w() const;
+  constexpr const T& x() const;
+  constexpr const T& y() const;
+  constexpr const T& z() const;
+  constexpr const T& w() const;
   
   T* data();
-  const T* data() const;
+  constexpr const T* data() const;
   
   T& operator[](unsigned int i);
-  const T& operator[](unsigned int i) const;
+  constexpr const T& operator[](unsigned int i) const;
   
   void normalize();
   Vector4<T> getNormalized() const;
   
-  const Vector4<T> operator+() const;
-  const Vector4<T> operator-() const;
+  constexpr Vector4<T> operator+() const;
+  constexpr Vector4<T> operator-() const;
   void operator/=(const T s);
   void operator*=(const T s);
   void operator+=(const Vector4<T>& v);
   void operator-=(const Vector4<T>& v);
+  void addScaled(const Vector4<T>& v, T s);
   
   T length() const;
-  T lengthSquared() const;
+  constexpr T lengthSquared() const;
   
-  T dotProduct(const Vector4<T>& v);
+  constexpr T dotProduct(const Vector4<T>& v) const;
   
   // ------- Variables -------
   
@@ -129,19 +127,22 @@ class Vector4
 };
 
 template <typename T>
-const Vector4<T> operator/(const Vector4<T>& v, T s);
+constexpr Vector4<T> operator/(const Vector4<T>& v, T s);
+
+template <typename T>
+constexpr Vector4<T> operator*(const Vector4<T>& v, T s);
 
 template <typename T>
-const Vector4<T> operator*(const Vector4<T>& v, T s);
+constexpr Vector4<T> operator*(T s, const Vector4<T>& v);
 
 template <typename T>
-const Vector4<T> operator*(T s, const Vector4<T>& v);
+constexpr Vector4<T> operator+(const Vector4<T>& v1, const Vector4<T>& v2);
 
 template <typename T>
-const Vector4<T> operator+(const Vector4<T>& v1, const Vector4<T>& v2);
+constexpr Vector4<T> operator-(const Vector4<T>& v1, const Vector4<T>& v2);
 
 template <typename T>
-const Vector4<T> operator-(const Vector4<T>& v1, const Vector4<T>& v2);
+constexpr Vector4<T> madd(const Vector4<T>& v1, const Vector4<T>& v2, T s);
 
 typedef Vector4<float> Vector4f;
 typedef Vector4<double> Vector4d;
@@ -154,12 +155,9 @@ typedef Vector4<double> Vector4d;
  *  \brief Constructs a non-initialized vector.
  */
 template <typename T>
-inline Vector4<T>::Vector4()
+constexpr Vector4<T>::Vector4()
+  : m_vec{static_cast<T>(0.0), static_cast<T>(0.0), static_cast<T>(0.0), static_cast<T>(0.0)}
 {
-  x() = static_cast<T>(0.0);
-  y() = static_cast<T>(0.0);
-  z() = static_cast<T>(0.0);
-  w() = static_cast<T>(0.0);
 }
 
 /**
@@ -170,12 +168,9 @@ inline Vector4<T>::Vector4()
  *  \param  newW  The vector's forth element
  */
 template <typename T>
-inline Vector4<T>::Vector4(T newX, T newY, T newZ, T newW)
+constexpr Vector4<T>::Vector4(T newX, T newY, T newZ, T newW)
+  : m_vec{newX, newY, newZ, newW}
 {
-  x() = newX;
-  y() = newY;
-  z() = newZ;
-  w() = newW;
 }
 
 /**
@@ -249,7 +244,7 @@ inline T& Vector4<T>::w()
  *  For a vector \a v, \a v.x() is equivalent to \a v[0].
  */
 template <typename T>
-inline const T& Vector4<T>::x() const
+constexpr const T& Vector4<T>::x() const
 {
   return m_vec[0];
 }
@@ -261,7 +256,7 @@ inline const T& Vector4<T>::x() const
  *  For a vector \a v, \a v.y() is equivalent to \a v[1].
  */
 template <typename T>
-inline const T& Vector4<T>::y() const
+constexpr const T& Vector4<T>::y() const
 {
   return m_vec[1];
 }
@@ -273,7 +268,7 @@ inline const T& Vector4<T>::y() const
  *  For a vector \a v, \a v.z() is equivalent to \a v[2].
  */
 template <typename T>
-inline const T& Vector4<T>::z() const
+constexpr const T& Vector4<T>::z() const
 {
   return m_vec[2];
 }
@@ -285,7 +280,7 @@ inline const T& Vector4<T>::z() const
  *  For a vector \a v, \a v.w() is equivalent to \a v[3].
  */
 template <typename T>
-inline const T& Vector4<T>::w() const
+constexpr const T& Vector4<T>::w() const
 {
   return m_vec[3];
 }
@@ -305,7 +300,7 @@ inline T* Vector4<T>::data()
  *  \return A constant pointer to the vector's array of elements.
  */
 template <typename T>
-inline const T* Vector4<T>::data() const
+constexpr const T* Vector4<T>::data() const
 {
   return m_vec;
 }
@@ -359,7 +354,7 @@ inline T& Vector4<T>::operator[](unsigned int i)
  *  \return A constant reference to the vector's element.
  */
 template <typename T>
-inline const T& Vector4<T>::operator[](unsigned int i) const
+constexpr const T& Vector4<T>::operator[](unsigned int i) const
 {
   return m_vec[i];
 }
@@ -384,8 +379,7 @@ inline T Vector4<T>::length() const
  * usually more efficient.
  */
 template <typename T>
-inline 
-T Vector4<T>::lengthSquared() const
+constexpr T Vector4<T>::lengthSquared() const
 {
   return (x()*x() + y()*y() + z()*z()+w()*w());
 }
@@ -395,8 +389,7 @@ T Vector4<T>::lengthSquared() const
  *  \return A copy of this vector.
  */
 template <typename T>
-inline 
-const Vector4<T> Vector4<T>::operator+() const
+constexpr Vector4<T> Vector4<T>::operator+() const
 {
   return (*this);
 }
@@ -410,7 +403,7 @@ const Vector4<T> Vector4<T>::operator+() const
  *  calculated as \f$ -v = (-x, -y, -z) \f$.
  */
 template <typename T>
-inline const Vector4<T> Vector4<T>::operator-() const
+constexpr Vector4<T> Vector4<T>::operator-() const
 {
   return Vector4<T>(-x(), -y(), -z(), -w());
 }
@@ -467,6 +460,20 @@ inline void Vector4<T>::operator-=(const Vector4<T>& v)
   w() -= v.w();
 }
 
+/**
+ *  \brief Adds a scaled vector to this vector, i.e. \a v * \a s is added without creating a temporary vector.
+ *  \param  v  The vector to add to this vector.
+ *  \param  s  The scalar value \a v is multiplied with.
+ */
+template <typename T>
+inline void Vector4<T>::addScaled(const Vector4<T>& v, T s)
+{
+  x() += v.x() * s;
+  y() += v.y() * s;
+  z() += v.z() * s;
+  w() += v.w() * s;
+}
+
 /**
  *  \brief Calculates the dot product of this and another vector.
  *  \param  v  The second vector.
@@ -480,7 +487,7 @@ inline void Vector4<T>::operator-=(const Vector4<T>& v)
  *  the dot product is \f$ \bar{u} \cdot \bar{v} = (u_1 v_1, u_2 v_2, u_3 v_3) \f$.
  */
 template <typename T>
-inline T Vector4<T>::dotProduct(const Vector4<T>& v)
+constexpr T Vector4<T>::dotProduct(const Vector4<T>& v) const
 {
   return x() * v.x() + y() * v.y() + z() * v.z() + w() * v.w();
 }
@@ -499,7 +506,7 @@ inline T Vector4<T>::dotProduct(const Vector4<T>& v)
  *  \return The result of dividing the vector with the scalar value.
  */
 template <typename T>
-inline const Vector4<T> operator/(const Vector4<T>& v, T s)
+constexpr Vector4<T> operator/(const Vector4<T>& v, T s)
 {
   return Vector4<T>(v.x() / s, v.y() / s, v.z() / s, v.w() / s);
 }
@@ -511,8 +518,7 @@ inline const Vector4<T> operator/(const Vector4<T>& v, T s)
  *  \return The result of multiplying the vector with the scalar value.
  */
 template <typename T>
-inline 
-const Vector4<T> operator*(const Vector4<T>& v, T s)
+constexpr Vector4<T> operator*(const Vector4<T>& v, T s)
 {
   return Vector4<T>(v.x() * s, v.y() * s, v.z() * s, v.w() * s);
 }
@@ -524,7 +530,7 @@ const Vector4<T> operator*(const Vector4<T>& v, T s)
  *  \return The result of multiplying the scalar value with the vector.
  */
 template <typename T>
-inline const Vector4<T> operator*(T s, const Vector4<T>& v)
+constexpr Vector4<T> operator*(T s, const Vector4<T>& v)
 {
   return Vector4<T>(v.x() * s, v.y() * s, v.z() * s, v.w() * s);
 }
@@ -536,7 +542,7 @@ inline const Vector4<T> operator*(T s, const Vector4<T>& v)
  *  \return The sum of the two vectors.
  */
 template <typename T>
-inline const Vector4<T> operator+(const Vector4<T>& v1, const Vector4<T>& v2)
+constexpr Vector4<T> operator+(const Vector4<T>& v1, const Vector4<T>& v2)
 {
   return Vector4<T>(v1.x() + v2.x(), v1.y() + v2.y(), v1.z() + v2.z(), v1.w()+v2.w());
 }
@@ -548,9 +554,23 @@ inline const Vector4<T> operator+(const Vector4<T>& v1, const Vector4<T>& v2)
  *  \return The result of subtracting the two vectors.
  */
 template <typename T>
-inline const Vector4<T> operator-(const Vector4<T>& v1, const Vector4<T>& v2)
+constexpr Vector4<T> operator-(const Vector4<T>& v1, const Vector4<T>& v2)
 {
   return Vector4<T>(v1.x() - v2.x(), v1.y() - v2.y(), v1.z() - v2.z(), v1.w() - v2.w());
 }
 
+/**
+ *  \brief Multiplies a vector with a scalar value and adds the result to another vector. This is the
+ *  same as \a v1 + \a v2 * \a s, but computed in one step without a temporary vector.
+ *  \param  v1  The vector to add to.
+ *  \param  v2  The vector to multiply.
+ *  \param  s  The scalar value.
+ *  \return The result of \a v1 + \a v2 * \a s.
+ */
+template <typename T>
+constexpr Vector4<T> madd(const Vector4<T>& v1, const Vector4<T>& v2, T s)
+{
+  return Vector4<T>(v1.x() + v2.x() * s, v1.y() + v2.y() * s, v1.z() + v2.z() * s, v1.w() + v2.w() * s);
+}
+
 #endif